@@ -25,6 +25,8 @@ NCL::CSC8503::Coursework::Coursework(bool isNetwork) : TutorialGame(false) {
 	world->GetMainCamera().SetFreeMode(false);
 	isNetworkGame = isNetwork;
 	isGameEnded = false;
+	//Held throwables would otherwise shove the player around
+	physics->SetLayerCollisions(GameObjectType::Player, GameObjectType::Throwable, false);
 	if (!isNetwork) {
 		InitCamera();
 		InitWorld();
@@ -97,13 +99,28 @@ void NCL::CSC8503::Coursework::InitWorldGrid() {
 	int gridSize = worldGrid->GetNavGridSize();
 
 	float cubeDimensions = gridSize / 2;
+
+	//Every wall is collided against through this one object, so the wall cubes are only there to be drawn
+	GameObject* walls = new GameObject("MazeWalls");
+	GridCollisionVolume* volume = new GridCollisionVolume(*worldGrid, OBSTACLE_TYPE_NODE);
+	walls->SetBoundingVolume((CollisionVolume*)volume);
+	walls->GetTransform().SetPosition(volume->GetGridCentre());
+	walls->SetPhysicsObject(new PhysicsObject(&walls->GetTransform(), walls->GetBoundingVolume()));
+	walls->GetPhysicsObject()->SetInverseMass(0.f);
+	walls->SetStaticGeometry(true);
+	world->AddGameObject(walls);
 	
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
 			GridNode& n = allNodes[(gridWidth * y) + x];
 			if ((char)n.type == OBSTACLE_TYPE_NODE)
 			{
-				AddCubeToWorld(Vector3(startPosX + (x * gridSize), -15, startPosZ + ( y * gridSize)), Vector3(cubeDimensions, cubeDimensions, cubeDimensions), 0.f);
+				GameObject* wall = new GameObject("MazeWall");
+				wall->GetTransform()
+					.SetPosition(Vector3(startPosX + (x * gridSize), -15, startPosZ + (y * gridSize)))
+					.SetScale(Vector3(cubeDimensions, cubeDimensions, cubeDimensions) * 2);
+				wall->SetRenderObject(new RenderObject(&wall->GetTransform(), cubeMesh, basicTex, basicShader));
+				world->AddGameObject(wall);
 			}
 			else if ((char)n.type == OBJECTIVE_TYPE_NODE) {
 				InitObjective(Vector3(startPosX + (x * gridSize), -15, startPosZ + (y * gridSize)));
@@ -139,6 +156,8 @@ void NCL::CSC8503::Coursework::SpawnThrowable(const Vector3& position) {
 	throwable->setLayer(Layer::Pickable);
 	throwable->SetGameObjectType(GameObjectType::Throwable);
 	throwable->GetRenderObject()->SetColour(Vector4(1,1,0,1));
+	//Thrown hard enough to pass through a wall in one step, so it's swept instead
+	throwable->GetPhysicsObject()->SetContinuousCollision(true);
 }
 void NCL::CSC8503::Coursework::InitObjective(const Vector3& position) {
 	auto* collectible = AddSphereToWorld(position, 3.f, 0.f);
@@ -135,11 +135,9 @@ void GameTechRenderer::BuildObjectList() {
 
 	gameWorld.OperateOnContents(
 		[&](GameObject* o) {
-			if (o->IsActive() && o->GetRenderObject()->GetVisibility()) {
-				const RenderObject* g = o->GetRenderObject();
-				if (g) {
-					activeObjects.emplace_back(g);
-				}
+			const RenderObject* g = o->GetRenderObject();
+			if (o->IsActive() && g && g->GetVisibility()) {
+				activeObjects.emplace_back(g);
 			}
 		}
 	);
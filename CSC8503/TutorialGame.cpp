@@ -8,6 +8,7 @@
 #include "OrientationConstraint.h"
 #include "StateGameObject.h"
 #include "CapsuleVolume.h"
+#include "ConvexHullVolume.h"
 
 
 
@@ -362,6 +363,7 @@ GameObject* TutorialGame::AddFloorToWorld(const Vector3& position) {
 
 	floor->GetPhysicsObject()->SetInverseMass(0);
 	floor->GetPhysicsObject()->InitCubeInertia();
+	floor->SetStaticGeometry(true);
 
 	world->AddGameObject(floor);
 
@@ -489,8 +491,9 @@ GameObject* TutorialGame::AddEnemyToWorld(const Vector3& position) {
 
 	GameObject* character = new GameObject();
 
-	AABBVolume* volume = new AABBVolume(Vector3(0.3f, 0.9f, 0.3f) * meshSize);
-	character->SetBoundingVolume((CollisionVolume*)volume);
+	//The keeper's own shape, rather than a box that sticks out past its arms and head
+	ConvexHullVolume* volume = new ConvexHullVolume(*enemyMesh, Vector3(meshSize, meshSize, meshSize));
+	character->SetBoundingVolume(volume);
 
 	character->GetTransform()
 		.SetScale(Vector3(meshSize, meshSize, meshSize))
@@ -3,9 +3,11 @@
 #include "AABBVolume.h"
 #include "OBBVolume.h"
 #include "SphereVolume.h"
+#include "GJK.h"
 #include "Window.h"
 #include "Maths.h"
 #include "Debug.h"
+#include <array>
 
 using namespace NCL;
 
@@ -43,6 +45,12 @@ bool CollisionDetection::RayIntersection(const Ray& r, GameObject& object, RayCo
 	case VolumeType::Sphere:	hasCollided = RaySphereIntersection(r, worldTransform, (const SphereVolume&)*volume, collision); break;
 
 	case VolumeType::Capsule:	hasCollided = RayCapsuleIntersection(r, worldTransform, (const CapsuleVolume&)*volume, collision); break;
+	case VolumeType::Grid:		hasCollided = RayGridIntersection(r, worldTransform, (const GridCollisionVolume&)*volume, collision); break;
+	case VolumeType::ConvexHull: {
+		//Rays only ever see the box around a hull
+		OBBVolume bounds(((const ConvexHullVolume&)*volume).GetHalfDimensions());
+		hasCollided = RayOBBIntersection(r, worldTransform, bounds, collision);
+	}break;
 	}
 
 	return hasCollided;
@@ -85,6 +93,26 @@ bool CollisionDetection::RayBoxIntersection(const Ray& r, const Vector3& boxPos,
 	return true;
 }
 
+bool CollisionDetection::RaySlabTest(const Vector3& rayPos, const Vector3& invDir, const Vector3& boxMin, const Vector3& boxMax, float maxDistance, float& tEnter) {
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+
+	for (int i = 0; i < 3; ++i) {
+		float t0 = (boxMin[i] - rayPos[i]) * invDir[i];
+		float t1 = (boxMax[i] - rayPos[i]) * invDir[i];
+		if (t0 > t1) {
+			std::swap(t0, t1);
+		}
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+		if (tMin > tMax) {
+			return false;
+		}
+	}
+	tEnter = tMin;
+	return true;
+}
+
 bool CollisionDetection::RayAABBIntersection(const Ray& r, const Transform& worldTransform, const AABBVolume& volume, RayCollision& collision) {
 	Vector3 boxPos = worldTransform.GetPosition();
 	Vector3 boxSize = volume.GetHalfDimensions();
@@ -111,10 +139,10 @@ bool CollisionDetection::RayOBBIntersection(const Ray& r, const Transform& world
 }
 
 bool CollisionDetection::RaySphereIntersection(const Ray& r, const Transform& worldTransform, const SphereVolume& volume, RayCollision& collision) {
+	return RaySphereTest(r, worldTransform.GetPosition(), volume.GetRadius(), collision);
+}
 
-	Vector3 spherePos = worldTransform.GetPosition();
-	float sphereRadius = volume.GetRadius();
-
+bool CollisionDetection::RaySphereTest(const Ray& r, const Vector3& spherePos, float sphereRadius, RayCollision& collision) {
 	Vector3 dir = (spherePos - r.GetPosition());
 
 	float sphereProj = Vector3::Dot(dir, r.GetDirection());
@@ -160,12 +188,75 @@ bool CollisionDetection::RayCapsuleIntersection(const Ray& r, const Transform& w
 
 	Vector3 spherePos = bottom + (capsuleDir * dot);
 
-	SphereVolume sphere(volume.GetRadius());
-	Transform t;
-	t.SetPosition(spherePos);
-	t.SetScale(Vector3(1, 1, 1) * volume.GetRadius());
+	return RaySphereTest(r, spherePos, volume.GetRadius(), collision);
+}
 
-	return RaySphereIntersection(r, t, sphere, collision);
+/*
+Walks the ray across the grid a cell at a time (Amanatides & Woo's DDA),
+working out how far along the ray the next column and row boundaries are,
+and stepping over whichever is nearer. Only the solid cells the ray passes
+over get a proper ray / box test, and the first one it hits is the closest.
+*/
+bool CollisionDetection::RayGridIntersection(const Ray& r, const Transform& worldTransform, const GridCollisionVolume& volume, RayCollision& collision) {
+	Vector3 gridPos		= worldTransform.GetPosition();
+	Vector3 halfSize	= volume.GetHalfDimensions();
+	Vector3 cellSize	= volume.GetCellHalfSize();
+
+	Vector3 rayPos	= r.GetPosition() - gridPos;
+	Vector3 rayDir	= r.GetDirection();
+	Vector3 invDir	= Vector3(1.0f / rayDir.x, 1.0f / rayDir.y, 1.0f / rayDir.z);
+
+	float tEnter;
+	if (!RaySlabTest(rayPos, invDir, -halfSize, halfSize, FLT_MAX, tEnter)) {
+		return false;
+	}
+	Vector3 start = rayPos + rayDir * tEnter;
+	int x = std::clamp(volume.GetCellX(start.x), 0, volume.GetWidth() - 1);
+	int z = std::clamp(volume.GetCellZ(start.z), 0, volume.GetDepth() - 1);
+
+	int stepX = rayDir.x > 0.0f ? 1 : -1;
+	int stepZ = rayDir.z > 0.0f ? 1 : -1;
+
+	//How far along the ray the next boundary is, and how far between boundaries
+	float size		= volume.GetCellSize();
+	float nextX		= FLT_MAX;
+	float nextZ		= FLT_MAX;
+	float deltaX	= FLT_MAX;
+	float deltaZ	= FLT_MAX;
+	if (rayDir.x != 0.0f) {
+		float boundary = volume.GetCellPosition(x, z).x + stepX * size * 0.5f;
+		nextX	= (boundary - rayPos.x) * invDir.x;
+		deltaX	= size * std::abs(invDir.x);
+	}
+	if (rayDir.z != 0.0f) {
+		float boundary = volume.GetCellPosition(x, z).z + stepZ * size * 0.5f;
+		nextZ	= (boundary - rayPos.z) * invDir.z;
+		deltaZ	= size * std::abs(invDir.z);
+	}
+	//Once the ray has gone over or under the blocks, there's nothing left to hit
+	float leaveY = FLT_MAX;
+	if (rayDir.y != 0.0f) {
+		leaveY = ((rayDir.y > 0.0f ? halfSize.y : -halfSize.y) - rayPos.y) * invDir.y;
+	}
+
+	while (x >= 0 && z >= 0 && x < volume.GetWidth() && z < volume.GetDepth()) {
+		if (volume.IsSolid(x, z) && RayBoxIntersection(r, gridPos + volume.GetCellPosition(x, z), cellSize, collision)) {
+			return true;
+		}
+		float cellExit = std::min(nextX, nextZ);
+		if (cellExit > leaveY) {
+			break;
+		}
+		if (nextX < nextZ) {
+			x		+= stepX;
+			nextX	+= deltaX;
+		}
+		else {
+			z		+= stepZ;
+			nextZ	+= deltaZ;
+		}
+	}
+	return false;
 }
 
 bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo) {
@@ -179,87 +270,113 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 	collisionInfo.a = a;
 	collisionInfo.b = b;
 
-	Transform& transformA = a->GetTransform();
-	Transform& transformB = b->GetTransform();
+	return VolumeIntersection(*volA, a->GetTransform(), *volB, b->GetTransform(), collisionInfo);
+}
 
-	VolumeType pairType = (VolumeType)((int)volA->type | (int)volB->type);
+namespace {
+	typedef CollisionDetection::CollisionInfo CollisionInfo;
 
-	//Two AABBs
-	if (pairType == VolumeType::AABB) {
-		return AABBIntersection((AABBVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
-	}
-	//Two Spheres
-	if (pairType == VolumeType::Sphere) {
-		return SphereIntersection((SphereVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	}
-	//Two OBBs
-	if (pairType == VolumeType::OBB) {
-		return OBBIntersection((OBBVolume&)*volA, transformA, (OBBVolume&)*volB, transformB, collisionInfo);
-	}
-	//Two Capsules
-	if (pairType == VolumeType::Capsule){
-		CapsuleIntersection((CapsuleVolume&)*volA, transformA, (CapsuleVolume&)*volB, transformB, collisionInfo);
+	//The tests take their real volume types, the table only knows about CollisionVolumes
+	template<class VolumeA, class VolumeB, bool(*Test)(const VolumeA&, const Transform&, const VolumeB&, const Transform&, CollisionInfo&)>
+	bool PairKernel(const CollisionVolume& volumeA, const Transform& transformA,
+		const CollisionVolume& volumeB, const Transform& transformB, CollisionInfo& collisionInfo) {
+		return Test((const VolumeA&)volumeA, transformA, (const VolumeB&)volumeB, transformB, collisionInfo);
 	}
 
-	//AABB vs OBB
-	if (volA->type == VolumeType::OBB && volB->type == VolumeType::AABB) {
-		AABBToOBBIntersection((OBBVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
-	}
-	if (volA->type == VolumeType::AABB && volB->type == VolumeType::OBB)
-	{
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		AABBToOBBIntersection((OBBVolume&)*volB, transformB, (AABBVolume&)*volA, transformA, collisionInfo);
-	}
-	//AABB vs Sphere pairs
-	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Sphere) {
-		return AABBSphereIntersection((AABBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	}
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return AABBSphereIntersection((AABBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
+	//For a pair that's the other way round to how Test wants it
+	template<class VolumeA, class VolumeB, bool(*Test)(const VolumeA&, const Transform&, const VolumeB&, const Transform&, CollisionInfo&)>
+	bool SwappedPairKernel(const CollisionVolume& volumeB, const Transform& transformB,
+		const CollisionVolume& volumeA, const Transform& transformA, CollisionInfo& collisionInfo) {
+		std::swap(collisionInfo.a, collisionInfo.b);
+		return Test((const VolumeA&)volumeA, transformA, (const VolumeB&)volumeB, transformB, collisionInfo);
 	}
 
-	//OBB vs sphere pairs
-	if (volA->type == VolumeType::OBB && volB->type == VolumeType::Sphere) {
-		return OBBSphereIntersection((OBBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	}
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::OBB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return OBBSphereIntersection((OBBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
+	bool NoPairKernel(const CollisionVolume&, const Transform&, const CollisionVolume&, const Transform&, CollisionInfo&) {
+		return false;
 	}
 
-	//Capsule vs other interactions
-	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::Sphere) {
-		return SphereCapsuleIntersection((CapsuleVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
-	}
-	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Capsule) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return SphereCapsuleIntersection((CapsuleVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
+	typedef std::array<CollisionDetection::PairTest, CollisionDetection::VolumeSlots * CollisionDetection::VolumeSlots> PairTable;
+
+	//Everything GJK can take
+	constexpr VolumeType ConvexTypes[] = {
+		VolumeType::AABB, VolumeType::OBB, VolumeType::Sphere, VolumeType::Capsule, VolumeType::ConvexHull
+	};
+
+	template<class VolumeA, class VolumeB, bool(*Test)(const VolumeA&, const Transform&, const VolumeB&, const Transform&, CollisionInfo&)>
+	constexpr void AddPair(PairTable& table, VolumeType a, VolumeType b) {
+		table[CollisionDetection::GetPairSlot(a, b)] = &PairKernel<VolumeA, VolumeB, Test>;
+		if (a != b) {
+			table[CollisionDetection::GetPairSlot(b, a)] = &SwappedPairKernel<VolumeA, VolumeB, Test>;
+		}
 	}
 
-	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::AABB) {
-		return AABBCapsuleIntersection((CapsuleVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
+	constexpr PairTable BuildPairTable() {
+		PairTable table{};
+		table.fill(&NoPairKernel);
+
+		AddPair<AABBVolume,		AABBVolume,		&CollisionDetection::AABBIntersection>			(table, VolumeType::AABB,	VolumeType::AABB);
+		AddPair<SphereVolume,	SphereVolume,	&CollisionDetection::SphereIntersection>		(table, VolumeType::Sphere, VolumeType::Sphere);
+		AddPair<OBBVolume,		OBBVolume,		&CollisionDetection::OBBIntersection>			(table, VolumeType::OBB,	VolumeType::OBB);
+		AddPair<CapsuleVolume,	CapsuleVolume,	&CollisionDetection::CapsuleIntersection>		(table, VolumeType::Capsule, VolumeType::Capsule);
+
+		AddPair<OBBVolume,		AABBVolume,		&CollisionDetection::AABBToOBBIntersection>		(table, VolumeType::OBB,	VolumeType::AABB);
+		AddPair<AABBVolume,		SphereVolume,	&CollisionDetection::AABBSphereIntersection>	(table, VolumeType::AABB,	VolumeType::Sphere);
+		AddPair<OBBVolume,		SphereVolume,	&CollisionDetection::OBBSphereIntersection>		(table, VolumeType::OBB,	VolumeType::Sphere);
+		AddPair<CapsuleVolume,	SphereVolume,	&CollisionDetection::SphereCapsuleIntersection>	(table, VolumeType::Capsule, VolumeType::Sphere);
+		AddPair<CapsuleVolume,	AABBVolume,		&CollisionDetection::AABBCapsuleIntersection>	(table, VolumeType::Capsule, VolumeType::AABB);
+
+		AddPair<GridCollisionVolume, CollisionVolume, &CollisionDetection::GridIntersection>	(table, VolumeType::Grid,	VolumeType::Sphere);
+		AddPair<GridCollisionVolume, CollisionVolume, &CollisionDetection::GridIntersection>	(table, VolumeType::Grid,	VolumeType::AABB);
+		AddPair<GridCollisionVolume, CollisionVolume, &CollisionDetection::GridIntersection>	(table, VolumeType::Grid,	VolumeType::Capsule);
+
+		for (VolumeType type : ConvexTypes) {
+			AddPair<CollisionVolume, CollisionVolume, &CollisionDetection::ConvexIntersection>	(table, VolumeType::ConvexHull, type);
+		}
+		AddPair<CollisionVolume, CollisionVolume, &CollisionDetection::ConvexIntersection>		(table, VolumeType::OBB,	VolumeType::Capsule);
+		return table;
 	}
-	if (volB->type == VolumeType::Capsule && volA->type == VolumeType::AABB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
-		return AABBCapsuleIntersection((CapsuleVolume&)*volB, transformB, (AABBVolume&)*volA, transformA, collisionInfo);
+
+	constexpr std::array<bool, CollisionDetection::VolumeSlots * CollisionDetection::VolumeSlots> BuildConvexTable() {
+		std::array<bool, CollisionDetection::VolumeSlots * CollisionDetection::VolumeSlots> table{};
+		for (VolumeType type : ConvexTypes) {
+			table[CollisionDetection::GetPairSlot(VolumeType::ConvexHull, type)] = true;
+			table[CollisionDetection::GetPairSlot(type, VolumeType::ConvexHull)] = true;
+		}
+		table[CollisionDetection::GetPairSlot(VolumeType::OBB, VolumeType::Capsule)] = true;
+		table[CollisionDetection::GetPairSlot(VolumeType::Capsule, VolumeType::OBB)] = true;
+		return table;
 	}
 
-	return false;
+	/*
+	Every pair of volume types gets its own entry, already knowing which way
+	round its test wants them - so picking a test is a single lookup rather
+	than working down a list of ifs. Pairs nothing can test just miss.
+	*/
+	constexpr PairTable pairTable = BuildPairTable();
+	constexpr auto		convexTable = BuildConvexTable();
+}
+
+CollisionDetection::PairTest CollisionDetection::GetPairTest(VolumeType typeA, VolumeType typeB) {
+	return pairTable[GetPairSlot(typeA, typeB)];
+}
+
+bool CollisionDetection::IsConvexPair(VolumeType typeA, VolumeType typeB) {
+	return convexTable[GetPairSlot(typeA, typeB)];
+}
+
+bool CollisionDetection::VolumeIntersection(const CollisionVolume& volumeA, const Transform& transformA,
+	const CollisionVolume& volumeB, const Transform& transformB, CollisionInfo& collisionInfo) {
+	collisionInfo.pointCount = 0;
+	return pairTable[GetPairSlot(volumeA.type, volumeB.type)](volumeA, transformA, volumeB, transformB, collisionInfo);
 }
 
 bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, const Vector3& halfSizeA, const Vector3& halfSizeB) {
 	Vector3 delta = posB - posA;
 	Vector3 totalSize = halfSizeA + halfSizeB;
 
-	if (abs(delta.x) < totalSize.x &&
-		abs(delta.y) < totalSize.y &&
-		abs(delta.z) < totalSize.z) {
+	if (std::abs(delta.x) < totalSize.x &&
+		std::abs(delta.y) < totalSize.y &&
+		std::abs(delta.z) < totalSize.z) {
 		return true;
 	}
 	return false;
@@ -268,23 +385,13 @@ bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, cons
 //AABB/AABB Collisions
 bool CollisionDetection::AABBIntersection(const AABBVolume& volumeA, const Transform& worldTransformA,
 	const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	return AABBPairTest(worldTransformA.GetPosition(), volumeA.GetHalfDimensions(), worldTransformB.GetPosition(), volumeB.GetHalfDimensions(), collisionInfo);
+}
 
-	Vector3 boxAPos = worldTransformA.GetPosition();
-	Vector3 boxBPos = worldTransformB.GetPosition();
-
-	Vector3 boxASize = volumeA.GetHalfDimensions();
-	Vector3 boxBSize = volumeB.GetHalfDimensions();
-
+bool CollisionDetection::AABBPairTest(const Vector3& boxAPos, const Vector3& boxASize, const Vector3& boxBPos, const Vector3& boxBSize, CollisionInfo& collisionInfo) {
 	bool overlap = AABBTest(boxAPos, boxBPos, boxASize, boxBSize);
 
 	if (overlap) {
-		static const Vector3 faces[6] =
-		{
-			Vector3(-1,0,0), Vector3(1,0,0),
-			Vector3(0, -1, 0), Vector3(0, 1, 0),
-			Vector3(0, 0, -1), Vector3(0, 0, 1)
-		};
-
 		Vector3 maxA = boxAPos + boxASize;
 		Vector3 minA = boxAPos - boxASize;
 
@@ -302,36 +409,70 @@ bool CollisionDetection::AABBIntersection(const AABBVolume& volumeA, const Trans
 		};
 
 		float penetration = FLT_MAX;
-		Vector3 bestAxis;
+		int bestFace = 0;
 
 		for (int i = 0; i < 6; i++) {
 			if (distances[i] < penetration) {
 				penetration = distances[i];
-				bestAxis = faces[i];
+				bestFace = i;
 			}
 		}
-
-		collisionInfo.AddContactPoint(Vector3(), Vector3(), bestAxis, penetration);
+		AddAABBContacts(boxAPos, boxASize, boxBPos, boxBSize, bestFace, penetration, collisionInfo);
 		return true;
 	}
 
 	return false;
 }
 
+/*
+The boxes touch over a rectangle across the collision axis - its corners,
+half way through the overlap, make up the contact points
+*/
+void CollisionDetection::AddAABBContacts(const Vector3& boxAPos, const Vector3& boxASize,
+	const Vector3& boxBPos, const Vector3& boxBSize, int face, float penetration, CollisionInfo& collisionInfo) {
+	static const Vector3 faces[6] =
+	{
+		Vector3(-1,0,0), Vector3(1,0,0),
+		Vector3(0, -1, 0), Vector3(0, 1, 0),
+		Vector3(0, 0, -1), Vector3(0, 0, 1)
+	};
+
+	Vector3 overlapMin = Vector3::Max(boxAPos - boxASize, boxBPos - boxBSize);
+	Vector3 overlapMax = Vector3::Min(boxAPos + boxASize, boxBPos + boxBSize);
+
+	int axis	= face / 2;
+	int axisU	= (axis + 1) % 3;
+	int axisV	= (axis + 2) % 3;
+
+	for (int i = 0; i < 4; ++i) {
+		Vector3 corner;
+		corner[axis]	= (overlapMin[axis] + overlapMax[axis]) * 0.5f;
+		corner[axisU]	= (i & 1) ? overlapMax[axisU] : overlapMin[axisU];
+		corner[axisV]	= (i & 2) ? overlapMax[axisV] : overlapMin[axisV];
+
+		collisionInfo.AppendContactPoint(corner - boxAPos, corner - boxBPos, faces[face], penetration);
+	}
+}
+
 //Sphere / Sphere Collision
 bool CollisionDetection::SphereIntersection(const SphereVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	return SpherePairTest(worldTransformA.GetPosition(), volumeA.GetRadius(), worldTransformB.GetPosition(), volumeB.GetRadius(), collisionInfo);
+}
 
-	float radii = volumeA.GetRadius() + volumeB.GetRadius();
-	Vector3 delta = worldTransformB.GetPosition() - worldTransformA.GetPosition();
+bool CollisionDetection::SpherePairTest(const Vector3& posA, float radiusA, const Vector3& posB, float radiusB, CollisionInfo& collisionInfo) {
+	float radii = radiusA + radiusB;
+	Vector3 delta = posB - posA;
 
-	float deltaLength = delta.Length();
+	//Only pay for the square root once we know they touch
+	float deltaSq = Vector3::Dot(delta, delta);
 
-	if (deltaLength < radii) {
+	if (deltaSq < radii * radii) {
+		float deltaLength = std::sqrt(deltaSq);
 		float penetration = (radii - deltaLength);
-		Vector3 normal = delta.Normalised();
-		Vector3 localA = normal * volumeA.GetRadius();
-		Vector3 localB = -normal * volumeB.GetRadius();
+		Vector3 normal = deltaLength > 0.0f ? delta / deltaLength : Vector3(0, 1, 0);
+		Vector3 localA = normal * radiusA;
+		Vector3 localB = -normal * radiusB;
 
 
 		collisionInfo.AddContactPoint(localA, localB, normal, penetration);
@@ -345,20 +486,24 @@ bool CollisionDetection::SphereIntersection(const SphereVolume& volumeA, const T
 //AABB - Sphere Collision
 bool CollisionDetection::AABBSphereIntersection(const AABBVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	Vector3 boxSize = volumeA.GetHalfDimensions();
-	Vector3 delta = worldTransformB.GetPosition() - worldTransformA.GetPosition();
+	return BoxSphereTest(worldTransformA.GetPosition(), volumeA.GetHalfDimensions(), worldTransformB.GetPosition(), volumeB.GetRadius(), collisionInfo);
+}
+
+bool CollisionDetection::BoxSphereTest(const Vector3& boxPos, const Vector3& boxSize, const Vector3& spherePos, float radius, CollisionInfo& collisionInfo) {
+	Vector3 delta = spherePos - boxPos;
 
 	Vector3 closestPointOnBox = Maths::Vector3::Clamp(delta, -boxSize, boxSize);
 
 	Vector3 localPoint = delta - closestPointOnBox;
-	float distance = localPoint.Length();
+	float distanceSq = Vector3::Dot(localPoint, localPoint);
 
-	if (distance < volumeB.GetRadius()) {
-		Vector3 collisionNormal = localPoint.Normalised();
-		float penetration = (volumeB.GetRadius() - distance);
+	if (distanceSq < radius * radius) {
+		float distance = std::sqrt(distanceSq);
+		Vector3 collisionNormal = distance > 0.0f ? localPoint / distance : Vector3();
+		float penetration = (radius - distance);
 
 		Vector3 localA = Vector3();
-		Vector3 localB = -collisionNormal * volumeB.GetRadius();
+		Vector3 localB = -collisionNormal * radius;
 
 		collisionInfo.AddContactPoint(localA, localB, collisionNormal, penetration);
 
@@ -398,128 +543,440 @@ bool  CollisionDetection::OBBSphereIntersection(const OBBVolume& volumeA, const
 	return false;
 }
 
+//The AABB is just an OBB that hasn't been rotated
 bool NCL::CollisionDetection::AABBToOBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA, const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	Transform tempTransform = worldTransformB;
-	tempTransform.SetPosition(worldTransformB.GetPosition());
-	tempTransform.SetOrientation(Quaternion(0.0f, 0.0f, 0.0f, 1.0f));
-	tempTransform.SetScale(worldTransformB.GetScale());
-
-	OBBVolume tempVolume = OBBVolume(volumeB.GetHalfDimensions());
-
-	bool tempCollided = OBBIntersection(volumeA, worldTransformA, tempVolume, tempTransform, collisionInfo);
-	if (tempCollided) {
-		collisionInfo.point.normal = -collisionInfo.point.normal;
-	}
-	return tempCollided;
+	return BoxPairTest(worldTransformA.GetPosition(), worldTransformA.GetOrientation(), volumeA.GetHalfDimensions(),
+		worldTransformB.GetPosition(), Quaternion(0.0f, 0.0f, 0.0f, 1.0f), volumeB.GetHalfDimensions(), collisionInfo);
 }
 
 bool CollisionDetection::AABBCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
 
-	Vector3 point = Maths::Vector3::Clamp(worldTransformA.GetPosition(), worldTransformB.GetPosition() - volumeB.GetHalfDimensions(), worldTransformB.GetPosition() + volumeB.GetHalfDimensions());
-
-	SphereVolume sphere(volumeA.GetRadius());
-	Transform sphereTransform;
-	sphereTransform.SetPosition(SpherePosFromCapsule(volumeA, worldTransformA, point));
-	sphereTransform.SetScale(Vector3(1, 1, 1) * volumeA.GetRadius());
+	Vector3 boxPos	= worldTransformB.GetPosition();
+	Vector3 boxSize = volumeB.GetHalfDimensions();
+	Vector3 point	= Maths::Vector3::Clamp(worldTransformA.GetPosition(), boxPos - boxSize, boxPos + boxSize);
 
-	bool collision = AABBSphereIntersection(volumeB, worldTransformB, sphere, sphereTransform, collisionInfo);
+	Vector3 spherePos = SpherePosFromCapsule(volumeA, worldTransformA, point);
+	if (!BoxSphereTest(boxPos, boxSize, spherePos, volumeA.GetRadius(), collisionInfo)) {
+		return false;
+	}
 	collisionInfo.point.normal = -collisionInfo.point.normal;
-	collisionInfo.point.localA = collisionInfo.point.localA + (sphereTransform.GetPosition() - worldTransformA.GetPosition());
-	return collision;
-	return false;
+	collisionInfo.point.localA = collisionInfo.point.localA + (spherePos - worldTransformA.GetPosition());
+	return true;
 }
 
 bool CollisionDetection::SphereCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
 
-	SphereVolume sphere(volumeA.GetRadius());
-	Transform sphereTransform;
-	sphereTransform.SetPosition(SpherePosFromCapsule(volumeA, worldTransformA, worldTransformB.GetPosition()));
-	sphereTransform.SetScale(Vector3(1, 1, 1) * volumeA.GetRadius());
-
-	bool collision = SphereIntersection(sphere, sphereTransform, volumeB, worldTransformB, collisionInfo);
-	collisionInfo.point.localA = collisionInfo.point.localA + (sphereTransform.GetPosition() - worldTransformA.GetPosition());
-	return collision;
+	Vector3 spherePos = SpherePosFromCapsule(volumeA, worldTransformA, worldTransformB.GetPosition());
+	if (!SpherePairTest(spherePos, volumeA.GetRadius(), worldTransformB.GetPosition(), volumeB.GetRadius(), collisionInfo)) {
+		return false;
+	}
+	collisionInfo.point.localA = collisionInfo.point.localA + (spherePos - worldTransformA.GetPosition());
+	return true;
 }
 
-bool CollisionDetection::OBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
-	const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	std::vector<Vector3> volumeAVertices = GetOBBVertices(volumeA, worldTransformA.GetPosition(), worldTransformA.GetOrientation());
-	std::vector<Vector3> volumeBVertices = GetOBBVertices(volumeB, worldTransformB.GetPosition(), worldTransformB.GetOrientation());
+/*
+The grid is tested as if every solid cell was its own AABB, but only the
+cells under the other object's bounding box are looked at - and those are
+found by dividing its position by the cell size, rather than by searching.
 
-	std::vector<Vector3> edgeNormals = GetEdgeNormals(worldTransformA.GetOrientation(), worldTransformB.GetOrientation());
+Faces shared by two solid cells are inside the wall, so contacts that would
+push out through one are thrown away. Otherwise anything sliding along a
+wall would catch on the seams between its cells.
+*/
+bool CollisionDetection::GridIntersection(const GridCollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	Vector3 gridPos		= worldTransformA.GetPosition();
+	Vector3 otherPos	= worldTransformB.GetPosition();
+	Vector3 cellSize	= volumeA.GetCellHalfSize();
+
+	Vector3 extents;
+	switch (volumeB.type) {
+		case VolumeType::Sphere: {
+			float r = ((const SphereVolume&)volumeB).GetRadius();
+			extents = Vector3(r, r, r);
+		}break;
+		case VolumeType::AABB: {
+			extents = ((const AABBVolume&)volumeB).GetHalfDimensions();
+		}break;
+		case VolumeType::Capsule: {
+			const CapsuleVolume& capsule = (const CapsuleVolume&)volumeB;
+			Vector3 axis = worldTransformB.GetOrientation() * Vector3(0, 1, 0) * (capsule.GetHalfHeight() - capsule.GetRadius());
+			float r = capsule.GetRadius();
+			extents = Vector3(std::abs(axis.x) + r, std::abs(axis.y) + r, std::abs(axis.z) + r);
+		}break;
+		default:
+			return false; //OBBs and meshes aren't supported yet
+	}
 
-	Vector3 overlapAxis;
-	float overlapMagnitude = FLT_MAX;
+	Vector3 local = otherPos - gridPos;
+	if (std::abs(local.y) >= cellSize.y + extents.y) {
+		return false;
+	}
+	int minX = std::max(volumeA.GetCellX(local.x - extents.x), 0);
+	int maxX = std::min(volumeA.GetCellX(local.x + extents.x), volumeA.GetWidth() - 1);
+	int minZ = std::max(volumeA.GetCellZ(local.z - extents.z), 0);
+	int maxZ = std::min(volumeA.GetCellZ(local.z + extents.z), volumeA.GetDepth() - 1);
+
+	for (int z = minZ; z <= maxZ; ++z) {
+		for (int x = minX; x <= maxX; ++x) {
+			if (!volumeA.IsSolid(x, z)) {
+				continue;
+			}
+			Vector3 cellPos		= volumeA.GetCellPosition(x, z);
+			Vector3 cellCentre	= gridPos + cellPos;
 
-	for (int i = 0; i < 15; i++) {
-		if (edgeNormals[i] == Vector3(0, 0, 0))
-			continue;
-		float minA = FLT_MAX;
-		float maxA = std::numeric_limits<float>::lowest();
+			CollisionInfo cellInfo;
+			cellInfo.pointCount = 0;
+			bool hit = false;
 
-		float minB = FLT_MAX;
-		float maxB = std::numeric_limits<float>::lowest();
+			if (volumeB.type == VolumeType::Sphere) {
+				hit = BoxSphereTest(cellCentre, cellSize, otherPos, ((const SphereVolume&)volumeB).GetRadius(), cellInfo);
+			}
+			else if (volumeB.type == VolumeType::AABB) {
+				hit = AABBPairTest(cellCentre, cellSize, otherPos, ((const AABBVolume&)volumeB).GetHalfDimensions(), cellInfo);
+			}
+			else {
+				//The capsule's closest sphere to this cell stands in for it, just like AABBCapsuleIntersection
+				const CapsuleVolume& capsule = (const CapsuleVolume&)volumeB;
+				Vector3 point = Maths::Vector3::Clamp(otherPos, cellCentre - cellSize, cellCentre + cellSize);
 
-		for (int j = 0; j < 8; j++) {
-			float projA = Vector3::Dot(edgeNormals[i], volumeAVertices[j]) / edgeNormals[i].Length();
-			float projB = Vector3::Dot(edgeNormals[i], volumeBVertices[j]) / edgeNormals[i].Length();
+				Vector3 spherePos = SpherePosFromCapsule(capsule, worldTransformB, point);
 
+				hit = BoxSphereTest(cellCentre, cellSize, spherePos, capsule.GetRadius(), cellInfo);
+				cellInfo.point.localB = cellInfo.point.localB + (spherePos - otherPos);
+			}
+			if (!hit) {
+				continue;
+			}
+			for (int i = 0; i < cellInfo.pointCount; ++i) {
+				const ContactPoint& p = cellInfo.GetContactPoint(i);
+
+				int faceX = x;
+				int faceZ = z;
+				if (std::abs(p.normal.x) >= std::abs(p.normal.z) && std::abs(p.normal.x) > std::abs(p.normal.y)) {
+					faceX += p.normal.x > 0.0f ? 1 : -1;
+				}
+				else if (std::abs(p.normal.z) > std::abs(p.normal.y)) {
+					faceZ += p.normal.z > 0.0f ? 1 : -1;
+				}
+				if ((faceX != x || faceZ != z) && volumeA.IsSolid(faceX, faceZ)) {
+					continue;
+				}
+				collisionInfo.AppendContactPoint(p.localA + cellPos, p.localB, p.normal, p.penetration);
+			}
+		}
+	}
+	return collisionInfo.pointCount > 0;
+}
 
-			minA = std::min(projA, minA);
-			maxA = std::max(projA, maxA);
+/*
+Spheres are swept exactly, by casting a ray against a sphere as big as both
+of them put together. Anything else is stepped along the part of the path
+where the sphere could be touching its box, half a radius at a time, and
+once a step touches the object the moment of contact is found by bisection
+- so anything the sphere would only clip by less than that is missed.
+*/
+bool CollisionDetection::SphereSweep(const Vector3& start, float radius, const Vector3& direction, float maxDistance,
+	GameObject& object, float& distance, Vector3& normal) {
+	const int	bisectionSteps	= 10;
+	const float	step			= std::max(radius * 0.5f, 0.001f);
 
-			minB = std::min(projB, minB);
-			maxB = std::max(projB, maxB);
+	const CollisionVolume* volume = object.GetBoundingVolume();
+	if (!volume) {
+		return false;
+	}
+	Vector3 objectPos = object.GetTransform().GetPosition();
+
+	if (volume->type == VolumeType::Sphere) {
+		float	radii		= radius + ((const SphereVolume&)*volume).GetRadius();
+		Vector3 toCentre	= objectPos - start;
+		float	proj		= Vector3::Dot(toCentre, direction);
+		float	distSq		= Vector3::Dot(toCentre, toCentre) - proj * proj;
+		if (distSq > radii * radii) {
+			return false;
 		}
+		float t = Vector3::Dot(toCentre, toCentre) <= radii * radii ? 0.0f : proj - std::sqrt(radii * radii - distSq);
+		if (t < 0.0f || t >= maxDistance) {
+			return false;
+		}
+		distance	= t;
+		normal		= start + direction * t - objectPos;
+		normal		= normal.Length() > 0.0f ? normal.Normalised() : -direction;
+		return true;
+	}
+
+	SphereVolume	sphere(radius);
+	Transform		sphereTransform;
+	CollisionInfo	info;
 
-		bool isOverlaping = (minA <= minB && minB <= maxA) || (minB <= minA && minA <= maxB);
-		if (!isOverlaping) {
+	//Normal ends up pointing from the object towards the sphere
+	auto touches = [&](float t, Vector3& touchNormal) {
+		sphereTransform.SetPosition(start + direction * t);
+		info.a = &object;
+		info.b = nullptr;
+		if (!VolumeIntersection(*volume, object.GetTransform(), (CollisionVolume&)sphere, sphereTransform, info)) {
 			return false;
 		}
-		if (std::min(maxB, maxA) - std::max(minB, minA) < overlapMagnitude) {
-			overlapMagnitude = std::min(maxB, maxA) - std::max(minB, minA);
-			overlapAxis = edgeNormals[i];
+		touchNormal = info.a == &object ? info.point.normal : -info.point.normal;
+		return true;
+	};
+
+	//The sphere can only touch the object while its centre is inside the object's box, grown by the radius
+	Vector3 halfSizes;
+	object.GetBroadphaseAABB(halfSizes);
+	Vector3 extent	= Vector3(radius, radius, radius);
+	Vector3 boxMin	= objectPos - halfSizes - extent;
+	Vector3 boxMax	= objectPos + halfSizes + extent;
+	Vector3 invDir	= Vector3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	float tEnter	= 0.0f;
+	float tExit		= maxDistance;
+	for (int axis = 0; axis < 3; ++axis) {
+		float t0 = (boxMin[axis] - start[axis]) * invDir[axis];
+		float t1 = (boxMax[axis] - start[axis]) * invDir[axis];
+		tEnter	= std::max(tEnter, std::min(t0, t1));
+		tExit	= std::min(tExit, std::max(t0, t1));
+	}
+	if (tEnter > tExit) {
+		return false;
+	}
+
+	float	clear	= tEnter;
+	float	t		= tEnter;
+	bool	found	= false;
+	while (true) {
+		if (touches(t, normal)) {
+			found = true;
+			break;
 		}
+		if (t >= tExit) {
+			break;
+		}
+		clear	= t;
+		t		= std::min(t + step, tExit);
+	}
+	if (!found) {
+		return false;
 	}
+	if (t > tEnter) {
+		for (int b = 0; b < bisectionSteps; ++b) {
+			float middle = (clear + t) * 0.5f;
+			Vector3 middleNormal;
+			if (touches(middle, middleNormal)) {
+				t		= middle;
+				normal	= middleNormal;
+			}
+			else {
+				clear = middle;
+			}
+		}
+	}
+	distance = t;
+	return true;
+}
 
-	collisionInfo.AddContactPoint(Vector3(), Vector3(), overlapAxis, overlapMagnitude);
+/*
+GJK picks up from wherever it finished last step if the pair has a cache,
+so objects resting on each other only take an iteration or two. The contact
+points are handed back relative to each object the same way the solver
+expects them - unrotated by the object's orientation.
+*/
+bool CollisionDetection::ConvexIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+	const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	ConvexShape shapeA(volumeA, worldTransformA);
+	ConvexShape shapeB(volumeB, worldTransformB);
+
+	GJKContact contact;
+	if (!GJK::Intersect(shapeA, shapeB, collisionInfo.convexCache, contact)) {
+		return false;
+	}
+	Vector3 localA = worldTransformA.GetOrientation().Conjugate() * (contact.pointA - worldTransformA.GetPosition());
+	Vector3 localB = worldTransformB.GetOrientation().Conjugate() * (contact.pointB - worldTransformB.GetPosition());
+
+	collisionInfo.AddContactPoint(localA, localB, contact.normal, contact.penetration);
 	return true;
 }
 
-bool NCL::CollisionDetection::CapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA, const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	// Step 1: Check for AABB intersection (Custom AABB approximation)
-	Vector3 halfDimensionsA(volumeA.GetRadius(), volumeA.GetHalfHeight() + volumeA.GetRadius(), volumeA.GetRadius());
-	Vector3 halfDimensionsB(volumeB.GetRadius(), volumeB.GetHalfHeight() + volumeB.GetRadius(), volumeB.GetRadius());
+bool CollisionDetection::OBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
+	const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	return BoxPairTest(worldTransformA.GetPosition(), worldTransformA.GetOrientation(), volumeA.GetHalfDimensions(),
+		worldTransformB.GetPosition(), worldTransformB.GetOrientation(), volumeB.GetHalfDimensions(), collisionInfo);
+}
 
-	AABBVolume aabbA(halfDimensionsA);
-	AABBVolume aabbB(halfDimensionsB);
+/*
+Separating axis test between two boxes, using each box's projected radius
+rather than projecting all of its corners. With every axis written in terms
+of box A's, the dot products between the two boxes' axes (R below) are all
+that's needed for the 15 axes, and the edge / edge axes are never built
+unless they turn out to be the one with the least overlap.
+
+The normal points from A to B, the same as every other test.
+*/
+bool CollisionDetection::BoxPairTest(const Vector3& posA, const Quaternion& orientationA, const Vector3& halfSizeA,
+	const Vector3& posB, const Quaternion& orientationB, const Vector3& halfSizeB, CollisionInfo& collisionInfo) {
+	//Stops nearly parallel edges giving a cross product of noise
+	const float parallelEpsilon = 1e-5f;
+
+	Matrix3 rotA(orientationA);
+	Matrix3 rotB(orientationB);
+	const Vector3 axesA[3] = { rotA.GetColumn(0), rotA.GetColumn(1), rotA.GetColumn(2) };
+	const Vector3 axesB[3] = { rotB.GetColumn(0), rotB.GetColumn(1), rotB.GetColumn(2) };
+	const float	  a[3] = { halfSizeA.x, halfSizeA.y, halfSizeA.z };
+	const float	  b[3] = { halfSizeB.x, halfSizeB.y, halfSizeB.z };
+
+	Vector3 delta = posB - posA;
+
+	float R[3][3];
+	float absR[3][3];
+	float t[3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			R[i][j]		= Vector3::Dot(axesA[i], axesB[j]);
+			absR[i][j]	= std::abs(R[i][j]);
+		}
+		t[i] = Vector3::Dot(delta, axesA[i]);
+	}
+
+	float	bestOverlap = FLT_MAX;
+	int		bestAxis	= -1;
+	float	bestSign	= 1.0f;
+
+	//0-2 are A's faces, 3-5 B's, and 6-14 the edge pairs, which need dividing by their length
+	auto testAxis = [&](int axis, float radii, float distance, float length) {
+		float overlap = (radii - std::abs(distance)) / length;
+		if (overlap < 0.0f) {
+			return false;
+		}
+		if (overlap < bestOverlap) {
+			bestOverlap = overlap;
+			bestAxis	= axis;
+			bestSign	= distance < 0.0f ? -1.0f : 1.0f;
+		}
+		return true;
+	};
 
-	bool aabbCollision = AABBCapsuleIntersection(volumeA, worldTransformA, aabbB, worldTransformB, collisionInfo);
+	for (int i = 0; i < 3; ++i) {
+		float radiusB = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+		if (!testAxis(i, a[i] + radiusB, t[i], 1.0f)) {
+			return false;
+		}
+	}
+	for (int j = 0; j < 3; ++j) {
+		float radiusA	= a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+		float distance	= t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+		if (!testAxis(3 + j, radiusA + b[j], distance, 1.0f)) {
+			return false;
+		}
+	}
+	for (int i = 0; i < 3; ++i) {
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; ++j) {
+			float length = std::sqrt(std::max(1.0f - R[i][j] * R[i][j], 0.0f));
+			if (length < parallelEpsilon) {
+				continue; //Parallel edges, which a face axis has already covered
+			}
+			int j1 = (j + 1) % 3;
+			int j2 = (j + 2) % 3;
+			float radiusA	= a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+			float radiusB	= b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+			float distance	= t[i2] * R[i1][j] - t[i1] * R[i2][j];
+			if (!testAxis(6 + i * 3 + j, radiusA + radiusB, distance, length)) {
+				return false;
+			}
+		}
+	}
 
-	if (aabbCollision) {
-		// Step 2: Check for Sphere intersection
-		SphereVolume sphereA(volumeA.GetRadius());
-		Transform sphereTransformA;
-		sphereTransformA.SetPosition(SpherePosFromCapsule(volumeA, worldTransformA, worldTransformB.GetPosition()));
-		sphereTransformA.SetScale(Vector3(1, 1, 1) * volumeA.GetRadius());
+	Vector3 normal;
+	if (bestAxis < 3) {
+		normal = axesA[bestAxis];
+	}
+	else if (bestAxis < 6) {
+		normal = axesB[bestAxis - 3];
+	}
+	else {
+		int edge = bestAxis - 6;
+		normal = Vector3::Cross(axesA[edge / 3], axesB[edge % 3]).Normalised();
+	}
+	collisionInfo.AddContactPoint(Vector3(), Vector3(), normal * bestSign, bestOverlap);
+	return true;
+}
 
-		SphereVolume sphereB(volumeB.GetRadius());
-		Transform sphereTransformB;
-		sphereTransformB.SetPosition(SpherePosFromCapsule(volumeB, worldTransformB, worldTransformA.GetPosition()));
-		sphereTransformB.SetScale(Vector3(1, 1, 1) * volumeB.GetRadius());
+/*
+The closest points between the two capsules' inner line segments are where
+they'd touch first, so the capsules can be tested as two spheres sat there.
+This finds more hits than the old test did, on purpose - that took the
+point on each segment nearest the other capsule's centre, which misses
+capsules crossing each other away from their middles.
+*/
+bool NCL::CollisionDetection::CapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA, const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	Vector3 posA	= worldTransformA.GetPosition();
+	Vector3 posB	= worldTransformB.GetPosition();
+	Vector3 extentA = worldTransformA.GetOrientation() * Vector3(0, 1, 0) * (volumeA.GetHalfHeight() - volumeA.GetRadius());
+	Vector3 extentB = worldTransformB.GetOrientation() * Vector3(0, 1, 0) * (volumeB.GetHalfHeight() - volumeB.GetRadius());
 
-		bool sphereCollision = SphereIntersection(sphereA, sphereTransformA, sphereB, sphereTransformB, collisionInfo);
-		collisionInfo.point.localA = collisionInfo.point.localA + (sphereTransformA.GetPosition() - worldTransformA.GetPosition());
-		collisionInfo.point.localB = collisionInfo.point.localB + (sphereTransformB.GetPosition() - worldTransformB.GetPosition());
+	Vector3 closestA;
+	Vector3 closestB;
+	ClosestPointsOnSegments(posA - extentA, posA + extentA, posB - extentB, posB + extentB, closestA, closestB);
 
-		return sphereCollision;
+	if (!SpherePairTest(closestA, volumeA.GetRadius(), closestB, volumeB.GetRadius(), collisionInfo)) {
+		return false;
 	}
+	collisionInfo.point.localA = collisionInfo.point.localA + (closestA - posA);
+	collisionInfo.point.localB = collisionInfo.point.localB + (closestB - posB);
+	return true;
+}
 
-	return false;
+/*
+Ericson's closest points between segments (Real-Time Collision Detection
+5.1.9): find the closest points on the two infinite lines, then clamp them
+back onto the segments, redoing the other one each time one is clamped.
+*/
+void CollisionDetection::ClosestPointsOnSegments(const Vector3& startA, const Vector3& endA,
+	const Vector3& startB, const Vector3& endB, Vector3& closestA, Vector3& closestB) {
+	const float epsilon = 1e-6f;
+
+	Vector3 dirA	= endA - startA;
+	Vector3 dirB	= endB - startB;
+	Vector3 between = startA - startB;
+	float lengthSqA = Vector3::Dot(dirA, dirA);
+	float lengthSqB = Vector3::Dot(dirB, dirB);
+	float f			= Vector3::Dot(dirB, between);
+
+	float s = 0.0f;
+	float t = 0.0f;
+	if (lengthSqA <= epsilon && lengthSqB <= epsilon) {
+		//Both are really just points
+	}
+	else if (lengthSqA <= epsilon) {
+		t = Maths::Clamp(f / lengthSqB, 0.0f, 1.0f);
+	}
+	else {
+		float c = Vector3::Dot(dirA, between);
+		if (lengthSqB <= epsilon) {
+			s = Maths::Clamp(-c / lengthSqA, 0.0f, 1.0f);
+		}
+		else {
+			float b		= Vector3::Dot(dirA, dirB);
+			float denom = lengthSqA * lengthSqB - b * b;
+
+			s = denom > 0.0f ? Maths::Clamp((b * f - c * lengthSqB) / denom, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / lengthSqB;
+			if (t < 0.0f) {
+				t = 0.0f;
+				s = Maths::Clamp(-c / lengthSqA, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f) {
+				t = 1.0f;
+				s = Maths::Clamp((b - c) / lengthSqA, 0.0f, 1.0f);
+			}
+		}
+	}
+	closestA = startA + dirA * s;
+	closestB = startB + dirB * t;
 }
 
 Matrix4 GenerateInverseView(const Camera& c) {
@@ -589,50 +1046,6 @@ Vector3 CollisionDetection::Unproject(const Vector3& screenPos, const Perspectiv
 	return Vector3(transformed.x / transformed.w, transformed.y / transformed.w, transformed.z / transformed.w);
 }
 
-std::vector<Vector3> NCL::CollisionDetection::GetEdgeNormals(const Quaternion& orientationA, const Quaternion& orientationB)
-{
-	std::vector<Vector3> edges;
-
-	edges.push_back(orientationA * Vector3(1, 0, 0)); //Principal x asix object A
-	edges.push_back(orientationA * Vector3(0, 1, 0)); //Principal y asix object A
-	edges.push_back(orientationA * Vector3(0, 0, 1)); //Principal z asix object A
-
-	edges.push_back(orientationB * Vector3(1, 0, 0)); //Principal x asix object B
-	edges.push_back(orientationB * Vector3(0, 1, 0)); //Principal y asix object B
-	edges.push_back(orientationB * Vector3(0, 0, 1)); //Principal z asix object B
-
-	for (int j = 0; j < 3; ++j) {
-		for (int k = 3; k < 6; ++k) {
-			edges.push_back(Vector3::Cross(edges[j], edges[k]).Normalised()); //Normalixed world axis
-		}
-	}
-	return edges;
-}
-
-std::vector<Vector3> NCL::CollisionDetection::GetOBBVertices(const OBBVolume& volume, const Vector3& position, const Quaternion& orientation) {
-	std::vector<Vector3> vertices;
-
-	Vector3 halfDimensions = volume.GetHalfDimensions();
-	vertices.push_back(Vector3(-halfDimensions.x, -halfDimensions.y, -halfDimensions.z));
-	vertices.push_back(Vector3(halfDimensions.x, -halfDimensions.y, -halfDimensions.z));
-	vertices.push_back(Vector3(halfDimensions.x, halfDimensions.y, -halfDimensions.z));
-	vertices.push_back(Vector3(-halfDimensions.x, halfDimensions.y, -halfDimensions.z));
-	vertices.push_back(Vector3(-halfDimensions.x, -halfDimensions.y, halfDimensions.z));
-	vertices.push_back(Vector3(halfDimensions.x, -halfDimensions.y, halfDimensions.z));
-	vertices.push_back(Vector3(halfDimensions.x, halfDimensions.y, halfDimensions.z));
-	vertices.push_back(Vector3(-halfDimensions.x, halfDimensions.y, halfDimensions.z));
-
-	for (int i = 0; i < 8; i++) {
-		vertices[i] = orientation * vertices[i];
-	}
-
-	for (int i = 0; i < 8; i++) {
-		vertices[i] += position;
-	}
-
-	return vertices;
-}
-
 Vector3 NCL::CollisionDetection::CalculateWorldOrientation(const Transform& worldTransform, const Vector3& localDirection) {
 	return worldTransform.GetOrientation() * localDirection;
 }
@@ -9,11 +9,18 @@
 #include "OBBVolume.h"
 #include "SphereVolume.h"
 #include "CapsuleVolume.h"
+#include "GridCollisionVolume.h"
+#include "ConvexHullVolume.h"
 #include "Ray.h"
 
+#include <bit>
+
 using NCL::Camera;
 using namespace NCL::Maths;
 using namespace NCL::CSC8503;
+namespace NCL::CSC8503 {
+	struct GJKCache;
+}
 namespace NCL {
 	class CollisionDetection
 	{
@@ -25,21 +32,44 @@ namespace NCL {
 			float	penetration;
 		};
 		struct CollisionInfo {
+			static const int MaxContactPoints = 4;
+
 			GameObject* a;
 			GameObject* b;		
 			int		framesLeft;
 
-			ContactPoint point;
+			ContactPoint point;		//The first contact point, which is all most tests give us
+			ContactPoint extraPoints[MaxContactPoints - 1];
+			int			 pointCount = 0;
+
+			GJKCache*	 convexCache = nullptr;	//Where GJK can pick up from last step, for pairs that use it
 
 			CollisionInfo() {
 
 			}
 
+			//Replaces any contact points we already had
 			void AddContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p) {
 				point.localA		= localA;
 				point.localB		= localB;
 				point.normal		= normal;
 				point.penetration	= p;
+				pointCount			= 1;
+			}
+
+			//For tests that can find a whole contact area, rather than one point
+			void AppendContactPoint(const Vector3& localA, const Vector3& localB, const Vector3& normal, float p) {
+				if (pointCount == 0) {
+					AddContactPoint(localA, localB, normal, p);
+				}
+				else if (pointCount < MaxContactPoints) {
+					extraPoints[pointCount - 1] = { localA, localB, normal, p };
+					pointCount++;
+				}
+			}
+
+			const ContactPoint& GetContactPoint(int i) const {
+				return i == 0 ? point : extraPoints[i - 1];
 			}
 
 			//Advanced collision detection / resolution
@@ -83,14 +113,41 @@ namespace NCL {
 		static bool RayOBBIntersection(const Ray&r, const Transform& worldTransform, const OBBVolume&	volume, RayCollision& collision);
 		static bool RaySphereIntersection(const Ray&r, const Transform& worldTransform, const SphereVolume& volume, RayCollision& collision);
 		static bool RayCapsuleIntersection(const Ray& r, const Transform& worldTransform, const CapsuleVolume& volume, RayCollision& collision);
+		static bool RayGridIntersection(const Ray& r, const Transform& worldTransform, const GridCollisionVolume& volume, RayCollision& collision);
 
 
 		static bool RayPlaneIntersection(const Ray&r, const Plane&p, RayCollision& collisions);
 
+		//Slab test for spatial structures - takes the ray's reciprocal direction so it can be computed once per ray
+		static bool RaySlabTest(const Vector3& rayPos, const Vector3& invDir, const Vector3& boxMin, const Vector3& boxMax, float maxDistance, float& tEnter);
+
 		static bool	AABBTest(const Vector3& posA, const Vector3& posB, const Vector3& halfSizeA, const Vector3& halfSizeB);
 
 
 		static bool ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo);
+		//The same, for volumes that don't belong to an object (ie the shape of a query)
+		static bool VolumeIntersection(const CollisionVolume& volumeA, const Transform& transformA,
+			const CollisionVolume& volumeB, const Transform& transformB, CollisionInfo& collisionInfo);
+
+		/*
+		Tests are picked from a table, with a slot for every ordered pair of
+		volume types. Each VolumeType is a single bit, so its slot is just
+		which bit - anything past ConvexHull shares the last one.
+		*/
+		typedef bool(*PairTest)(const CollisionVolume& volumeA, const Transform& transformA,
+			const CollisionVolume& volumeB, const Transform& transformB, CollisionInfo& collisionInfo);
+
+		static constexpr int VolumeSlots = 9;
+
+		static constexpr int GetVolumeSlot(VolumeType type) {
+			return std::min(std::countr_zero((unsigned int)type), VolumeSlots - 1);
+		}
+		static constexpr int GetPairSlot(VolumeType typeA, VolumeType typeB) {
+			return GetVolumeSlot(typeA) * VolumeSlots + GetVolumeSlot(typeB);
+		}
+		static PairTest GetPairTest(VolumeType typeA, VolumeType typeB);
+		//Whether a pair is tested with GJK, and so is worth giving a cache to
+		static bool IsConvexPair(VolumeType typeA, VolumeType typeB);
 
 
 		static bool AABBIntersection(	const AABBVolume& volumeA, const Transform& worldTransformA,
@@ -113,9 +170,37 @@ namespace NCL {
 
 		static bool AABBToOBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
 			const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		//Spheres, AABBs and capsules against every solid cell of a grid they overlap
+		static bool GridIntersection(const GridCollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		//Any two convex volumes, with GJK / EPA - for the pairs that have nothing quicker
+		static bool ConvexIntersection(const CollisionVolume& volumeA, const Transform& worldTransformA,
+			const CollisionVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 		
-		static std::vector<Vector3> GetEdgeNormals(const Quaternion& orientationA, const Quaternion& orientationB);
-		static std::vector<Vector3> GetOBBVertices(const OBBVolume& volume, const Vector3& position, const Quaternion& orientation);
+
+		//The tests above come down to these, which work straight from positions and sizes - so
+		//a test made of other tests (capsules, grid cells) never needs a temporary Transform
+		static bool SpherePairTest(const Vector3& posA, float radiusA, const Vector3& posB, float radiusB, CollisionInfo& collisionInfo);
+		static bool BoxSphereTest(const Vector3& boxPos, const Vector3& boxSize, const Vector3& spherePos, float radius, CollisionInfo& collisionInfo);
+		static bool AABBPairTest(const Vector3& boxAPos, const Vector3& boxASize, const Vector3& boxBPos, const Vector3& boxBSize, CollisionInfo& collisionInfo);
+		static bool BoxPairTest(const Vector3& posA, const Quaternion& orientationA, const Vector3& halfSizeA,
+			const Vector3& posB, const Quaternion& orientationB, const Vector3& halfSizeB, CollisionInfo& collisionInfo);
+		static bool RaySphereTest(const Ray& r, const Vector3& spherePos, float radius, RayCollision& collision);
+
+		//How far a sphere can move along direction (normalised) before it touches the object, and the
+		//object's normal where it does. Used by GameWorld::SweepSphere, and to stop fast bodies tunnelling
+		static bool SphereSweep(const Vector3& start, float radius, const Vector3& direction, float maxDistance,
+			GameObject& object, float& distance, Vector3& normal);
+
+		//The contact points for two AABBs, once it's known which of A's faces (-x, +x, -y, +y, -z, +z) they touch through
+		static void AddAABBContacts(const Vector3& boxAPos, const Vector3& boxASize,
+			const Vector3& boxBPos, const Vector3& boxBSize, int face, float penetration, CollisionInfo& collisionInfo);
+
+		static void ClosestPointsOnSegments(const Vector3& startA, const Vector3& endA,
+			const Vector3& startB, const Vector3& endB, Vector3& closestA, Vector3& closestB);
+
 		static Vector3 Unproject(const Vector3& screenPos, const PerspectiveCamera& cam);
 
 		static Vector3 CalculateWorldOrientation(const Transform& worldTransform, const Vector3& localDirection);
@@ -7,6 +7,8 @@ namespace NCL {
 		Mesh	= 8,
 		Capsule = 16,
 		Compound= 32,
+		Grid	= 64,
+		ConvexHull = 128,
 		Invalid = 256
 	};
 
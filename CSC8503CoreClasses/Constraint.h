@@ -2,12 +2,20 @@
 
 namespace NCL {
 	namespace CSC8503 {
+		class GameObject;
+
 		class Constraint	{
 		public:
 			Constraint() {}
 			virtual ~Constraint() {}
 
 			virtual void UpdateConstraint(float dt) = 0;
+
+			//Lets the physics system join constrained objects into one island
+			virtual void GetConstrainedObjects(GameObject*& a, GameObject*& b) const {
+				a = nullptr;
+				b = nullptr;
+			}
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "ConstraintSolver.h"
+#include "PositionConstraint.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include <algorithm>
+#include <bit>
+
+using namespace NCL;
+using namespace Maths;
+using namespace CSC8503;
+
+namespace {
+	//One bit per colour in each body's used colour mask
+	const int MaxColours = 64;
+}
+
+void ConstraintSolver::Clear() {
+	builtState = -1;
+	bodyObjects.clear();
+	linkBodyA.clear();
+	linkBodyB.clear();
+	linkDistance.clear();
+	linkActive.clear();
+	colourStarts.clear();
+	serialColour = -1;
+	otherConstraints.clear();
+}
+
+/*
+Greedy colouring - each link takes the lowest colour that neither of its
+bodies has been given yet. Chains and ropes come out as two colours, and
+even a dense ragdoll only needs as many colours as its busiest body has
+constraints. If a body somehow has more than 64, the rest of its links go
+into an extra colour that is solved on one thread.
+*/
+void ConstraintSolver::Build(ConstraintIterator first, ConstraintIterator last, int stateID) {
+	if (stateID == builtState) {
+		return;
+	}
+	Clear();
+	builtState = stateID;
+
+	std::map<GameObject*, int>	bodyIndices;
+	std::vector<uint64_t>		usedColours;
+	std::vector<int>			tempA;
+	std::vector<int>			tempB;
+	std::vector<float>			tempDistance;
+	std::vector<int>			tempColour;
+
+	auto bodyIndex = [&](GameObject* o) {
+		auto found = bodyIndices.find(o);
+		if (found != bodyIndices.end()) {
+			return found->second;
+		}
+		int index = (int)bodyObjects.size();
+		bodyIndices.insert({ o, index });
+		bodyObjects.push_back(o);
+		usedColours.push_back(0);
+		return index;
+	};
+
+	int colourCount = 0;
+	for (auto i = first; i != last; ++i) {
+		PositionConstraint* c = dynamic_cast<PositionConstraint*>(*i);
+		GameObject* a = nullptr;
+		GameObject* b = nullptr;
+		if (c) {
+			c->GetConstrainedObjects(a, b);
+		}
+		if (!a || !b || a == b || !a->GetPhysicsObject() || !b->GetPhysicsObject()) {
+			otherConstraints.push_back(*i);
+			continue;
+		}
+		int indexA = bodyIndex(a);
+		int indexB = bodyIndex(b);
+
+		uint64_t freeColours = ~(usedColours[indexA] | usedColours[indexB]);
+		int colour = MaxColours;
+		if (freeColours) {
+			colour = std::countr_zero(freeColours);
+			usedColours[indexA] |= (uint64_t)1 << colour;
+			usedColours[indexB] |= (uint64_t)1 << colour;
+			colourCount = std::max(colourCount, colour + 1);
+		}
+		tempA.push_back(indexA);
+		tempB.push_back(indexB);
+		tempDistance.push_back(c->GetDistance());
+		tempColour.push_back(colour);
+	}
+
+	//Overflowing links go on the end, after the last real colour
+	bool overflow = std::find(tempColour.begin(), tempColour.end(), MaxColours) != tempColour.end();
+	if (overflow) {
+		serialColour = colourCount;
+		for (int& colour : tempColour) {
+			colour = std::min(colour, serialColour);
+		}
+		colourCount++;
+	}
+
+	//Counting sort of the links by colour
+	colourStarts.assign(colourCount + 1, 0);
+	for (int colour : tempColour) {
+		colourStarts[colour + 1]++;
+	}
+	for (int c = 0; c < colourCount; ++c) {
+		colourStarts[c + 1] += colourStarts[c];
+	}
+	int linkCount = (int)tempColour.size();
+	linkBodyA.resize(linkCount);
+	linkBodyB.resize(linkCount);
+	linkDistance.resize(linkCount);
+	linkActive.assign(linkCount, 1);
+
+	std::vector<int> nextSlot(colourStarts.begin(), colourStarts.end() - 1);
+	for (int i = 0; i < linkCount; ++i) {
+		int slot = nextSlot[tempColour[i]]++;
+		linkBodyA[slot]		= tempA[i];
+		linkBodyB[slot]		= tempB[i];
+		linkDistance[slot]	= tempDistance[i];
+	}
+
+	int bodyCount = (int)bodyObjects.size();
+	for (std::vector<float>* a : { &posX, &posY, &posZ, &velX, &velY, &velZ, &inverseMass }) {
+		a->resize(bodyCount);
+	}
+	bodyTouched.resize(bodyCount);
+}
+
+void ConstraintSolver::Gather() {
+	int bodyCount = (int)bodyObjects.size();
+	for (int i = 0; i < bodyCount; ++i) {
+		const PhysicsObject* object = bodyObjects[i]->GetPhysicsObject();
+		Vector3 position	= bodyObjects[i]->GetTransform().GetPosition();
+		Vector3 velocity	= object->GetLinearVelocity();
+		posX[i] = position.x;
+		posY[i] = position.y;
+		posZ[i] = position.z;
+		velX[i] = velocity.x;
+		velY[i] = velocity.y;
+		velZ[i] = velocity.z;
+		inverseMass[i] = object->GetInverseMass();
+		bodyTouched[i] = 0;
+	}
+	int linkCount = (int)linkBodyA.size();
+	for (int i = 0; i < linkCount; ++i) {
+		if (linkActive[i]) {
+			bodyTouched[linkBodyA[i]] = 1;
+			bodyTouched[linkBodyB[i]] = 1;
+		}
+	}
+}
+
+//Constraint impulses wake their objects, just like ApplyLinearImpulse would
+void ConstraintSolver::Scatter() {
+	int bodyCount = (int)bodyObjects.size();
+	for (int i = 0; i < bodyCount; ++i) {
+		if (!bodyTouched[i]) {
+			continue;
+		}
+		PhysicsObject* object = bodyObjects[i]->GetPhysicsObject();
+		object->Wake();
+		object->SetLinearVelocity(Vector3(velX[i], velY[i], velZ[i]));
+	}
+}
+
+void ConstraintSolver::SolveIteration(float dt, ThreadPool* pool, int minRange) {
+	int colourCount = GetColourCount();
+	for (int c = 0; c < colourCount; ++c) {
+		int start	= colourStarts[c];
+		int end		= colourStarts[c + 1];
+		if (pool && c != serialColour) {
+			pool->ParallelFor(end - start, minRange,
+				[&](int first, int last, int) {
+					SolveLinks(start + first, start + last, dt);
+				}
+			);
+		}
+		else {
+			SolveLinks(start, end, dt);
+		}
+	}
+}
+
+/*
+This is the same velocity solve as PositionConstraint::UpdateConstraint,
+just working on the arrays instead of the objects.
+*/
+void ConstraintSolver::SolveLinks(int first, int last, float dt) {
+	const float biasFactor = 0.01f;
+	for (int i = first; i < last; ++i) {
+		if (!linkActive[i]) {
+			continue;
+		}
+		int a = linkBodyA[i];
+		int b = linkBodyB[i];
+
+		float constraintMass = inverseMass[a] + inverseMass[b];
+		if (constraintMass <= 0.0f) {
+			continue;
+		}
+		float relX = posX[a] - posX[b];
+		float relY = posY[a] - posY[b];
+		float relZ = posZ[a] - posZ[b];
+
+		float currentDistance = std::sqrt(relX * relX + relY * relY + relZ * relZ);
+		float offset = linkDistance[i] - currentDistance;
+		if (offset == 0.0f || currentDistance == 0.0f) {
+			continue; //Nothing to do, or no direction to push in
+		}
+		float invDistance = 1.0f / currentDistance;
+		float dirX = relX * invDistance;
+		float dirY = relY * invDistance;
+		float dirZ = relZ * invDistance;
+
+		float velocityDot	= (velX[a] - velX[b]) * dirX + (velY[a] - velY[b]) * dirY + (velZ[a] - velZ[b]) * dirZ;
+		float bias			= -(biasFactor / dt) * offset;
+		float lambda		= -(velocityDot + bias) / constraintMass;
+
+		float impulseA = lambda * inverseMass[a];
+		float impulseB = lambda * inverseMass[b];
+		velX[a] += dirX * impulseA;
+		velY[a] += dirY * impulseA;
+		velZ[a] += dirZ * impulseA;
+		velX[b] -= dirX * impulseB;
+		velY[b] -= dirY * impulseB;
+		velZ[b] -= dirZ * impulseB;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "ThreadPool.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class Constraint;
+		class GameObject;
+
+		/*
+		Solves the world's PositionConstraints from flat arrays instead of
+		through the virtual Constraint list. Each constraint becomes a link
+		between two body indices, and the links are coloured so that no body
+		appears twice in the same colour. Every link in a colour can then be
+		solved at the same time without two threads ever writing to the same
+		velocity, and a rope only ever needs two colours.
+
+		The links are rebuilt only when the world's constraints change. Any
+		constraint that isn't a PositionConstraint is handed back through
+		GetOtherConstraints, to be run through its UpdateConstraint as before.
+		*/
+		class ConstraintSolver	{
+		public:
+			typedef std::vector<Constraint*>::const_iterator ConstraintIterator;
+
+			void Clear();
+
+			//Does nothing if stateID matches the one the links were built with
+			void Build(ConstraintIterator first, ConstraintIterator last, int stateID);
+
+			int GetLinkCount() const {
+				return (int)linkBodyA.size();
+			}
+
+			int GetColourCount() const {
+				return (int)colourStarts.size() - 1;
+			}
+
+			int GetBodyCount() const {
+				return (int)bodyObjects.size();
+			}
+
+			void GetLinkObjects(int link, GameObject*& a, GameObject*& b) const {
+				a = bodyObjects[linkBodyA[link]];
+				b = bodyObjects[linkBodyB[link]];
+			}
+
+			//Inactive links (ie those between sleeping objects) are skipped
+			void SetLinkActive(int link, bool state) {
+				linkActive[link] = state;
+			}
+
+			const std::vector<Constraint*>& GetOtherConstraints() const {
+				return otherConstraints;
+			}
+
+			//Copies positions and velocities in from the PhysicsObjects...
+			void Gather();
+			//...runs one pass over every colour, in parallel if given a pool...
+			void SolveIteration(float dt, ThreadPool* pool = nullptr, int minRange = 256);
+			//...and copies the velocities back out again
+			void Scatter();
+
+		protected:
+			void SolveLinks(int first, int last, float dt);
+
+			int builtState = -1;
+
+			std::vector<GameObject*>	bodyObjects;
+			std::vector<char>			bodyTouched;
+			std::vector<float> posX, posY, posZ;
+			std::vector<float> velX, velY, velZ;
+			std::vector<float> inverseMass;
+
+			//Sorted by colour, colour c is [colourStarts[c], colourStarts[c+1])
+			std::vector<int>	linkBodyA;
+			std::vector<int>	linkBodyB;
+			std::vector<float>	linkDistance;
+			std::vector<char>	linkActive;
+			std::vector<int>	colourStarts;
+			int					serialColour = -1;	//Overflow colour that can't be split up
+
+			std::vector<Constraint*> otherConstraints;
+		};
+	}
+}
@@ -0,0 +1,216 @@
+#include "ContactBatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define CONTACTBATCH_USE_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const int BatchWidth = 4;
+
+	//The SSE loops always read whole groups of four, so the arrays are padded
+	//out with pairs that can't touch - zero sized, and a long way apart
+	void PadArrays(std::initializer_list<std::vector<float>*> arrays, int count, float value) {
+		int padded = (count + BatchWidth - 1) / BatchWidth * BatchWidth;
+		for (std::vector<float>* a : arrays) {
+			a->resize(padded, value);
+		}
+	}
+
+	void TrimArrays(std::initializer_list<std::vector<float>*> arrays, int count) {
+		for (std::vector<float>* a : arrays) {
+			a->resize(count);
+		}
+	}
+}
+
+void SpherePairBatch::Clear() {
+	deltaX.clear();
+	deltaY.clear();
+	deltaZ.clear();
+	radii.clear();
+	hits.clear();
+	count = 0;
+}
+
+void SpherePairBatch::Add(const Vector3& posA, float radiusA, const Vector3& posB, float radiusB) {
+	Vector3 delta = posB - posA;
+	deltaX.push_back(delta.x);
+	deltaY.push_back(delta.y);
+	deltaZ.push_back(delta.z);
+	radii.push_back(radiusA + radiusB);
+	count++;
+}
+
+/*
+The same as CollisionDetection::SpherePairTest - the spheres touch if
+they're closer than their radii added together, and get pushed apart along
+the line between them. Every lane writes a normal and penetration, whether
+it hit or not, so only the list of hits needs any branching.
+*/
+int SpherePairBatch::Test() {
+	hits.clear();
+	PadArrays({ &deltaX, &deltaY, &deltaZ }, count, FLT_MAX);
+	PadArrays({ &radii }, count, 0.0f);
+	int padded = (int)radii.size();
+	normalX.resize(padded);
+	normalY.resize(padded);
+	normalZ.resize(padded);
+	penetration.resize(padded);
+
+#ifdef CONTACTBATCH_USE_SSE
+	const __m128 zero	= _mm_setzero_ps();
+	const __m128 one	= _mm_set1_ps(1.0f);
+	for (int i = 0; i < padded; i += BatchWidth) {
+		__m128 dx	= _mm_loadu_ps(&deltaX[i]);
+		__m128 dy	= _mm_loadu_ps(&deltaY[i]);
+		__m128 dz	= _mm_loadu_ps(&deltaZ[i]);
+		__m128 r	= _mm_loadu_ps(&radii[i]);
+
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 length	= _mm_sqrt_ps(lengthSq);
+		__m128 hit		= _mm_cmplt_ps(lengthSq, _mm_mul_ps(r, r));
+
+		//Spheres right on top of each other get pushed straight up
+		__m128 apart	= _mm_cmpgt_ps(length, zero);
+		__m128 inverse	= _mm_and_ps(apart, _mm_div_ps(one, length));
+		_mm_storeu_ps(&normalX[i], _mm_mul_ps(dx, inverse));
+		_mm_storeu_ps(&normalY[i], _mm_or_ps(_mm_mul_ps(dy, inverse), _mm_andnot_ps(apart, one)));
+		_mm_storeu_ps(&normalZ[i], _mm_mul_ps(dz, inverse));
+		_mm_storeu_ps(&penetration[i], _mm_sub_ps(r, length));
+
+		int mask = _mm_movemask_ps(hit);
+		while (mask) {
+			int lane = 0;
+			while (!(mask & (1 << lane))) {
+				lane++;
+			}
+			mask &= mask - 1;
+			if (i + lane < count) {
+				hits.push_back(i + lane);
+			}
+		}
+	}
+#else
+	for (int i = 0; i < count; ++i) {
+		float lengthSq	= deltaX[i] * deltaX[i] + deltaY[i] * deltaY[i] + deltaZ[i] * deltaZ[i];
+		float length	= std::sqrt(lengthSq);
+		float inverse	= length > 0.0f ? 1.0f / length : 0.0f;
+		normalX[i]		= deltaX[i] * inverse;
+		normalY[i]		= length > 0.0f ? deltaY[i] * inverse : 1.0f;
+		normalZ[i]		= deltaZ[i] * inverse;
+		penetration[i]	= radii[i] - length;
+		if (lengthSq < radii[i] * radii[i]) {
+			hits.push_back(i);
+		}
+	}
+#endif
+	TrimArrays({ &deltaX, &deltaY, &deltaZ, &radii }, count);
+	return (int)hits.size();
+}
+
+void AABBPairBatch::Clear() {
+	deltaX.clear();
+	deltaY.clear();
+	deltaZ.clear();
+	sizeX.clear();
+	sizeY.clear();
+	sizeZ.clear();
+	hits.clear();
+	count = 0;
+}
+
+void AABBPairBatch::Add(const Vector3& posA, const Vector3& halfSizeA, const Vector3& posB, const Vector3& halfSizeB) {
+	Vector3 delta	= posB - posA;
+	Vector3 size	= halfSizeA + halfSizeB;
+	deltaX.push_back(delta.x);
+	deltaY.push_back(delta.y);
+	deltaZ.push_back(delta.z);
+	sizeX.push_back(size.x);
+	sizeY.push_back(size.y);
+	sizeZ.push_back(size.z);
+	count++;
+}
+
+/*
+The same as CollisionDetection::AABBIntersection. Along each axis the boxes
+overlap by their combined half size, less how far apart they are, and they
+get pushed apart along whichever axis overlaps least - out of whichever of
+A's faces B is nearer to.
+*/
+int AABBPairBatch::Test() {
+	hits.clear();
+	PadArrays({ &deltaX, &deltaY, &deltaZ }, count, FLT_MAX);
+	PadArrays({ &sizeX, &sizeY, &sizeZ }, count, 0.0f);
+	int padded = (int)sizeX.size();
+	faces.resize(padded);
+	penetration.resize(padded);
+
+#ifdef CONTACTBATCH_USE_SSE
+	const __m128 zero		= _mm_setzero_ps();
+	const __m128 signMask	= _mm_set1_ps(-0.0f);
+	for (int i = 0; i < padded; i += BatchWidth) {
+		__m128 dx = _mm_loadu_ps(&deltaX[i]);
+		__m128 dy = _mm_loadu_ps(&deltaY[i]);
+		__m128 dz = _mm_loadu_ps(&deltaZ[i]);
+
+		__m128 px = _mm_sub_ps(_mm_loadu_ps(&sizeX[i]), _mm_andnot_ps(signMask, dx));
+		__m128 py = _mm_sub_ps(_mm_loadu_ps(&sizeY[i]), _mm_andnot_ps(signMask, dy));
+		__m128 pz = _mm_sub_ps(_mm_loadu_ps(&sizeZ[i]), _mm_andnot_ps(signMask, dz));
+
+		__m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(px, zero), _mm_cmpgt_ps(py, zero)), _mm_cmpgt_ps(pz, zero));
+
+		//Faces come in pairs, the positive one following the negative one
+		__m128i faceX = _mm_sub_epi32(_mm_setzero_si128(), _mm_castps_si128(_mm_cmpgt_ps(dx, zero)));
+		__m128i faceY = _mm_sub_epi32(_mm_set1_epi32(2), _mm_castps_si128(_mm_cmpgt_ps(dy, zero)));
+		__m128i faceZ = _mm_sub_epi32(_mm_set1_epi32(4), _mm_castps_si128(_mm_cmpgt_ps(dz, zero)));
+
+		__m128	useY = _mm_cmplt_ps(py, px);
+		__m128	best = _mm_or_ps(_mm_and_ps(useY, py), _mm_andnot_ps(useY, px));
+		__m128i face = _mm_or_si128(_mm_and_si128(_mm_castps_si128(useY), faceY), _mm_andnot_si128(_mm_castps_si128(useY), faceX));
+
+		__m128	useZ = _mm_cmplt_ps(pz, best);
+		best = _mm_or_ps(_mm_and_ps(useZ, pz), _mm_andnot_ps(useZ, best));
+		face = _mm_or_si128(_mm_and_si128(_mm_castps_si128(useZ), faceZ), _mm_andnot_si128(_mm_castps_si128(useZ), face));
+
+		_mm_storeu_ps(&penetration[i], best);
+		_mm_storeu_si128((__m128i*)&faces[i], face);
+
+		int mask = _mm_movemask_ps(hit);
+		while (mask) {
+			int lane = 0;
+			while (!(mask & (1 << lane))) {
+				lane++;
+			}
+			mask &= mask - 1;
+			if (i + lane < count) {
+				hits.push_back(i + lane);
+			}
+		}
+	}
+#else
+	for (int i = 0; i < count; ++i) {
+		float overlap[3]	= { sizeX[i] - std::abs(deltaX[i]), sizeY[i] - std::abs(deltaY[i]), sizeZ[i] - std::abs(deltaZ[i]) };
+		float delta[3]		= { deltaX[i], deltaY[i], deltaZ[i] };
+		int axis = 0;
+		for (int a = 1; a < 3; ++a) {
+			if (overlap[a] < overlap[axis]) {
+				axis = a;
+			}
+		}
+		faces[i]		= axis * 2 + (delta[axis] > 0.0f ? 1 : 0);
+		penetration[i]	= overlap[axis];
+		if (overlap[0] > 0.0f && overlap[1] > 0.0f && overlap[2] > 0.0f) {
+			hits.push_back(i);
+		}
+	}
+#endif
+	TrimArrays({ &deltaX, &deltaY, &deltaZ, &sizeX, &sizeY, &sizeZ }, count);
+	return (int)hits.size();
+}
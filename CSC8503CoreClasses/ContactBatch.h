@@ -0,0 +1,90 @@
+#pragma once
+#include "Vector3.h"
+#include <vector>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Sphere / sphere and AABB / AABB pairs, stored a field to an array
+		rather than a pair to a struct, so the narrowphase can test them four
+		at a time with SSE. Add every pair, call Test, and then GetHits lists
+		the ones that touch.
+
+		Only the offset from A to B is kept, along with the sizes, as that's
+		all either test needs - so the results match SphereIntersection and
+		AABBIntersection, but the contact points have to be built afterwards.
+		*/
+		class SpherePairBatch {
+		public:
+			void Clear();
+			void Add(const Vector3& posA, float radiusA, const Vector3& posB, float radiusB);
+
+			//Returns how many of the pairs touch
+			int Test();
+
+			int GetCount() const {
+				return count;
+			}
+			const std::vector<int>& GetHits() const {
+				return hits;
+			}
+			//Points from A to B, like every other test
+			Vector3 GetNormal(int i) const {
+				return Vector3(normalX[i], normalY[i], normalZ[i]);
+			}
+			float GetPenetration(int i) const {
+				return penetration[i];
+			}
+
+		protected:
+			std::vector<float>	deltaX;
+			std::vector<float>	deltaY;
+			std::vector<float>	deltaZ;
+			std::vector<float>	radii;
+
+			std::vector<float>	normalX;
+			std::vector<float>	normalY;
+			std::vector<float>	normalZ;
+			std::vector<float>	penetration;
+			std::vector<int>	hits;
+			int					count = 0;
+		};
+
+		class AABBPairBatch {
+		public:
+			void Clear();
+			void Add(const Vector3& posA, const Vector3& halfSizeA, const Vector3& posB, const Vector3& halfSizeB);
+
+			//Returns how many of the pairs touch
+			int Test();
+
+			int GetCount() const {
+				return count;
+			}
+			const std::vector<int>& GetHits() const {
+				return hits;
+			}
+			//Which face of A the pair is pushed apart through - -x, +x, -y, +y, -z, +z
+			int GetFace(int i) const {
+				return faces[i];
+			}
+			float GetPenetration(int i) const {
+				return penetration[i];
+			}
+
+		protected:
+			std::vector<float>	deltaX;
+			std::vector<float>	deltaY;
+			std::vector<float>	deltaZ;
+			std::vector<float>	sizeX;	//the two boxes' half sizes added together
+			std::vector<float>	sizeY;
+			std::vector<float>	sizeZ;
+
+			std::vector<int>	faces;
+			std::vector<float>	penetration;
+			std::vector<int>	hits;
+			int					count = 0;
+		};
+	}
+}
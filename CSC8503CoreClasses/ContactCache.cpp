@@ -0,0 +1,110 @@
+#include "ContactCache.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+const size_t minSlots = 64;
+
+ContactCache::ContactCache() {
+	slots.resize(minSlots, -1);
+}
+
+uint64_t ContactCache::GetPairID(const GameObject* a, const GameObject* b) {
+	uint32_t idA = (uint32_t)a->GetWorldID();
+	uint32_t idB = (uint32_t)b->GetWorldID();
+	if (idA > idB) {
+		std::swap(idA, idB);
+	}
+	return ((uint64_t)idA << 32) | idB;
+}
+
+//Consecutive world IDs would otherwise all land next to each other
+size_t ContactCache::Hash(uint64_t pairID) {
+	pairID ^= pairID >> 33;
+	pairID *= 0xff51afd7ed558ccdULL;
+	pairID ^= pairID >> 33;
+	pairID *= 0xc4ceb9fe1a85ec53ULL;
+	pairID ^= pairID >> 33;
+	return (size_t)pairID;
+}
+
+void ContactCache::Clear() {
+	contacts.clear();
+	slots.assign(minSlots, -1);
+}
+
+int ContactCache::FindSlot(uint64_t pairID) const {
+	size_t mask = slots.size() - 1;
+	for (size_t slot = Hash(pairID) & mask; slots[slot] != -1; slot = (slot + 1) & mask) {
+		if (contacts[slots[slot]].pairID == pairID) {
+			return (int)slot;
+		}
+	}
+	return -1;
+}
+
+CachedContact* ContactCache::Find(uint64_t pairID) {
+	int slot = FindSlot(pairID);
+	return slot == -1 ? nullptr : &contacts[slots[slot]];
+}
+
+CachedContact& ContactCache::Insert(const CollisionDetection::CollisionInfo& info) {
+	uint64_t pairID = GetPairID(info.a, info.b);
+	if (CachedContact* existing = Find(pairID)) {
+		existing->info = info;
+		return *existing;
+	}
+	//Keep the table at most half full, so probe runs stay short
+	if ((contacts.size() + 1) * 2 > slots.size()) {
+		Rehash(slots.size() * 2);
+	}
+	size_t mask = slots.size() - 1;
+	size_t slot = Hash(pairID) & mask;
+	while (slots[slot] != -1) {
+		slot = (slot + 1) & mask;
+	}
+	slots[slot] = (int)contacts.size();
+	contacts.push_back({ pairID, info, false, ContactManifold() });
+	return contacts.back();
+}
+
+void ContactCache::RemoveAt(int index) {
+	EraseSlot(FindSlot(contacts[index].pairID));
+
+	int lastIndex = (int)contacts.size() - 1;
+	if (index != lastIndex) {
+		slots[FindSlot(contacts[lastIndex].pairID)] = index;
+		contacts[index] = contacts[lastIndex];
+	}
+	contacts.pop_back();
+}
+
+/*
+Rather than leaving a tombstone, the entries after the hole are shuffled
+back into it, as long as that doesn't move them in front of the slot they
+hashed to. That keeps lookups from having to step over dead slots.
+*/
+void ContactCache::EraseSlot(int slot) {
+	size_t mask = slots.size() - 1;
+	size_t hole = (size_t)slot;
+	for (size_t next = (hole + 1) & mask; slots[next] != -1; next = (next + 1) & mask) {
+		size_t home = Hash(contacts[slots[next]].pairID) & mask;
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			slots[hole] = slots[next];
+			hole = next;
+		}
+	}
+	slots[hole] = -1;
+}
+
+void ContactCache::Rehash(size_t newSize) {
+	slots.assign(newSize, -1);
+	size_t mask = newSize - 1;
+	for (int i = 0; i < (int)contacts.size(); ++i) {
+		size_t slot = Hash(contacts[i].pairID) & mask;
+		while (slots[slot] != -1) {
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = i;
+	}
+}
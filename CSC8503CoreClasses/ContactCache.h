@@ -0,0 +1,63 @@
+#pragma once
+#include "ContactManifold.h"
+#include <cstdint>
+
+namespace NCL {
+	namespace CSC8503 {
+		struct CachedContact {
+			uint64_t							pairID;
+			CollisionDetection::CollisionInfo	info;	//framesLeft lives in here
+			bool								hasBegun;	//OnCollisionBegin has been sent
+			ContactManifold						manifold;
+		};
+
+		/*
+		Every pair of objects that is, or was recently, in contact. Contacts
+		live packed together in one array, so walking over all of them is a
+		straight run through memory, and an open addressing table of indices
+		into that array finds a pair in O(1). Removing a contact moves the
+		last one into its place, so contact indices are only stable until
+		the next RemoveAt.
+		*/
+		class ContactCache	{
+		public:
+			ContactCache();
+
+			//The same for (a, b) and (b, a), and stable for as long as
+			//both objects stay in the world
+			static uint64_t GetPairID(const GameObject* a, const GameObject* b);
+
+			void Clear();
+
+			CachedContact* Find(uint64_t pairID);
+
+			//Adds a new contact, or refreshes the contact data of an old one
+			CachedContact& Insert(const CollisionDetection::CollisionInfo& info);
+
+			void RemoveAt(int index);
+
+			int Size() const {
+				return (int)contacts.size();
+			}
+
+			CachedContact& operator[](int index) {
+				return contacts[index];
+			}
+
+			std::vector<CachedContact>::iterator begin()	{ return contacts.begin(); }
+			std::vector<CachedContact>::iterator end()		{ return contacts.end(); }
+			std::vector<CachedContact>::const_iterator begin()	const { return contacts.begin(); }
+			std::vector<CachedContact>::const_iterator end()	const { return contacts.end(); }
+
+		protected:
+			static size_t Hash(uint64_t pairID);
+
+			int  FindSlot(uint64_t pairID) const;
+			void EraseSlot(int slot);
+			void Rehash(size_t newSize);
+
+			std::vector<CachedContact>	contacts;
+			std::vector<int>			slots;		//-1 if empty, otherwise an index into contacts
+		};
+	}
+}
@@ -0,0 +1,66 @@
+#include "ContactManifold.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+//How far a point can move on its object and still count as the same contact
+const float matchDistance	= 0.1f;
+//Normals that have turned further than this (as a cosine) start a new manifold
+const float matchNormal		= 0.95f;
+
+void ContactManifold::Update(const CollisionDetection::CollisionInfo& info, int step) {
+	bool continuing = pointCount > 0 && lastStep == step - 1;
+
+	//The narrowphase doesn't always give us the pair in the same order
+	bool flipped = continuing && info.a == objectB && info.b == objectA;
+	if (continuing && !flipped && (info.a != objectA || info.b != objectB)) {
+		continuing = false;
+	}
+	Vector3 newNormal = flipped ? -info.point.normal : info.point.normal;
+	if (continuing && Vector3::Dot(newNormal, normal) < matchNormal) {
+		continuing = false;
+	}
+	if (!continuing) {
+		objectA		= info.a;
+		objectB		= info.b;
+		flipped		= false;
+		newNormal	= info.point.normal;
+		pointCount	= 0;
+	}
+
+	Quaternion invOrientationA = objectA->GetTransform().GetOrientation().Conjugate();
+	Quaternion invOrientationB = objectB->GetTransform().GetOrientation().Conjugate();
+
+	ManifoldPoint newPoints[MaxPoints];
+	int newCount = std::min(info.pointCount, (int)MaxPoints);
+	for (int i = 0; i < newCount; ++i) {
+		const CollisionDetection::ContactPoint& p = info.GetContactPoint(i);
+		ManifoldPoint& np = newPoints[i];
+
+		np.localA		= invOrientationA * (flipped ? p.localB : p.localA);
+		np.localB		= invOrientationB * (flipped ? p.localA : p.localB);
+		np.penetration	= p.penetration;
+
+		np.normalImpulse		= 0.0f;
+		np.tangentImpulse[0]	= 0.0f;
+		np.tangentImpulse[1]	= 0.0f;
+
+		float bestDistance = matchDistance * matchDistance;
+		for (int j = 0; j < pointCount; ++j) {
+			float distance = (points[j].localA - np.localA).LengthSquared();
+			if (distance < bestDistance) {
+				bestDistance			= distance;
+				np.normalImpulse		= points[j].normalImpulse;
+				np.tangentImpulse[0]	= points[j].tangentImpulse[0];
+				np.tangentImpulse[1]	= points[j].tangentImpulse[1];
+			}
+		}
+	}
+
+	for (int i = 0; i < newCount; ++i) {
+		points[i] = newPoints[i];
+	}
+	pointCount	= newCount;
+	normal		= newNormal;
+	lastStep	= step;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		struct ManifoldPoint {
+			Vector3 localA;		//Where the contact is relative to A, in A's model space
+			Vector3 localB;		//...and the same for B
+			float	penetration;
+
+			//Summed over every solver iteration, and kept from one step to
+			//the next so the solver can start from last step's answer
+			float	normalImpulse;
+			float	tangentImpulse[2];
+		};
+
+		/*
+		The contact points between a pair of objects, kept between steps.
+		Each step's narrowphase result replaces the points, but any new point
+		close to one from the previous step inherits its accumulated impulses.
+		If the pair was apart last step, or the contact normal has swung
+		round, we start again from nothing.
+		*/
+		struct ContactManifold {
+			static const int MaxPoints = CollisionDetection::CollisionInfo::MaxContactPoints;
+
+			GameObject*		objectA		= nullptr;
+			GameObject*		objectB		= nullptr;
+			Vector3			normal;		//From A towards B
+			ManifoldPoint	points[MaxPoints];
+			int				pointCount	= 0;
+			int				lastStep	= -1;	//The physics step these points were found in
+
+			void Update(const CollisionDetection::CollisionInfo& info, int step);
+		};
+	}
+}
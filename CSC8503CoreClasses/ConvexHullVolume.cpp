@@ -0,0 +1,132 @@
+#include "ConvexHullVolume.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define CONVEXHULL_USE_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace NCL;
+using namespace Rendering;
+
+namespace {
+	const int HullDirections = 256;
+	const int SearchWidth	 = 4;
+}
+
+ConvexHullVolume::ConvexHullVolume(const std::vector<Vector3>& meshPoints, const Vector3& scale) {
+	type = VolumeType::ConvexHull;
+	Build(meshPoints, scale);
+}
+
+ConvexHullVolume::ConvexHullVolume(const Mesh& mesh, const Vector3& scale) {
+	type = VolumeType::ConvexHull;
+	Build(mesh.GetPositionData(), scale);
+}
+
+/*
+The directions are a Fibonacci spiral, which spreads them around the sphere
+about as evenly as they can be without having to subdivide anything.
+*/
+void ConvexHullVolume::Build(const std::vector<Vector3>& meshPoints, const Vector3& scale) {
+	const float goldenAngle = 3.14159265f * (3.0f - std::sqrt(5.0f));
+
+	points.clear();
+	pointX.clear();
+	pointY.clear();
+	pointZ.clear();
+	halfDimensions = Vector3();
+	if (meshPoints.empty()) {
+		return;
+	}
+
+	std::vector<char> kept(meshPoints.size(), 0);
+	for (int d = 0; d < HullDirections; ++d) {
+		float y		= 1.0f - (d + 0.5f) * (2.0f / HullDirections);
+		float ring	= std::sqrt(std::max(1.0f - y * y, 0.0f));
+		Vector3 dir(std::cos(goldenAngle * d) * ring, y, std::sin(goldenAngle * d) * ring);
+
+		int		best	 = 0;
+		float	bestDist = -FLT_MAX;
+		for (size_t i = 0; i < meshPoints.size(); ++i) {
+			float dist = Vector3::Dot(meshPoints[i] * scale, dir);
+			if (dist > bestDist) {
+				bestDist = dist;
+				best	 = (int)i;
+			}
+		}
+		kept[best] = 1;
+	}
+
+	for (size_t i = 0; i < meshPoints.size(); ++i) {
+		if (!kept[i]) {
+			continue;
+		}
+		Vector3 p = meshPoints[i] * scale;
+		points.push_back(p);
+		halfDimensions = Vector3::Max(halfDimensions, Vector3(std::abs(p.x), std::abs(p.y), std::abs(p.z)));
+	}
+	//Padding with copies of the first point can't change which point is furthest
+	size_t padded = (points.size() + SearchWidth - 1) / SearchWidth * SearchWidth;
+	for (size_t i = 0; i < padded; ++i) {
+		const Vector3& p = points[i < points.size() ? i : 0];
+		pointX.push_back(p.x);
+		pointY.push_back(p.y);
+		pointZ.push_back(p.z);
+	}
+}
+
+/*
+Keeps the furthest point found so far in each of four lanes, and only
+picks between the lanes at the end - so there's no branch per point.
+*/
+Vector3 ConvexHullVolume::GetSupportPoint(const Vector3& localDirection) const {
+	if (points.empty()) {
+		return Vector3();
+	}
+	int best = 0;
+#ifdef CONVEXHULL_USE_SSE
+	__m128 dirX = _mm_set1_ps(localDirection.x);
+	__m128 dirY = _mm_set1_ps(localDirection.y);
+	__m128 dirZ = _mm_set1_ps(localDirection.z);
+
+	__m128	bestDist	= _mm_set1_ps(-FLT_MAX);
+	__m128i bestIndex	= _mm_setzero_si128();
+	__m128i index		= _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i step	= _mm_set1_epi32(SearchWidth);
+	for (size_t i = 0; i < pointX.size(); i += SearchWidth) {
+		__m128 dist = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(&pointX[i]), dirX),
+			_mm_mul_ps(_mm_loadu_ps(&pointY[i]), dirY)),
+			_mm_mul_ps(_mm_loadu_ps(&pointZ[i]), dirZ));
+		__m128 further	= _mm_cmpgt_ps(dist, bestDist);
+		bestDist		= _mm_max_ps(dist, bestDist);
+		bestIndex		= _mm_or_si128(_mm_and_si128(_mm_castps_si128(further), index), _mm_andnot_si128(_mm_castps_si128(further), bestIndex));
+		index			= _mm_add_epi32(index, step);
+	}
+	alignas(16) float	laneDist[SearchWidth];
+	alignas(16) int		laneIndex[SearchWidth];
+	_mm_store_ps(laneDist, bestDist);
+	_mm_store_si128((__m128i*)laneIndex, bestIndex);
+	for (int i = 1; i < SearchWidth; ++i) {
+		if (laneDist[i] > laneDist[0]) {
+			laneDist[0]		= laneDist[i];
+			laneIndex[0]	= laneIndex[i];
+		}
+	}
+	best = laneIndex[0];
+#else
+	float bestDist = -FLT_MAX;
+	for (size_t i = 0; i < points.size(); ++i) {
+		float dist = Vector3::Dot(points[i], localDirection);
+		if (dist > bestDist) {
+			bestDist = dist;
+			best	 = (int)i;
+		}
+	}
+#endif
+	return points[best < (int)points.size() ? best : 0];
+}
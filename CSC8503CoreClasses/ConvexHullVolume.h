@@ -0,0 +1,57 @@
+#pragma once
+#include "CollisionVolume.h"
+#include "Vector3.h"
+#include <vector>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace Rendering {
+		class Mesh;
+	}
+
+	/*
+	The convex hull of a cloud of points - usually a Mesh's vertices - for
+	objects that a box or sphere would fit badly. It's collided against with
+	GJK / EPA, which only ever needs to know which of the hull's points is
+	furthest along a direction, so the hull's faces are never built.
+
+	Points that can't be furthest along any direction are inside the hull, and
+	are thrown away when it's made. Rather than building the hull properly to
+	find them, the hull keeps whichever points come furthest along a few
+	hundred directions spread evenly around a sphere - so a very finely curved
+	mesh might lose a little off its curves.
+	*/
+	class ConvexHullVolume : public CollisionVolume
+	{
+	public:
+		ConvexHullVolume(const std::vector<Vector3>& points, const Vector3& scale = Vector3(1, 1, 1));
+		ConvexHullVolume(const Rendering::Mesh& mesh, const Vector3& scale = Vector3(1, 1, 1));
+		~ConvexHullVolume() {
+
+		}
+
+		const std::vector<Vector3>& GetPoints() const {
+			return points;
+		}
+
+		//The furthest point along a direction, in the hull's own space
+		Vector3 GetSupportPoint(const Vector3& localDirection) const;
+
+		//Half the size of a box around the hull, centred on the hull's origin
+		Vector3 GetHalfDimensions() const {
+			return halfDimensions;
+		}
+
+	protected:
+		void Build(const std::vector<Vector3>& meshPoints, const Vector3& scale);
+
+		std::vector<Vector3>	points;
+		Vector3					halfDimensions;
+
+		//The points again, a coordinate at a time and padded out to whole groups of
+		//four, so the support search can look at four points at once
+		std::vector<float>		pointX;
+		std::vector<float>		pointY;
+		std::vector<float>		pointZ;
+	};
+}
@@ -1,8 +1,9 @@
 #include "Debug.h"
+#include <iterator>
 using namespace NCL;
 
-std::vector<Debug::DebugStringEntry>	Debug::stringEntries;
-std::vector<Debug::DebugLineEntry>		Debug::lineEntries;
+thread_local std::vector<Debug::DebugStringEntry>	Debug::stringEntries;
+thread_local std::vector<Debug::DebugLineEntry>		Debug::lineEntries;
 
 SimpleFont* Debug::debugFont = nullptr;
 
@@ -88,4 +89,15 @@ const std::vector<Debug::DebugStringEntry>& Debug::GetDebugStrings() {
 
 const std::vector<Debug::DebugLineEntry>& Debug::GetDebugLines() {
 	return lineEntries;
-}
\ No newline at end of file
+}
+void Debug::TakeThreadEntries(std::vector<DebugStringEntry>& strings, std::vector<DebugLineEntry>& lines) {
+	strings.insert(strings.end(), std::make_move_iterator(stringEntries.begin()), std::make_move_iterator(stringEntries.end()));
+	lines.insert(lines.end(), lineEntries.begin(), lineEntries.end());
+	stringEntries.clear();
+	lineEntries.clear();
+}
+
+void Debug::AddEntries(const std::vector<DebugStringEntry>& strings, const std::vector<DebugLineEntry>& lines) {
+	stringEntries.insert(stringEntries.end(), strings.begin(), strings.end());
+	lineEntries.insert(lineEntries.end(), lines.begin(), lines.end());
+}
@@ -39,6 +39,11 @@ namespace NCL {
 		static const std::vector<DebugStringEntry>& GetDebugStrings();
 		static const std::vector<DebugLineEntry>& GetDebugLines();
 
+		//For handing what another thread drew over to the one that renders -
+		//Take empties this thread's lists onto the ends of the given ones
+		static void TakeThreadEntries(std::vector<DebugStringEntry>& strings, std::vector<DebugLineEntry>& lines);
+		static void AddEntries(const std::vector<DebugStringEntry>& strings, const std::vector<DebugLineEntry>& lines);
+
 
 		static const Vector4 RED;
 		static const Vector4 GREEN;
@@ -55,8 +60,10 @@ namespace NCL {
 		Debug() {}
 		~Debug() {}
 
-		static std::vector<DebugStringEntry>	stringEntries;
-		static std::vector<DebugLineEntry>		lineEntries;
+		//One set per thread, so worlds being updated on other threads
+		//can't add to (or race with) whatever the renderer is drawing
+		static thread_local std::vector<DebugStringEntry>	stringEntries;
+		static thread_local std::vector<DebugLineEntry>		lineEntries;
 
 		static SimpleFont* debugFont;
 		static Texture* fontTexture;
@@ -0,0 +1,514 @@
+#pragma once
+#include "Vector3.h"
+#include "Ray.h"
+#include "CollisionDetection.h"
+#include "RayPacket.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		template<class T>
+		class DynamicAABBTree;
+
+		/*
+		A node of the tree. Leaves hold a single object and its 'fat' AABB,
+		internal nodes hold the union of their two children. Nodes live in
+		one contiguous pool and refer to each other by index, so a proxy ID
+		handed out by Insert stays valid until that proxy is removed.
+		*/
+		template<class T>
+		struct DynamicAABBTreeNode {
+			Vector3 minBounds;
+			Vector3 maxBounds;
+			T		object;
+
+			int		parent;		//Doubles as the 'next' link while on the free list
+			int		children[2];
+			int		height;		//0 for leaves, -1 for free nodes
+
+			bool IsLeaf() const {
+				return children[0] == -1;
+			}
+		};
+
+		template<class T>
+		class DynamicAABBTree {
+		public:
+			static const int NullNode = -1;
+
+			DynamicAABBTree(float fatMargin = 0.5f) {
+				margin = fatMargin;
+				Clear();
+			}
+			~DynamicAABBTree() {
+			}
+
+			void Clear() {
+				nodes.clear();
+				root		= NullNode;
+				freeList	= NullNode;
+				proxyCount	= 0;
+			}
+
+			/*
+			Adds an object to the tree, returning the proxy ID used to refer
+			to it from then on. The stored AABB is fattened by the margin, so
+			small movements don't require the tree to be touched at all.
+			*/
+			int Insert(T object, const Vector3& pos, const Vector3& halfSize) {
+				int proxy = AllocateNode();
+
+				Vector3 fatSize = halfSize + Vector3(margin, margin, margin);
+				nodes[proxy].minBounds	= pos - fatSize;
+				nodes[proxy].maxBounds	= pos + fatSize;
+				nodes[proxy].object		= object;
+				nodes[proxy].height		= 0;
+
+				InsertLeaf(proxy);
+				proxyCount++;
+				return proxy;
+			}
+
+			void Remove(int proxy) {
+				RemoveLeaf(proxy);
+				FreeNode(proxy);
+				proxyCount--;
+			}
+
+			/*
+			Updates a proxy with the object's current bounds. If they still fit
+			inside the fat AABB nothing happens and false is returned. Otherwise
+			the leaf is reinserted with a new fat AABB, extended in the direction
+			of travel by the predicted displacement, and true is returned.
+			*/
+			bool Move(int proxy, const Vector3& pos, const Vector3& halfSize, const Vector3& displacement = Vector3()) {
+				Vector3 minBounds = pos - halfSize;
+				Vector3 maxBounds = pos + halfSize;
+
+				DynamicAABBTreeNode<T>& node = nodes[proxy];
+				if (Contains(node.minBounds, node.maxBounds, minBounds, maxBounds)) {
+					return false;
+				}
+
+				RemoveLeaf(proxy);
+
+				Vector3 fat(margin, margin, margin);
+				minBounds -= fat;
+				maxBounds += fat;
+
+				for (int i = 0; i < 3; ++i) {
+					if (displacement[i] < 0.0f) {
+						minBounds[i] += displacement[i];
+					}
+					else {
+						maxBounds[i] += displacement[i];
+					}
+				}
+				nodes[proxy].minBounds = minBounds;
+				nodes[proxy].maxBounds = maxBounds;
+
+				InsertLeaf(proxy);
+				return true;
+			}
+
+			/*
+			Calls func with every proxy whose fat AABB overlaps the given box.
+			Returning false from func stops the query early.
+			*/
+			template<class F>
+			void Query(const Vector3& minBounds, const Vector3& maxBounds, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				NodeStack<> stack;
+				stack.Push(root);
+
+				while (!stack.Empty()) {
+					int index = stack.Pop();
+					const DynamicAABBTreeNode<T>& node = nodes[index];
+
+					if (!Overlaps(node.minBounds, node.maxBounds, minBounds, maxBounds)) {
+						continue;
+					}
+					if (node.IsLeaf()) {
+						if (!func(index)) {
+							return;
+						}
+					}
+					else {
+						stack.Push(node.children[0]);
+						stack.Push(node.children[1]);
+					}
+				}
+			}
+
+			/*
+			Works just like Octree::RayCast - func is called with every object
+			whose fat AABB the ray passes through, nearest subtree first, and
+			returns the distance to keep looking up to, or a negative value to stop.
+			*/
+			template<class F>
+			void RayCast(const Ray& r, F&& func, float maxDistance = FLT_MAX) const {
+				if (root == NullNode) {
+					return;
+				}
+				Vector3 rayPos	= r.GetPosition();
+				Vector3 rayDir	= r.GetDirection();
+				Vector3 invDir	= Vector3(1.0f / rayDir.x, 1.0f / rayDir.y, 1.0f / rayDir.z);
+
+				float closest = maxDistance;
+				float tEnter;
+				if (!CollisionDetection::RaySlabTest(rayPos, invDir, nodes[root].minBounds, nodes[root].maxBounds, closest, tEnter)) {
+					return;
+				}
+				NodeStack<std::pair<float, int>> stack;
+				stack.Push({ tEnter, root });
+
+				while (!stack.Empty()) {
+					auto [nodeDistance, index] = stack.Pop();
+					if (nodeDistance > closest) {
+						continue;
+					}
+					const DynamicAABBTreeNode<T>& node = nodes[index];
+					if (node.IsLeaf()) {
+						float hitDistance = func(node.object);
+						if (hitDistance < 0.0f) {
+							return;
+						}
+						closest = std::min(closest, hitDistance);
+						continue;
+					}
+					//Push the further child first, so the nearer one gets popped next
+					const DynamicAABBTreeNode<T>& left	= nodes[node.children[0]];
+					const DynamicAABBTreeNode<T>& right	= nodes[node.children[1]];
+					float tLeft;
+					float tRight;
+					bool hitLeft	= CollisionDetection::RaySlabTest(rayPos, invDir, left.minBounds, left.maxBounds, closest, tLeft);
+					bool hitRight	= CollisionDetection::RaySlabTest(rayPos, invDir, right.minBounds, right.maxBounds, closest, tRight);
+					if (hitLeft && hitRight) {
+						if (tLeft < tRight) {
+							stack.Push({ tRight, node.children[1] });
+							stack.Push({ tLeft, node.children[0] });
+						}
+						else {
+							stack.Push({ tLeft, node.children[0] });
+							stack.Push({ tRight, node.children[1] });
+						}
+					}
+					else if (hitLeft) {
+						stack.Push({ tLeft, node.children[0] });
+					}
+					else if (hitRight) {
+						stack.Push({ tRight, node.children[1] });
+					}
+				}
+			}
+
+			/*
+			Walks a whole packet of rays down the tree together. func is called
+			with each object along with a mask of the lanes whose rays hit its
+			box, and should lower closest[lane] for any lane it finds a hit for,
+			so that nodes behind every lane's closest hit get skipped.
+			*/
+			template<class F>
+			void RayCastPacket(const RayPacket& packet, const float* closest, F&& func) const {
+				if (root == NullNode) {
+					return;
+				}
+				Vector3 dir(packet.dirX[0], packet.dirY[0], packet.dirZ[0]);
+				float	tEnter[RayPacket::Width];
+
+				NodeStack<> stack;
+				stack.Push(root);
+				while (!stack.Empty()) {
+					int index = stack.Pop();
+					const DynamicAABBTreeNode<T>& node = nodes[index];
+
+					int lanes = packet.SlabTest(node.minBounds, node.maxBounds, closest, tEnter);
+					if (lanes == 0) {
+						continue;
+					}
+					if (node.IsLeaf()) {
+						func(node.object, lanes);
+						continue;
+					}
+					//The rays are usually heading the same way, so the first one picks the nearer child
+					const DynamicAABBTreeNode<T>& left	= nodes[node.children[0]];
+					const DynamicAABBTreeNode<T>& right	= nodes[node.children[1]];
+					bool leftFirst = Vector3::Dot(left.minBounds + left.maxBounds - right.minBounds - right.maxBounds, dir) < 0.0f;
+					stack.Push(node.children[leftFirst ? 1 : 0]);
+					stack.Push(node.children[leftFirst ? 0 : 1]);
+				}
+			}
+
+			bool TestFatOverlap(int proxyA, int proxyB) const {
+				return Overlaps(nodes[proxyA].minBounds, nodes[proxyA].maxBounds, nodes[proxyB].minBounds, nodes[proxyB].maxBounds);
+			}
+
+			void GetFatAABB(int proxy, Vector3& minBounds, Vector3& maxBounds) const {
+				minBounds = nodes[proxy].minBounds;
+				maxBounds = nodes[proxy].maxBounds;
+			}
+
+			T GetObject(int proxy) const {
+				return nodes[proxy].object;
+			}
+
+			int GetProxyCount() const {
+				return proxyCount;
+			}
+
+			int GetHeight() const {
+				return root == NullNode ? 0 : nodes[root].height;
+			}
+
+		protected:
+			/*
+			Small fixed stack for traversals - balancing keeps the tree height
+			logarithmic, so we only fall back to the heap for truly huge trees.
+			*/
+			template<class E = int>
+			struct NodeStack {
+				E					fixed[64];
+				std::vector<E>		overflow;
+				int					count = 0;
+
+				void Push(const E& i) {
+					if (count < 64) {
+						fixed[count] = i;
+					}
+					else {
+						overflow.push_back(i);
+					}
+					count++;
+				}
+				E Pop() {
+					count--;
+					if (count < 64) {
+						return fixed[count];
+					}
+					E i = overflow.back();
+					overflow.pop_back();
+					return i;
+				}
+				bool Empty() const {
+					return count == 0;
+				}
+			};
+
+			static bool Overlaps(const Vector3& minA, const Vector3& maxA, const Vector3& minB, const Vector3& maxB) {
+				return	minA.x <= maxB.x && maxA.x >= minB.x &&
+						minA.y <= maxB.y && maxA.y >= minB.y &&
+						minA.z <= maxB.z && maxA.z >= minB.z;
+			}
+
+			static bool Contains(const Vector3& outerMin, const Vector3& outerMax, const Vector3& innerMin, const Vector3& innerMax) {
+				return	outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z &&
+						innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+			}
+
+			static float SurfaceArea(const Vector3& minBounds, const Vector3& maxBounds) {
+				Vector3 d = maxBounds - minBounds;
+				return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+			}
+
+			static float CombinedArea(const DynamicAABBTreeNode<T>& a, const DynamicAABBTreeNode<T>& b) {
+				return SurfaceArea(Vector3::Min(a.minBounds, b.minBounds), Vector3::Max(a.maxBounds, b.maxBounds));
+			}
+
+			void FitToChildren(int index) {
+				DynamicAABBTreeNode<T>& node	= nodes[index];
+				const DynamicAABBTreeNode<T>& a	= nodes[node.children[0]];
+				const DynamicAABBTreeNode<T>& b	= nodes[node.children[1]];
+
+				node.minBounds	= Vector3::Min(a.minBounds, b.minBounds);
+				node.maxBounds	= Vector3::Max(a.maxBounds, b.maxBounds);
+				node.height		= 1 + std::max(a.height, b.height);
+			}
+
+			int AllocateNode() {
+				if (freeList == NullNode) {
+					nodes.emplace_back();
+					freeList = (int)nodes.size() - 1;
+					nodes[freeList].parent = NullNode;
+				}
+				int index = freeList;
+				freeList = nodes[index].parent;
+
+				DynamicAABBTreeNode<T>& node = nodes[index];
+				node.parent			= NullNode;
+				node.children[0]	= NullNode;
+				node.children[1]	= NullNode;
+				node.height			= 0;
+				return index;
+			}
+
+			void FreeNode(int index) {
+				nodes[index].parent = freeList;
+				nodes[index].height = -1;
+				freeList = index;
+			}
+
+			/*
+			Walks down the tree picking whichever branch grows the least in
+			surface area (the usual SAH insertion cost), then pairs the new leaf
+			with the sibling it ends up next to.
+			*/
+			void InsertLeaf(int leaf) {
+				if (root == NullNode) {
+					root = leaf;
+					nodes[root].parent = NullNode;
+					return;
+				}
+
+				int index = root;
+				while (!nodes[index].IsLeaf()) {
+					const DynamicAABBTreeNode<T>& node = nodes[index];
+					int childA = node.children[0];
+					int childB = node.children[1];
+
+					float area			= SurfaceArea(node.minBounds, node.maxBounds);
+					float combinedArea	= CombinedArea(node, nodes[leaf]);
+
+					float cost				= 2.0f * combinedArea;
+					float inheritanceCost	= 2.0f * (combinedArea - area);
+
+					float costA = CombinedArea(nodes[leaf], nodes[childA]) + inheritanceCost;
+					if (!nodes[childA].IsLeaf()) {
+						costA -= SurfaceArea(nodes[childA].minBounds, nodes[childA].maxBounds);
+					}
+					float costB = CombinedArea(nodes[leaf], nodes[childB]) + inheritanceCost;
+					if (!nodes[childB].IsLeaf()) {
+						costB -= SurfaceArea(nodes[childB].minBounds, nodes[childB].maxBounds);
+					}
+
+					if (cost < costA && cost < costB) {
+						break;
+					}
+					index = (costA < costB) ? childA : childB;
+				}
+
+				int sibling		= index;
+				int oldParent	= nodes[sibling].parent;
+				int newParent	= AllocateNode();
+
+				nodes[newParent].parent			= oldParent;
+				nodes[newParent].children[0]	= sibling;
+				nodes[newParent].children[1]	= leaf;
+				nodes[sibling].parent			= newParent;
+				nodes[leaf].parent				= newParent;
+				FitToChildren(newParent);
+
+				if (oldParent == NullNode) {
+					root = newParent;
+				}
+				else if (nodes[oldParent].children[0] == sibling) {
+					nodes[oldParent].children[0] = newParent;
+				}
+				else {
+					nodes[oldParent].children[1] = newParent;
+				}
+
+				RefitFrom(nodes[leaf].parent);
+			}
+
+			void RemoveLeaf(int leaf) {
+				if (leaf == root) {
+					root = NullNode;
+					return;
+				}
+
+				int parent		= nodes[leaf].parent;
+				int grandParent = nodes[parent].parent;
+				int sibling		= nodes[parent].children[0] == leaf ? nodes[parent].children[1] : nodes[parent].children[0];
+
+				if (grandParent == NullNode) {
+					root = sibling;
+					nodes[sibling].parent = NullNode;
+				}
+				else {
+					if (nodes[grandParent].children[0] == parent) {
+						nodes[grandParent].children[0] = sibling;
+					}
+					else {
+						nodes[grandParent].children[1] = sibling;
+					}
+					nodes[sibling].parent = grandParent;
+					RefitFrom(grandParent);
+				}
+				FreeNode(parent);
+			}
+
+			void RefitFrom(int index) {
+				while (index != NullNode) {
+					index = Balance(index);
+					FitToChildren(index);
+					index = nodes[index].parent;
+				}
+			}
+
+			/*
+			If one side of node a is more than one level taller than the other,
+			rotate the taller child up into a's place. This keeps the height (and
+			so query cost) logarithmic no matter what order objects arrive in.
+			Returns the index of the node now sitting where a was.
+			*/
+			int Balance(int a) {
+				if (nodes[a].IsLeaf() || nodes[a].height < 2) {
+					return a;
+				}
+				int b = nodes[a].children[0];
+				int c = nodes[a].children[1];
+
+				int balance = nodes[c].height - nodes[b].height;
+
+				if (balance > 1) {
+					return Rotate(a, c, 1);
+				}
+				if (balance < -1) {
+					return Rotate(a, b, 0);
+				}
+				return a;
+			}
+
+			//Promotes the taller child 'up' (which sits in slot upSlot of a) above a
+			int Rotate(int a, int up, int upSlot) {
+				int f = nodes[up].children[0];
+				int g = nodes[up].children[1];
+
+				nodes[up].children[0]	= a;
+				nodes[up].parent		= nodes[a].parent;
+				nodes[a].parent			= up;
+
+				if (nodes[up].parent == NullNode) {
+					root = up;
+				}
+				else if (nodes[nodes[up].parent].children[0] == a) {
+					nodes[nodes[up].parent].children[0] = up;
+				}
+				else {
+					nodes[nodes[up].parent].children[1] = up;
+				}
+
+				//Keep the taller grandchild under 'up', hand the shorter one to a
+				int keep	= nodes[f].height > nodes[g].height ? f : g;
+				int give	= keep == f ? g : f;
+
+				nodes[up].children[1]	= keep;
+				nodes[a].children[upSlot] = give;
+				nodes[give].parent		= a;
+
+				FitToChildren(a);
+				FitToChildren(up);
+				return up;
+			}
+
+			std::vector<DynamicAABBTreeNode<T>> nodes;
+
+			int		root;
+			int		freeList;
+			int		proxyCount;
+			float	margin;
+		};
+	}
+}
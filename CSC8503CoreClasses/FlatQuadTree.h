@@ -0,0 +1,184 @@
+#pragma once
+#include "Vector2.h"
+#include "CollisionDetection.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		template<class T>
+		struct FlatQuadTreeEntry {
+			Vector3 pos;
+			Vector3 size;
+			T		object;
+			int		leafCount;	//How many leaves this entry ended up in
+		};
+
+		/*
+		A QuadTree that can be kept around and refilled every frame without
+		touching the heap. All nodes live in one array, with the four children
+		of a node stored next to each other, and nodes only hold indices into
+		a flat entry array. Clear() resets the counts but keeps every buffer's
+		capacity, so once the tree has 'warmed up' it allocates nothing.
+		*/
+		template<class T>
+		class FlatQuadTree {
+		public:
+			FlatQuadTree(Vector2 size, int maxDepth = 6, int maxSize = 5) {
+				this->size		= size;
+				this->maxDepth	= maxDepth;
+				this->maxSize	= maxSize;
+				Clear();
+			}
+			~FlatQuadTree() {
+			}
+
+			void Clear() {
+				entries.clear();
+				if (nodes.empty()) {
+					nodes.resize(1);
+				}
+				nodeCount = 1;
+				ResetNode(0, Vector2(), size);
+			}
+
+			void Insert(T object, const Vector3& pos, const Vector3& size) {
+				int index = (int)entries.size();
+				entries.push_back({ pos, size, object, 0 });
+				InsertIntoNode(0, index, maxDepth);
+			}
+
+			/*
+			Writes every pair of entries that share a leaf and whose boxes
+			overlap into the given buffer. An entry straddling a leaf boundary
+			is stored in every leaf it touches, so two such entries can meet
+			more than once - only those pairs go through a sort to remove the
+			repeats, the rest are written straight out.
+			*/
+			void GetCandidatePairs(std::vector<std::pair<T, T>>& pairs) {
+				pairs.clear();
+				sharedKeys.clear();
+
+				for (int n = 0; n < nodeCount; ++n) {
+					const FlatQuadTreeNode& node = nodes[n];
+					if (node.firstChild != -1) {
+						continue;
+					}
+					const std::vector<int>& contents = node.contents;
+					for (size_t i = 0; i < contents.size(); ++i) {
+						const FlatQuadTreeEntry<T>& a = entries[contents[i]];
+						for (size_t j = i + 1; j < contents.size(); ++j) {
+							const FlatQuadTreeEntry<T>& b = entries[contents[j]];
+							if (!CollisionDetection::AABBTest(a.pos, b.pos, a.size, b.size)) {
+								continue;
+							}
+							if (a.leafCount > 1 && b.leafCount > 1) {
+								uint64_t lo = (uint64_t)std::min(contents[i], contents[j]);
+								uint64_t hi = (uint64_t)std::max(contents[i], contents[j]);
+								sharedKeys.push_back((lo << 32) | hi);
+							}
+							else {
+								pairs.emplace_back(a.object, b.object);
+							}
+						}
+					}
+				}
+
+				std::sort(sharedKeys.begin(), sharedKeys.end());
+				auto last = std::unique(sharedKeys.begin(), sharedKeys.end());
+				for (auto i = sharedKeys.begin(); i != last; ++i) {
+					pairs.emplace_back(entries[(int)(*i >> 32)].object, entries[(int)(*i & 0xFFFFFFFF)].object);
+				}
+			}
+
+			int GetNodeCount() const {
+				return nodeCount;
+			}
+
+			int GetEntryCount() const {
+				return (int)entries.size();
+			}
+
+		protected:
+			struct FlatQuadTreeNode {
+				Vector2				position;
+				Vector2				size;
+				int					firstChild;
+				std::vector<int>	contents;
+			};
+
+			void ResetNode(int index, const Vector2& pos, const Vector2& halfSize) {
+				FlatQuadTreeNode& node = nodes[index];
+				node.position	= pos;
+				node.size		= halfSize;
+				node.firstChild	= -1;
+				node.contents.clear();
+			}
+
+			void InsertIntoNode(int index, int entry, int depthLeft) {
+				const FlatQuadTreeEntry<T>& e = entries[entry];
+				Vector2 nodePos		= nodes[index].position;
+				Vector2 nodeSize	= nodes[index].size;
+				if (!CollisionDetection::AABBTest(e.pos, Vector3(nodePos.x, 0, nodePos.y), e.size, Vector3(nodeSize.x, 1000.f, nodeSize.y))) {
+					return;
+				}
+
+				if (nodes[index].firstChild != -1) {
+					int firstChild = nodes[index].firstChild;
+					for (int i = 0; i < 4; ++i) {
+						InsertIntoNode(firstChild + i, entry, depthLeft - 1);
+					}
+					return;
+				}
+
+				nodes[index].contents.push_back(entry);
+				entries[entry].leafCount++;
+
+				if ((int)nodes[index].contents.size() > maxSize && depthLeft > 0) {
+					Split(index);
+
+					//Inserting into the children can grow the node array, so take
+					//the contents out of the node while we redistribute them
+					std::vector<int> moved;
+					moved.swap(nodes[index].contents);
+
+					int firstChild = nodes[index].firstChild;
+					for (int moving : moved) {
+						entries[moving].leafCount--;
+						for (int i = 0; i < 4; ++i) {
+							InsertIntoNode(firstChild + i, moving, depthLeft - 1);
+						}
+					}
+					moved.clear();
+					nodes[index].contents.swap(moved);
+				}
+			}
+
+			void Split(int index) {
+				int firstChild = nodeCount;
+				nodeCount += 4;
+				if ((int)nodes.size() < nodeCount) {
+					nodes.resize(nodeCount);
+				}
+
+				Vector2 pos			= nodes[index].position;
+				Vector2 halfSize	= nodes[index].size / 2.f;
+
+				ResetNode(firstChild + 0, pos + Vector2(-halfSize.x, halfSize.y), halfSize);
+				ResetNode(firstChild + 1, pos + Vector2(halfSize.x, halfSize.y), halfSize);
+				ResetNode(firstChild + 2, pos + Vector2(-halfSize.x, -halfSize.y), halfSize);
+				ResetNode(firstChild + 3, pos + Vector2(halfSize.x, -halfSize.y), halfSize);
+
+				nodes[index].firstChild = firstChild;
+			}
+
+			std::vector<FlatQuadTreeNode>		nodes;
+			std::vector<FlatQuadTreeEntry<T>>	entries;
+			std::vector<uint64_t>				sharedKeys;
+
+			int		nodeCount;
+			Vector2 size;
+			int		maxDepth;
+			int		maxSize;
+		};
+	}
+}
@@ -0,0 +1,589 @@
+#include "GJK.h"
+#include "Transform.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "CapsuleVolume.h"
+#include "ConvexHullVolume.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <initializer_list>
+
+using namespace NCL;
+using namespace CSC8503;
+
+ConvexShape::ConvexShape(const CollisionVolume& shapeVolume, const Transform& transform) {
+	volume		= &shapeVolume;
+	position	= transform.GetPosition();
+	coreSize	= Vector3();
+	margin		= 0.0f;
+
+	//AABBs and spheres don't turn with their objects, so they're left unrotated
+	bool rotates = true;
+	switch (volume->type) {
+		case VolumeType::AABB: {
+			coreSize	= ((const AABBVolume&)shapeVolume).GetHalfDimensions();
+			rotates		= false;
+		}break;
+		case VolumeType::Sphere: {
+			margin		= ((const SphereVolume&)shapeVolume).GetRadius();
+			rotates		= false;
+		}break;
+		case VolumeType::OBB: {
+			coreSize	= ((const OBBVolume&)shapeVolume).GetHalfDimensions();
+		}break;
+		case VolumeType::Capsule: {
+			const CapsuleVolume& capsule = (const CapsuleVolume&)shapeVolume;
+			margin		= capsule.GetRadius();
+			coreSize	= Vector3(0.0f, std::max(capsule.GetHalfHeight() - capsule.GetRadius(), 0.0f), 0.0f);
+		}break;
+		default:
+			break;
+	}
+	if (rotates) {
+		rotation		= Matrix3(transform.GetOrientation());
+		inverseRotation = Matrix3(transform.GetOrientation().Conjugate());
+	}
+}
+
+Vector3 ConvexShape::GetCoreSupport(const Vector3& direction, Vector3& localPoint) const {
+	Vector3 localDir = inverseRotation * direction;
+	switch (volume->type) {
+		case VolumeType::ConvexHull: {
+			localPoint = ((const ConvexHullVolume&)*volume).GetSupportPoint(localDir);
+		}break;
+		case VolumeType::Sphere: {
+			localPoint = Vector3();
+		}break;
+		default: {
+			//Boxes, and capsules' lines, which are just a box with no width or depth
+			localPoint = Vector3(
+				localDir.x >= 0.0f ? coreSize.x : -coreSize.x,
+				localDir.y >= 0.0f ? coreSize.y : -coreSize.y,
+				localDir.z >= 0.0f ? coreSize.z : -coreSize.z);
+		}break;
+	}
+	return ToWorld(localPoint);
+}
+
+namespace {
+	const int	MaxGJKIterations	= 32;
+	const int	MaxEPAIterations	= 48;
+	const int	MaxEPAVertices		= MaxEPAIterations + 4;
+	const int	MaxEPAFaces			= 192;
+	const int	MaxEPAEdges			= 96;
+	const float GJKTolerance		= 1e-4f;	//relative to the distance found
+	const float EPATolerance		= 1e-4f;
+	const float TinyLengthSq		= 1e-12f;
+
+	//A point of A - B, and the points on A and B it came from
+	struct SimplexVertex {
+		Vector3 w;
+		Vector3 a;
+		Vector3 b;
+		Vector3 localA;
+		Vector3 localB;
+	};
+
+	struct Simplex {
+		SimplexVertex	v[4];
+		float			weights[4];
+		int				count = 0;
+
+		Vector3 GetPointA() const {
+			Vector3 p;
+			for (int i = 0; i < count; ++i) {
+				p += v[i].a * weights[i];
+			}
+			return p;
+		}
+		Vector3 GetPointB() const {
+			Vector3 p;
+			for (int i = 0; i < count; ++i) {
+				p += v[i].b * weights[i];
+			}
+			return p;
+		}
+	};
+
+	//The furthest point of A - B along direction. With margins, that's on the full shapes rather than their cores
+	SimplexVertex GetSupport(const ConvexShape& a, const ConvexShape& b, const Vector3& direction, bool withMargins) {
+		SimplexVertex s;
+		s.a = a.GetCoreSupport(direction, s.localA);
+		s.b = b.GetCoreSupport(-direction, s.localB);
+		if (withMargins && (a.GetMargin() > 0.0f || b.GetMargin() > 0.0f)) {
+			float length = direction.Length();
+			Vector3 n = length > 0.0f ? direction / length : Vector3(0, 1, 0);
+			s.a			+= n * a.GetMargin();
+			s.b			-= n * b.GetMargin();
+			s.localA	+= a.ToLocalDirection(n) * a.GetMargin();
+			s.localB	-= b.ToLocalDirection(n) * b.GetMargin();
+		}
+		s.w = s.a - s.b;
+		return s;
+	}
+
+	void KeepVertices(Simplex& s, std::initializer_list<int> keep, std::initializer_list<float> weights) {
+		SimplexVertex kept[4];
+		int count = 0;
+		for (int i : keep) {
+			kept[count++] = s.v[i];
+		}
+		count = 0;
+		for (float w : weights) {
+			s.v[count]			= kept[count];
+			s.weights[count]	= w;
+			count++;
+		}
+		s.count = count;
+	}
+
+	/*
+	Each of these cuts the simplex down to the smallest part of it that holds
+	its closest point to the origin, and sets how much each of the points
+	left counts towards it. They're the same Voronoi region tests as
+	Ericson's closest point functions (Real-Time Collision Detection 5.1).
+	*/
+	void SolveLine(Simplex& s) {
+		Vector3 a	= s.v[0].w;
+		Vector3 ab	= s.v[1].w - a;
+		float t		= -Vector3::Dot(a, ab);
+		float denom = Vector3::Dot(ab, ab);
+		if (t <= 0.0f || denom <= TinyLengthSq) {
+			KeepVertices(s, { 0 }, { 1.0f });
+		}
+		else if (t >= denom) {
+			KeepVertices(s, { 1 }, { 1.0f });
+		}
+		else {
+			t /= denom;
+			KeepVertices(s, { 0, 1 }, { 1.0f - t, t });
+		}
+	}
+
+	void SolveTriangle(Simplex& s) {
+		Vector3 a = s.v[0].w;
+		Vector3 b = s.v[1].w;
+		Vector3 c = s.v[2].w;
+		Vector3 ab = b - a;
+		Vector3 ac = c - a;
+
+		float d1 = -Vector3::Dot(ab, a);
+		float d2 = -Vector3::Dot(ac, a);
+		if (d1 <= 0.0f && d2 <= 0.0f) {
+			KeepVertices(s, { 0 }, { 1.0f });
+			return;
+		}
+		float d3 = -Vector3::Dot(ab, b);
+		float d4 = -Vector3::Dot(ac, b);
+		if (d3 >= 0.0f && d4 <= d3) {
+			KeepVertices(s, { 1 }, { 1.0f });
+			return;
+		}
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			float v = d1 / (d1 - d3);
+			KeepVertices(s, { 0, 1 }, { 1.0f - v, v });
+			return;
+		}
+		float d5 = -Vector3::Dot(ab, c);
+		float d6 = -Vector3::Dot(ac, c);
+		if (d6 >= 0.0f && d5 <= d6) {
+			KeepVertices(s, { 2 }, { 1.0f });
+			return;
+		}
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			float w = d2 / (d2 - d6);
+			KeepVertices(s, { 0, 2 }, { 1.0f - w, w });
+			return;
+		}
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			KeepVertices(s, { 1, 2 }, { 1.0f - w, w });
+			return;
+		}
+		float total = va + vb + vc;
+		if (total <= TinyLengthSq) {
+			//A triangle with no area - its longest edge will do
+			KeepVertices(s, { 0, 2 }, { 0.5f, 0.5f });
+			SolveLine(s);
+			return;
+		}
+		float v = vb / total;
+		float w = vc / total;
+		KeepVertices(s, { 0, 1, 2 }, { 1.0f - v - w, v, w });
+	}
+
+	float DistanceSq(const Simplex& s) {
+		Vector3 p;
+		for (int i = 0; i < s.count; ++i) {
+			p += s.v[i].w * s.weights[i];
+		}
+		return Vector3::Dot(p, p);
+	}
+
+	//Returns false if the origin is inside the tetrahedron, and there's nothing to cut
+	bool SolveTetrahedron(Simplex& s) {
+		static const int faces[4][4] = {
+			{ 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 }	//three on the face, and the one opposite
+		};
+		Simplex best;
+		float	bestDistSq	= FLT_MAX;
+		bool	outside		= false;
+		for (const auto& f : faces) {
+			Vector3 a = s.v[f[0]].w;
+			Vector3 n = Vector3::Cross(s.v[f[1]].w - a, s.v[f[2]].w - a);
+			float originSide	= -Vector3::Dot(a, n);
+			float otherSide		= Vector3::Dot(s.v[f[3]].w - a, n);
+			if (originSide * otherSide >= 0.0f) {
+				continue;
+			}
+			outside = true;
+			Simplex face;
+			face.v[0]	= s.v[f[0]];
+			face.v[1]	= s.v[f[1]];
+			face.v[2]	= s.v[f[2]];
+			face.count	= 3;
+			SolveTriangle(face);
+			float distSq = DistanceSq(face);
+			if (distSq < bestDistSq) {
+				bestDistSq	= distSq;
+				best		= face;
+			}
+		}
+		if (outside) {
+			s = best;
+		}
+		return outside;
+	}
+
+	//Cuts the simplex down and returns its closest point to the origin, or returns false if it holds the origin
+	bool Solve(Simplex& s, Vector3& closest) {
+		switch (s.count) {
+			case 1: s.weights[0] = 1.0f; break;
+			case 2: SolveLine(s); break;
+			case 3: SolveTriangle(s); break;
+			case 4: {
+				if (!SolveTetrahedron(s)) {
+					return false;
+				}
+			}break;
+		}
+		closest = Vector3();
+		for (int i = 0; i < s.count; ++i) {
+			closest += s.v[i].w * s.weights[i];
+		}
+		return true;
+	}
+
+	/*
+	When the origin lands exactly on GJK's simplex, it might be a point, a
+	line or a triangle - but EPA needs a tetrahedron to start from, so it's
+	filled out with support points in whichever directions add some volume.
+	*/
+	bool FillTetrahedron(const ConvexShape& a, const ConvexShape& b, Simplex& s) {
+		static const Vector3 axes[6] = {
+			Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 1, 0), Vector3(0, -1, 0), Vector3(0, 0, 1), Vector3(0, 0, -1)
+		};
+		const float epsilon = 1e-6f;
+
+		if (s.count == 1) {
+			for (const Vector3& axis : axes) {
+				SimplexVertex w = GetSupport(a, b, axis, true);
+				if ((w.w - s.v[0].w).LengthSquared() > epsilon) {
+					s.v[s.count++] = w;
+					break;
+				}
+			}
+		}
+		if (s.count == 2) {
+			Vector3 line = s.v[1].w - s.v[0].w;
+			int smallest = 0;
+			for (int i = 1; i < 3; ++i) {
+				if (std::abs(line[i]) < std::abs(line[smallest])) {
+					smallest = i;
+				}
+			}
+			Vector3 side1 = Vector3::Cross(line, axes[smallest * 2]);
+			Vector3 side2 = Vector3::Cross(line, side1);
+			const Vector3 tries[4] = { side1, -side1, side2, -side2 };
+			for (const Vector3& dir : tries) {
+				SimplexVertex w = GetSupport(a, b, dir, true);
+				if (Vector3::Cross(w.w - s.v[0].w, line).LengthSquared() > epsilon * line.LengthSquared()) {
+					s.v[s.count++] = w;
+					break;
+				}
+			}
+		}
+		if (s.count == 3) {
+			Vector3 n = Vector3::Cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w);
+			const Vector3 tries[2] = { n, -n };
+			for (const Vector3& dir : tries) {
+				SimplexVertex w = GetSupport(a, b, dir, true);
+				if (std::abs(Vector3::Dot(w.w - s.v[0].w, n)) > epsilon * n.Length()) {
+					s.v[s.count++] = w;
+					break;
+				}
+			}
+		}
+		return s.count == 4;
+	}
+
+	struct EPAFace {
+		int		v[3];
+		Vector3 normal;
+		float	distance;
+		bool	alive;
+	};
+
+	struct EPAEdge {
+		int a;
+		int b;
+	};
+
+	struct Polytope {
+		SimplexVertex	vertices[MaxEPAVertices];
+		EPAFace			faces[MaxEPAFaces];
+		int				vertexCount = 0;
+		int				faceCount	= 0;
+
+		bool AddFace(int a, int b, int c) {
+			EPAFace* face = nullptr;
+			for (int i = 0; i < faceCount && !face; ++i) {
+				if (!faces[i].alive) {
+					face = &faces[i];
+				}
+			}
+			if (!face) {
+				if (faceCount == MaxEPAFaces) {
+					return false;
+				}
+				face = &faces[faceCount++];
+			}
+			Vector3 n = Vector3::Cross(vertices[b].w - vertices[a].w, vertices[c].w - vertices[a].w);
+			float length = n.Length();
+
+			face->v[0]		= a;
+			face->v[1]		= b;
+			face->v[2]		= c;
+			face->normal	= length > 0.0f ? n / length : Vector3(0, 1, 0);
+			face->distance	= length > 0.0f ? Vector3::Dot(face->normal, vertices[a].w) : FLT_MAX;
+			face->alive		= true;
+			return true;
+		}
+	};
+
+	void AddHorizonEdge(EPAEdge* edges, int& edgeCount, int a, int b) {
+		//An edge shared with another face that's being removed isn't on the horizon
+		for (int i = 0; i < edgeCount; ++i) {
+			if (edges[i].a == b && edges[i].b == a) {
+				edges[i] = edges[--edgeCount];
+				return;
+			}
+		}
+		if (edgeCount < MaxEPAEdges) {
+			edges[edgeCount++] = { a, b };
+		}
+	}
+
+	void GetBarycentric(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c, float& u, float& v, float& w) {
+		Vector3 v0 = b - a;
+		Vector3 v1 = c - a;
+		Vector3 v2 = p - a;
+		float d00 = Vector3::Dot(v0, v0);
+		float d01 = Vector3::Dot(v0, v1);
+		float d11 = Vector3::Dot(v1, v1);
+		float d20 = Vector3::Dot(v2, v0);
+		float d21 = Vector3::Dot(v2, v1);
+		float denom = d00 * d11 - d01 * d01;
+		if (std::abs(denom) <= TinyLengthSq) {
+			u = 1.0f;
+			v = 0.0f;
+			w = 0.0f;
+			return;
+		}
+		v = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+		u = 1.0f - v - w;
+	}
+
+	/*
+	Starting from a tetrahedron around the origin, keep pushing out the face
+	nearest the origin to the furthest point of A - B beyond it, until the
+	nearest face is on A - B's surface. How far that face is from the origin
+	is how deep the shapes overlap, and its normal is the way to part them.
+	*/
+	void ExpandPolytope(const ConvexShape& a, const ConvexShape& b, const Simplex& tetrahedron, GJKContact& contact) {
+		Polytope p;
+		for (int i = 0; i < 4; ++i) {
+			p.vertices[p.vertexCount++] = tetrahedron.v[i];
+		}
+		//Wind every face so its normal faces away from the tetrahedron's middle
+		Vector3 centre = (p.vertices[0].w + p.vertices[1].w + p.vertices[2].w + p.vertices[3].w) * 0.25f;
+		static const int startFaces[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+		for (const auto& f : startFaces) {
+			Vector3 n = Vector3::Cross(p.vertices[f[1]].w - p.vertices[f[0]].w, p.vertices[f[2]].w - p.vertices[f[0]].w);
+			if (Vector3::Dot(n, p.vertices[f[0]].w - centre) < 0.0f) {
+				p.AddFace(f[0], f[2], f[1]);
+			}
+			else {
+				p.AddFace(f[0], f[1], f[2]);
+			}
+		}
+
+		EPAEdge edges[MaxEPAEdges];
+		int closest = 0;
+		for (int iteration = 0; iteration < MaxEPAIterations; ++iteration) {
+			closest = -1;
+			for (int i = 0; i < p.faceCount; ++i) {
+				if (p.faces[i].alive && (closest < 0 || p.faces[i].distance < p.faces[closest].distance)) {
+					closest = i;
+				}
+			}
+			const EPAFace& face = p.faces[closest];
+			SimplexVertex w = GetSupport(a, b, face.normal, true);
+			if (Vector3::Dot(w.w, face.normal) - face.distance < EPATolerance * std::max(1.0f, face.distance)) {
+				break;
+			}
+			if (p.vertexCount == MaxEPAVertices) {
+				break;
+			}
+			int newVertex = p.vertexCount++;
+			p.vertices[newVertex] = w;
+
+			int edgeCount = 0;
+			for (int i = 0; i < p.faceCount; ++i) {
+				EPAFace& f = p.faces[i];
+				if (!f.alive || Vector3::Dot(f.normal, w.w - p.vertices[f.v[0]].w) <= 0.0f) {
+					continue;
+				}
+				f.alive = false;
+				AddHorizonEdge(edges, edgeCount, f.v[0], f.v[1]);
+				AddHorizonEdge(edges, edgeCount, f.v[1], f.v[2]);
+				AddHorizonEdge(edges, edgeCount, f.v[2], f.v[0]);
+			}
+			bool full = false;
+			for (int i = 0; i < edgeCount; ++i) {
+				full |= !p.AddFace(edges[i].a, edges[i].b, newVertex);
+			}
+			if (full) {
+				break;
+			}
+		}
+		if (closest < 0 || !p.faces[closest].alive) {
+			closest = 0;
+			for (int i = 1; i < p.faceCount; ++i) {
+				if (p.faces[i].alive && (!p.faces[closest].alive || p.faces[i].distance < p.faces[closest].distance)) {
+					closest = i;
+				}
+			}
+		}
+		const EPAFace& face = p.faces[closest];
+		const SimplexVertex& v0 = p.vertices[face.v[0]];
+		const SimplexVertex& v1 = p.vertices[face.v[1]];
+		const SimplexVertex& v2 = p.vertices[face.v[2]];
+
+		float u, v, w;
+		GetBarycentric(face.normal * face.distance, v0.w, v1.w, v2.w, u, v, w);
+
+		contact.normal		= face.normal;
+		contact.penetration = std::max(face.distance, 0.0f);
+		contact.pointA		= v0.a * u + v1.a * v + v2.a * w;
+		contact.pointB		= v0.b * u + v1.b * v + v2.b * w;
+	}
+
+	void StoreSimplex(const ConvexShape& a, const Simplex& s, GJKCache* cache) {
+		if (!cache) {
+			return;
+		}
+		for (int i = 0; i < s.count; ++i) {
+			cache->localA[i] = s.v[i].localA;
+			cache->localB[i] = s.v[i].localB;
+		}
+		cache->count	= s.count;
+		cache->volumeA	= a.GetVolume();
+	}
+}
+
+bool GJK::Intersect(const ConvexShape& a, const ConvexShape& b, GJKCache* cache, GJKContact& contact) {
+	Simplex s;
+
+	if (cache && cache->count > 0) {
+		bool flipped = cache->volumeA != a.GetVolume();
+		for (int i = 0; i < cache->count; ++i) {
+			SimplexVertex& v = s.v[i];
+			v.localA	= flipped ? cache->localB[i] : cache->localA[i];
+			v.localB	= flipped ? cache->localA[i] : cache->localB[i];
+			v.a			= a.ToWorld(v.localA);
+			v.b			= b.ToWorld(v.localB);
+			v.w			= v.a - v.b;
+		}
+		s.count = cache->count;
+	}
+	else {
+		Vector3 direction = b.GetPosition() - a.GetPosition();
+		if (direction.LengthSquared() <= TinyLengthSq) {
+			direction = Vector3(1, 0, 0);
+		}
+		s.v[0]	= GetSupport(a, b, direction, false);
+		s.count = 1;
+	}
+
+	//First the cores - if they don't touch, the closest points between them are all that's needed
+	bool	coresOverlap = false;
+	Vector3 closest;
+	for (int iteration = 0; iteration < MaxGJKIterations; ++iteration) {
+		if (!Solve(s, closest)) {
+			coresOverlap = true;
+			break;
+		}
+		float distSq = Vector3::Dot(closest, closest);
+		if (distSq <= TinyLengthSq) {
+			coresOverlap = true;
+			break;
+		}
+		SimplexVertex w = GetSupport(a, b, -closest, false);
+		if (distSq - Vector3::Dot(closest, w.w) <= GJKTolerance * distSq) {
+			break; //Nothing further towards the origin, so this is as close as they get
+		}
+		bool repeated = false;
+		for (int i = 0; i < s.count; ++i) {
+			repeated |= (s.v[i].w - w.w).LengthSquared() <= TinyLengthSq;
+		}
+		if (repeated) {
+			break;
+		}
+		s.v[s.count++] = w;
+	}
+	StoreSimplex(a, s, cache);
+
+	if (!coresOverlap) {
+		float distance	= closest.Length();
+		float margins	= a.GetMargin() + b.GetMargin();
+		if (distance >= margins) {
+			return false;
+		}
+		Vector3 pointA = s.GetPointA();
+		Vector3 pointB = s.GetPointB();
+
+		contact.normal		= -closest / distance;
+		contact.penetration = margins - distance;
+		contact.pointA		= pointA + contact.normal * a.GetMargin();
+		contact.pointB		= pointB - contact.normal * b.GetMargin();
+		return true;
+	}
+
+	if (!FillTetrahedron(a, b, s)) {
+		//Flat shapes can't be made into anything with volume - they're touching, but only just
+		contact.normal		= (b.GetPosition() - a.GetPosition()).Normalised();
+		contact.penetration = 0.0f;
+		contact.pointA		= s.GetPointA();
+		contact.pointB		= contact.pointA;
+		return true;
+	}
+	ExpandPolytope(a, b, s, contact);
+	return true;
+}
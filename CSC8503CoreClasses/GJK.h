@@ -0,0 +1,91 @@
+#pragma once
+#include "Vector3.h"
+#include "Matrix3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	class CollisionVolume;
+
+	namespace CSC8503 {
+		class Transform;
+
+		/*
+		What GJK remembers about a pair between steps - the simplex it
+		finished on, as points on each shape in that shape's own space. Next
+		step those points are moved to wherever the shapes are now, and GJK
+		starts from there rather than from nothing. If the objects have
+		hardly moved, that's all but the answer already.
+		*/
+		struct GJKCache {
+			Vector3 localA[4];
+			Vector3 localB[4];
+			int		count = 0;
+
+			const CollisionVolume* volumeA = nullptr;	//pairs can come round either way, so which one was A
+			int		lastStep = 0;
+		};
+
+		/*
+		A collision volume as GJK sees it. Spheres and capsules are a point
+		and a line with a margin around them - GJK finds the distance between
+		those exactly, and they only need EPA if they're so deep that even
+		their cores overlap.
+		*/
+		class ConvexShape {
+		public:
+			ConvexShape(const CollisionVolume& volume, const Transform& transform);
+
+			//The furthest point of the core along a world space direction, and where that is in the shape's space
+			Vector3 GetCoreSupport(const Vector3& direction, Vector3& localPoint) const;
+
+			Vector3 ToWorld(const Vector3& localPoint) const {
+				return position + rotation * localPoint;
+			}
+			Vector3 ToLocal(const Vector3& worldPoint) const {
+				return inverseRotation * (worldPoint - position);
+			}
+			Vector3 ToLocalDirection(const Vector3& direction) const {
+				return inverseRotation * direction;
+			}
+
+			const CollisionVolume* GetVolume() const {
+				return volume;
+			}
+			const Vector3& GetPosition() const {
+				return position;
+			}
+			float GetMargin() const {
+				return margin;
+			}
+
+		protected:
+			const CollisionVolume*	volume;
+			Vector3					position;
+			Matrix3					rotation;
+			Matrix3					inverseRotation;
+			Vector3					coreSize;	//half size of a box core, or y of a capsule's line
+			float					margin;
+		};
+
+		struct GJKContact {
+			Vector3 normal;			//from A to B
+			Vector3 pointA;			//world space, on each shape's surface
+			Vector3 pointB;
+			float	penetration;
+		};
+
+		/*
+		Gilbert-Johnson-Keerthi finds how close two convex shapes get, by
+		searching the shape you get by subtracting every point of one from
+		every point of the other for its closest point to the origin - and if
+		it contains the origin, they overlap. The Expanding Polytope Algorithm
+		then grows GJK's final simplex out to that shape's surface, to find
+		the shortest way to push them apart.
+		*/
+		class GJK {
+		public:
+			//The cache can be null, for one-off tests
+			static bool Intersect(const ConvexShape& a, const ConvexShape& b, GJKCache* cache, GJKContact& contact);
+		};
+	}
+}
@@ -50,6 +50,19 @@ void GameObject::UpdateBroadphaseAABB() {
 		Vector3 halfSizes = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
 		broadphaseAABB = mat * halfSizes;
 	}
+	else if (boundingVolume->type == VolumeType::Capsule) {
+		const CapsuleVolume& capsule = (CapsuleVolume&)*boundingVolume;
+		Vector3 axis = transform.GetOrientation() * Vector3(0, 1, 0) * (capsule.GetHalfHeight() - capsule.GetRadius());
+		float r = capsule.GetRadius();
+		broadphaseAABB = Vector3(std::abs(axis.x) + r, std::abs(axis.y) + r, std::abs(axis.z) + r);
+	}
+	else if (boundingVolume->type == VolumeType::Grid) {
+		broadphaseAABB = ((GridCollisionVolume&)*boundingVolume).GetHalfDimensions();
+	}
+	else if (boundingVolume->type == VolumeType::ConvexHull) {
+		Matrix3 mat = Matrix3(transform.GetOrientation()).Absolute();
+		broadphaseAABB = mat * ((ConvexHullVolume&)*boundingVolume).GetHalfDimensions();
+	}
 }
 
 Layer NCL::CSC8503::GameObject::getLayer() const{
@@ -80,6 +93,7 @@ GameObjectType NCL::CSC8503::GameObject::GetGameObjectType() const {
 
 void NCL::CSC8503::GameObject::SetGameObjectType(GameObjectType type) {
 	this->type = type;
+	collisionCategory = 1u << type;
 }
 
 bool GameObject::GetIsAffectedByGravity() const {
@@ -92,6 +92,11 @@ namespace NCL::CSC8503 {
 
 		void UpdateBroadphaseAABB();
 
+		//Grows the box to cover everywhere the object could get to with this move
+		void SweepBroadphaseAABB(const Vector3& motion) {
+			broadphaseAABB += Vector3(std::abs(motion.x), std::abs(motion.y), std::abs(motion.z));
+		}
+
 		void SetWorldID(int newID) {
 			worldID = newID;
 		}
@@ -105,12 +110,43 @@ namespace NCL::CSC8503 {
 
 
 		GameObjectType GetGameObjectType() const;
+		//Also puts the object in that type's collision layer
 		void SetGameObjectType(GameObjectType type);
 
+		//Collision layers are bit numbers - the category holds the layers
+		//an object is in, the mask the layers it's willing to touch. Both
+		//sides have to agree, as well as PhysicsSystem's layer matrix
+		unsigned int GetCollisionCategory() const {
+			return collisionCategory;
+		}
+
+		void SetCollisionCategory(unsigned int category) {
+			collisionCategory = category;
+		}
+
+		unsigned int GetCollisionMask() const {
+			return collisionMask;
+		}
+
+		void SetCollisionMask(unsigned int mask) {
+			collisionMask = mask;
+		}
+
 		void AttachToAnotherObj(GameObject& obj);
 
 		void SetCollisionCallback(std::function<void()> callback);
 
+		//Static geometry goes in the PhysicsSystem's static BVH instead of the
+		//broadphase, and is never integrated. It's only picked up when
+		//objects are added or removed, so set this before adding it
+		void SetStaticGeometry(bool state) {
+			isStaticGeometry = state;
+		}
+
+		bool IsStaticGeometry() const {
+			return isStaticGeometry;
+		}
+
 		bool GetIsAffectedByGravity() const;
 		void SetIsAffectedByGravity(bool isAffectedByGravity);
 
@@ -122,6 +158,8 @@ namespace NCL::CSC8503 {
 	protected:
 		Layer				layer = Layer::All;
 		GameObjectType      type = GameObjectType::Static;
+		unsigned int		collisionCategory	= 1u << GameObjectType::Static;
+		unsigned int		collisionMask		= ~0u;
 		Transform			transform;
 
 		CollisionVolume*	boundingVolume;
@@ -135,6 +173,7 @@ namespace NCL::CSC8503 {
 		bool        isAffectedByGravity = true;
 		bool		isAttached = false;
 		bool        isInteractable = true;
+		bool		isStaticGeometry = false;
 		int			worldID;
 		std::string	name;
 
@@ -3,6 +3,7 @@
 #include "Constraint.h"
 #include "CollisionDetection.h"
 #include "Camera.h"
+#include "ThreadPool.h"
 
 
 using namespace NCL;
@@ -13,6 +14,11 @@ GameWorld::GameWorld()	{
 	shuffleObjects		= false;
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+	constraintStateCounter = 0;
+	raycastOctree		= nullptr;
+	raycastTree			= nullptr;
+	raycastStaticTree	= nullptr;
+	raycastTreeState	= -1;
 }
 
 GameWorld::~GameWorld()	{
@@ -23,6 +29,10 @@ void GameWorld::Clear() {
 	constraints.clear();
 	worldIDCounter		= 0;
 	worldStateCounter	= 0;
+	constraintStateCounter++;
+	raycastOctree		= nullptr;
+	raycastTree			= nullptr;
+	raycastStaticTree	= nullptr;
 }
 
 void GameWorld::ClearAndErase() {
@@ -78,24 +88,66 @@ void GameWorld::UpdateWorld(float dt) {
 	}
 }
 
+/*
+Hands func every object a ray might hit, with the same protocol as
+Octree::RayCast. Static geometry goes first, as it's what usually blocks a
+ray, and a hit there lets the moving objects' tree skip everything behind it.
+*/
+template<class F>
+void GameWorld::VisitRayCandidates(const Ray& r, F&& func) const {
+	if (raycastTreeState != worldStateCounter || (!raycastOctree && !raycastTree)) {
+		for (auto& i : gameObjects) {
+			if (func(i) < 0.0f) {
+				return;
+			}
+		}
+		return;
+	}
+	float	closest = FLT_MAX;
+	bool	stopped = false;
+	auto visit = [&](GameObject* i) {
+		float distance = func(i);
+		stopped = distance < 0.0f;
+		if (!stopped) {
+			closest = std::min(closest, distance);
+		}
+		return distance;
+	};
+	if (raycastStaticTree) {
+		raycastStaticTree->RayCast(r, visit);
+	}
+	if (stopped) {
+		return;
+	}
+	if (raycastOctree) {
+		raycastOctree->RayCast(r, visit, closest);
+	}
+	else {
+		raycastTree->RayCast(r, visit, closest);
+	}
+}
+
 bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, GameObject* ignoreThis, Layer layer) const {
 	//The simplest raycast just goes through each object and sees if there's a collision
 	RayCollision collision;
+	bool foundFirst = false;
 
-	for (auto& i : gameObjects) {
+	//Returns the distance to keep searching up to, or a negative value to stop
+	auto testObject = [&](GameObject* i) -> float {
 		if (!i->GetBoundingVolume()) { //objects might not be collideable etc...
-			continue;
+			return collision.rayDistance;
 		}
 		if (i == ignoreThis) {
-			continue;
+			return collision.rayDistance;
 		}
 		RayCollision thisCollision;
 		if (CollisionDetection::RayIntersection(r, *i, thisCollision, layer)) {
 				
 			if (!closestObject) {	
-				closestCollision		= collision;
+				closestCollision		= thisCollision;
 				closestCollision.node = i;
-				return true;
+				foundFirst = true;
+				return -1.0f;
 			}
 			else {
 				if (thisCollision.rayDistance < collision.rayDistance) {
@@ -104,6 +156,13 @@ bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObje
 				}
 			}
 		}
+		return collision.rayDistance;
+	};
+
+	VisitRayCandidates(r, testObject);
+
+	if (foundFirst) {
+		return true;
 	}
 	if (collision.node) {
 		auto* collidedObject = static_cast<GameObject*>(collision.node);
@@ -118,6 +177,232 @@ bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObje
 	return false;
 }
 
+//Just like VisitRayCandidates, but for a whole packet at once
+template<class F>
+void GameWorld::VisitPacketCandidates(const RayPacket& packet, const float* closest, F&& func) const {
+	if (raycastTreeState != worldStateCounter || (!raycastOctree && !raycastTree)) {
+		for (auto& i : gameObjects) {
+			func(i, packet.activeLanes);
+		}
+		return;
+	}
+	if (raycastStaticTree) {
+		raycastStaticTree->RayCastPacket(packet, closest, func);
+	}
+	if (raycastOctree) {
+		raycastOctree->RayCastPacket(packet, closest, func);
+	}
+	else {
+		raycastTree->RayCastPacket(packet, closest, func);
+	}
+}
+
+/*
+Gives the same answers as a Raycast for each of the packet's rays. Spheres
+are tested against every lane at once - anything else falls back to the
+usual test, but only for the lanes whose rays actually reached its box.
+*/
+int GameWorld::RaycastPacket(const RayPacket& packet, RayCollision* hits, GameObject* ignore, Layer layer) const {
+	float closest[RayPacket::Width];
+	for (int lane = 0; lane < RayPacket::Width; ++lane) {
+		closest[lane] = FLT_MAX;
+	}
+	for (int lane = 0; lane < packet.count; ++lane) {
+		hits[lane] = RayCollision();
+	}
+
+	auto testObject = [&](GameObject* i, int lanes) {
+		const CollisionVolume* volume = i->GetBoundingVolume();
+		if (!volume || i == ignore) {
+			return;
+		}
+		if (volume->type == VolumeType::Sphere) {
+			Vector3 centre = i->GetTransform().GetPosition();
+			float	tHit[RayPacket::Width];
+			lanes &= packet.SphereTest(centre, ((const SphereVolume&)*volume).GetRadius(), closest, tHit);
+			for (int lane = 0; lane < packet.count; ++lane) {
+				if (lanes & (1 << lane)) {
+					closest[lane]				= tHit[lane];
+					hits[lane].node				= i;
+					hits[lane].rayDistance		= tHit[lane];
+					hits[lane].collidedAt		= Vector3(packet.posX[lane], packet.posY[lane], packet.posZ[lane])
+												+ Vector3(packet.dirX[lane], packet.dirY[lane], packet.dirZ[lane]) * tHit[lane];
+				}
+			}
+			return;
+		}
+		for (int lane = 0; lane < packet.count; ++lane) {
+			if (!(lanes & (1 << lane))) {
+				continue;
+			}
+			RayCollision collision;
+			if (CollisionDetection::RayIntersection(packet.GetRay(lane), *i, collision, layer) && collision.rayDistance < closest[lane]) {
+				collision.node	= i;
+				hits[lane]		= collision;
+				closest[lane]	= collision.rayDistance;
+			}
+		}
+	};
+	VisitPacketCandidates(packet, closest, testObject);
+
+	//Like Raycast, a ray stopped by something on the wrong layer hits nothing
+	int hitCount = 0;
+	for (int lane = 0; lane < packet.count; ++lane) {
+		GameObject* hitObject = static_cast<GameObject*>(hits[lane].node);
+		if (!hitObject) {
+			continue;
+		}
+		if (layer != Layer::All && layer != hitObject->getLayer()) {
+			hits[lane] = RayCollision();
+			continue;
+		}
+		hitCount++;
+	}
+	return hitCount;
+}
+
+int GameWorld::RaycastBatch(const Ray* rays, int count, RayCollision* hits, GameObject* ignore, Layer layer, ThreadPool* pool) const {
+	auto castRange = [&](int first, int last) {
+		int hitCount = 0;
+		for (int i = first; i < last; i += RayPacket::Width) {
+			RayPacket packet(rays + i, std::min(RayPacket::Width, last - i));
+			hitCount += RaycastPacket(packet, hits + i, ignore, layer);
+		}
+		return hitCount;
+	};
+	if (!pool) {
+		return castRange(0, count);
+	}
+	//Each range counts its own hits, so the threads never share a counter
+	const int minRange = 16;
+	std::vector<int> rangeHits(pool->GetThreadCount(), 0);
+	pool->ParallelFor(count, minRange, [&](int first, int last, int range) {
+		rangeHits[range] = castRange(first, last);
+	});
+	int hitCount = 0;
+	for (int h : rangeHits) {
+		hitCount += h;
+	}
+	return hitCount;
+}
+
+
+/*
+Hands func every object whose box might overlap the given one, until func
+returns false. Like the raycasts, this goes through the physics' trees
+whenever they're up to date with the world's contents.
+*/
+template<class F>
+void GameWorld::VisitBoxCandidates(const Vector3& minBounds, const Vector3& maxBounds, F&& func) const {
+	if (raycastTreeState != worldStateCounter || (!raycastOctree && !raycastTree)) {
+		for (auto& i : gameObjects) {
+			if (!func(i)) {
+				return;
+			}
+		}
+		return;
+	}
+	bool stopped = false;
+	auto visit = [&](GameObject* i) {
+		stopped = !func(i);
+		return !stopped;
+	};
+	if (raycastStaticTree) {
+		raycastStaticTree->Query(minBounds, maxBounds, visit);
+		if (stopped) {
+			return;
+		}
+	}
+	if (raycastOctree) {
+		//The octree can't stop part way, so the rest of its objects are just skipped
+		raycastOctree->QueryAABB((minBounds + maxBounds) * 0.5f, (maxBounds - minBounds) * 0.5f, [&](GameObject* i) {
+			if (!stopped) {
+				visit(i);
+			}
+		});
+	}
+	else {
+		raycastTree->Query(minBounds, maxBounds, [&](int proxy) {
+			return visit(raycastTree->GetObject(proxy));
+		});
+	}
+}
+
+int GameWorld::Overlap(const CollisionVolume& volume, const Transform& transform, const Vector3& halfSize, GameObject** results, int maxResults, Layer layer, GameObject* ignore) const {
+	int found = 0;
+	if (maxResults <= 0) {
+		return 0;
+	}
+	Vector3 centre = transform.GetPosition();
+	VisitBoxCandidates(centre - halfSize, centre + halfSize, [&](GameObject* i) {
+		const CollisionVolume* otherVolume = i->GetBoundingVolume();
+		if (!otherVolume || i == ignore || (layer != Layer::All && i->getLayer() != layer)) {
+			return true;
+		}
+		CollisionDetection::CollisionInfo info;
+		if (CollisionDetection::VolumeIntersection(*otherVolume, i->GetTransform(), volume, transform, info)) {
+			results[found++] = i;
+		}
+		return found < maxResults;
+	});
+	return found;
+}
+
+int GameWorld::OverlapSphere(const Vector3& centre, float radius, GameObject** results, int maxResults, Layer layer, GameObject* ignore) const {
+	SphereVolume sphere(radius);
+	Transform transform;
+	transform.SetPosition(centre);
+	return Overlap((CollisionVolume&)sphere, transform, Vector3(radius, radius, radius), results, maxResults, layer, ignore);
+}
+
+int GameWorld::OverlapAABB(const Vector3& centre, const Vector3& halfSize, GameObject** results, int maxResults, Layer layer, GameObject* ignore) const {
+	AABBVolume box(halfSize);
+	Transform transform;
+	transform.SetPosition(centre);
+	return Overlap((CollisionVolume&)box, transform, halfSize, results, maxResults, layer, ignore);
+}
+
+int GameWorld::OverlapCapsule(const Vector3& centre, const Quaternion& orientation, float halfHeight, float radius, GameObject** results, int maxResults, Layer layer, GameObject* ignore) const {
+	CapsuleVolume capsule(halfHeight, radius);
+	Transform transform;
+	transform.SetPosition(centre).SetOrientation(orientation);
+
+	Vector3 axis = orientation * Vector3(0, 1, 0) * (halfHeight - radius);
+	Vector3 halfSize(std::abs(axis.x) + radius, std::abs(axis.y) + radius, std::abs(axis.z) + radius);
+	return Overlap((CollisionVolume&)capsule, transform, halfSize, results, maxResults, layer, ignore);
+}
+
+//Every object whose box the sweep passes near is swept against on its own, keeping the closest
+bool GameWorld::SweepSphere(const Vector3& start, float radius, const Vector3& direction, float maxDistance, RayCollision& hit, Layer layer, GameObject* ignore) const {
+	Vector3 end		= start + direction * maxDistance;
+	Vector3 extent	= Vector3(radius, radius, radius);
+
+	float		closest = maxDistance;
+	GameObject* closestObject = nullptr;
+	Vector3		closestNormal;
+
+	VisitBoxCandidates(Vector3::Min(start, end) - extent, Vector3::Max(start, end) + extent, [&](GameObject* i) {
+		if (!i->GetBoundingVolume() || i == ignore || (layer != Layer::All && i->getLayer() != layer)) {
+			return true;
+		}
+		float	distance;
+		Vector3 normal;
+		if (CollisionDetection::SphereSweep(start, radius, direction, closest, *i, distance, normal) && distance < closest) {
+			closest			= distance;
+			closestObject	= i;
+			closestNormal	= normal;
+		}
+		return true;
+	});
+
+	if (!closestObject) {
+		return false;
+	}
+	hit.node		= closestObject;
+	hit.rayDistance	= closest;
+	hit.collidedAt	= start + direction * closest - closestNormal * radius;
+	return true;
+}
 
 /*
 Constraint Tutorial Stuff
@@ -125,6 +410,7 @@ Constraint Tutorial Stuff
 
 void GameWorld::AddConstraint(Constraint* c) {
 	constraints.emplace_back(c);
+	constraintStateCounter++;
 }
 
 void GameWorld::RemoveConstraint(Constraint* c, bool andDelete) {
@@ -132,6 +418,7 @@ void GameWorld::RemoveConstraint(Constraint* c, bool andDelete) {
 	if (andDelete) {
 		delete c;
 	}
+	constraintStateCounter++;
 }
 
 void GameWorld::GetConstraintIterators(
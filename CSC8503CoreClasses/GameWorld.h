@@ -4,12 +4,17 @@
 #include "Ray.h"
 #include "CollisionDetection.h"
 #include "QuadTree.h"
+#include "Octree.h"
+#include "DynamicAABBTree.h"
+#include "StaticBVH.h"
+#include "RayPacket.h"
 namespace NCL {
 		class Camera;
 		using Maths::Ray;
 	namespace CSC8503 {
 		class GameObject;
 		class Constraint;
+		class ThreadPool;
 
 		typedef std::function<void(GameObject*)> GameObjectFunc;
 		typedef std::vector<GameObject*>::const_iterator GameObjectIterator;
@@ -42,6 +47,33 @@ namespace NCL {
 
 			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, GameObject* ignore = nullptr, Layer layer = Layer::All) const;
 
+			/*
+			Casts a whole array of rays in one go, leaving hits[i] holding the
+			closest thing rays[i] hit, or a null node if it missed. The rays go
+			through the world in packets of four, and given a pool the packets
+			are split across its threads. Returns how many of the rays hit
+			something - so it's the quickest way to make lots of line of sight
+			checks at once.
+			*/
+			int RaycastBatch(const Ray* rays, int count, RayCollision* hits, GameObject* ignore = nullptr, Layer layer = Layer::All, ThreadPool* pool = nullptr) const;
+
+			/*
+			Overlap queries fill results with up to maxResults objects whose
+			collision volumes overlap the given shape, and return how many they
+			found. They look the objects up through the same trees as Raycast,
+			and never allocate, so they're fine to call every frame.
+			*/
+			int OverlapSphere(const Vector3& centre, float radius, GameObject** results, int maxResults, Layer layer = Layer::All, GameObject* ignore = nullptr) const;
+			int OverlapAABB(const Vector3& centre, const Vector3& halfSize, GameObject** results, int maxResults, Layer layer = Layer::All, GameObject* ignore = nullptr) const;
+			int OverlapCapsule(const Vector3& centre, const Quaternion& orientation, float halfHeight, float radius, GameObject** results, int maxResults, Layer layer = Layer::All, GameObject* ignore = nullptr) const;
+
+			/*
+			Moves a sphere from start along direction (which should be normalised),
+			and reports the first object it would touch within maxDistance - hit's
+			rayDistance is how far the sphere got, and collidedAt is where it touched.
+			*/
+			bool SweepSphere(const Vector3& start, float radius, const Vector3& direction, float maxDistance, RayCollision& hit, Layer layer = Layer::All, GameObject* ignore = nullptr) const;
+
 			virtual void UpdateWorld(float dt);
 
 			void OperateOnContents(GameObjectFunc f);
@@ -58,7 +90,47 @@ namespace NCL {
 				return worldStateCounter;
 			}
 
+			//Changes whenever a constraint is added or removed. Unlike the
+			//world state, Clear doesn't reset it
+			int GetConstraintStateID() const {
+				return constraintStateCounter;
+			}
+
+			/*
+			Lets Raycast use a spatial tree kept up to date by someone else (the
+			PhysicsSystem). The tree is only trusted while the world's contents are
+			the same as when it was built - otherwise we fall back to a linear scan.
+			Static geometry is left out of the octree, so it comes with the static
+			tree holding the rest of the world.
+			*/
+			void SetRaycastOctree(const Octree<GameObject*>* tree, const StaticBVH<GameObject*>* staticTree = nullptr) {
+				raycastOctree		= tree;
+				raycastTree			= nullptr;
+				raycastStaticTree	= staticTree;
+				raycastTreeState	= worldStateCounter;
+			}
+
+			//As above, but for the broadphase's AABB tree
+			void SetRaycastTree(const DynamicAABBTree<GameObject*>* tree, const StaticBVH<GameObject*>* staticTree = nullptr) {
+				raycastOctree		= nullptr;
+				raycastTree			= tree;
+				raycastStaticTree	= staticTree;
+				raycastTreeState	= worldStateCounter;
+			}
+
 		protected:
+			template<class F>
+			void VisitRayCandidates(const Ray& r, F&& func) const;
+			template<class F>
+			void VisitPacketCandidates(const RayPacket& packet, const float* closest, F&& func) const;
+
+			int RaycastPacket(const RayPacket& packet, RayCollision* hits, GameObject* ignore, Layer layer) const;
+
+			template<class F>
+			void VisitBoxCandidates(const Vector3& minBounds, const Vector3& maxBounds, F&& func) const;
+
+			int Overlap(const CollisionVolume& volume, const Transform& transform, const Vector3& halfSize, GameObject** results, int maxResults, Layer layer, GameObject* ignore) const;
+
 			std::vector<GameObject*> gameObjects;
 			std::vector<Constraint*> constraints;
 
@@ -68,6 +140,12 @@ namespace NCL {
 			bool shuffleObjects;
 			int		worldIDCounter;
 			int		worldStateCounter;
+			int		constraintStateCounter;
+
+			const Octree<GameObject*>*			raycastOctree;
+			const DynamicAABBTree<GameObject*>*	raycastTree;
+			const StaticBVH<GameObject*>*		raycastStaticTree;
+			int									raycastTreeState;
 		};
 	}
 }
@@ -0,0 +1,35 @@
+#include "GridCollisionVolume.h"
+#include "NavigationGrid.h"
+#include <cmath>
+
+using namespace NCL;
+using namespace CSC8503;
+
+GridCollisionVolume::GridCollisionVolume(NavigationGrid& grid, char solidType, float cellHeight) {
+	type		= VolumeType::Grid;
+	width		= grid.GetNavGridWidth();
+	depth		= grid.GetNavGridHeight();
+	cellSize	= (float)grid.GetNavGridSize();
+	cellHalfHeight = (cellHeight > 0.0f ? cellHeight : cellSize) * 0.5f;
+	solidCount	= 0;
+
+	GridNode* nodes = grid.GetAllNodes();
+	solid.resize(width * depth, 0);
+	for (int i = 0; i < width * depth; ++i) {
+		if ((char)nodes[i].type == solidType) {
+			solid[i] = 1;
+			solidCount++;
+		}
+	}
+	//Nodes sit in the middle of their cells, starting from the first one
+	Vector3 origin = width * depth > 0 ? nodes[0].position : Vector3();
+	gridCentre = origin + Vector3(width * cellSize * 0.5f - cellSize * 0.5f, 0.0f, depth * cellSize * 0.5f - cellSize * 0.5f);
+}
+
+int GridCollisionVolume::GetCellX(float localX) const {
+	return (int)std::floor((localX + width * cellSize * 0.5f) / cellSize);
+}
+
+int GridCollisionVolume::GetCellZ(float localZ) const {
+	return (int)std::floor((localZ + depth * cellSize * 0.5f) / cellSize);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "CollisionVolume.h"
+#include "Vector3.h"
+#include <vector>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		class NavigationGrid;
+	}
+
+	/*
+	A whole NavigationGrid as a single collider - every cell of the wall
+	type becomes a solid block, and everything else is empty space. The
+	grid is axis aligned, and its GameObject's position is the centre of
+	the grid, which GetGridCentre works out from the nodes' positions.
+
+	As the cells are all the same size, the cells something overlaps can
+	be found with a divide rather than a search, so a maze costs the same
+	to collide against however big it gets.
+	*/
+	class GridCollisionVolume : public CollisionVolume
+	{
+	public:
+		//cellHeight is the full height of each block, and defaults to the node size
+		GridCollisionVolume(CSC8503::NavigationGrid& grid, char solidType = 'x', float cellHeight = 0.0f);
+		~GridCollisionVolume() {
+
+		}
+
+		int GetWidth() const {
+			return width;
+		}
+
+		int GetDepth() const {
+			return depth;
+		}
+
+		float GetCellSize() const {
+			return cellSize;
+		}
+
+		Vector3 GetCellHalfSize() const {
+			return Vector3(cellSize * 0.5f, cellHalfHeight, cellSize * 0.5f);
+		}
+
+		//Half the size of the whole grid, for the broadphase
+		Vector3 GetHalfDimensions() const {
+			return Vector3(width * cellSize * 0.5f, cellHalfHeight, depth * cellSize * 0.5f);
+		}
+
+		//Where the grid's GameObject should go to line up with the grid's nodes
+		Vector3 GetGridCentre() const {
+			return gridCentre;
+		}
+
+		//Anything off the edge of the grid is empty
+		bool IsSolid(int x, int z) const {
+			if (x < 0 || z < 0 || x >= width || z >= depth) {
+				return false;
+			}
+			return solid[(z * width) + x] != 0;
+		}
+
+		int GetSolidCount() const {
+			return solidCount;
+		}
+
+		//Which column / row a position relative to the grid's centre falls in - may be off the grid
+		int GetCellX(float localX) const;
+		int GetCellZ(float localZ) const;
+
+		//The centre of a cell, relative to the grid's centre
+		Vector3 GetCellPosition(int x, int z) const {
+			return Vector3((x + 0.5f) * cellSize - width * cellSize * 0.5f, 0.0f, (z + 0.5f) * cellSize - depth * cellSize * 0.5f);
+		}
+
+	protected:
+		std::vector<char>	solid;
+		Vector3				gridCentre;
+		float				cellSize;
+		float				cellHalfHeight;
+		int					width;
+		int					depth;
+		int					solidCount;
+	};
+}
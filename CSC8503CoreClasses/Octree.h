@@ -0,0 +1,349 @@
+#pragma once
+#include "Vector3.h"
+#include "Ray.h"
+#include "CollisionDetection.h"
+#include "RayPacket.h"
+#include <algorithm>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		template<class T>
+		struct OctreeEntry {
+			Vector3 pos;
+			Vector3 size;
+			T		object;
+		};
+
+		template<class T>
+		using OctreeFunc = std::function<void(std::list<OctreeEntry<T>>&)>;
+
+		/*
+		A 'loose' octree - every node's bounds are stretched by the looseness
+		factor, so an object never has to be split across several nodes. Each
+		entry goes into exactly one node, picked from its centre and its size,
+		which makes insertion a single walk down the tree with no splitting or
+		redistributing of contents. Queries don't use the loose bounds though
+		- every node also tracks the exact box around everything beneath it,
+		which culls far more. Like the FlatQuadTree, all nodes live in one
+		array (the eight children of a node sit next to each other) and
+		Clear() keeps every buffer's capacity for the next refill.
+		*/
+		template<class T>
+		class Octree {
+		public:
+			//Deep enough for any sensible world - the traversals below keep their
+			//stacks on the C++ stack, and each level can add up to 7 more nodes to them
+			static constexpr int MaxDepth	= 32;
+			static constexpr int StackSize	= MaxDepth * 7 + 1;
+
+			Octree(Vector3 size, int maxDepth = 6, float looseness = 2.0f) {
+				this->size		= size;
+				this->maxDepth	= std::clamp(maxDepth, 0, MaxDepth);
+				this->looseness = looseness;
+				Clear();
+			}
+			~Octree() {
+			}
+
+			void Clear() {
+				entries.clear();
+				if (nodes.empty()) {
+					nodes.resize(1);
+				}
+				nodeCount = 1;
+				ResetNode(0, Vector3(), size);
+			}
+
+			/*
+			An entry can go down into a child as long as it would still fit
+			inside the child's loose bounds from anywhere in the child, ie its
+			size is no bigger than the child's size times (looseness - 1).
+			Anything whose centre lies outside the tree entirely stays in the
+			root, so nothing is ever lost.
+			*/
+			void Insert(T object, const Vector3& pos, const Vector3& size) {
+				int index = (int)entries.size();
+				entries.push_back({ pos, size, object });
+
+				Vector3 minBounds	= pos - size;
+				Vector3 maxBounds	= pos + size;
+				float objectSize	= size.GetMaxElement();
+				int node			= 0;
+				GrowBounds(node, minBounds, maxBounds);
+
+				if (!Contains(nodes[0].position, nodes[0].size, pos)) {
+					nodes[0].contents.push_back(index);
+					return;
+				}
+
+				for (int depth = 0; depth < maxDepth; ++depth) {
+					Vector3 childSize = nodes[node].size / 2.0f;
+					if (objectSize > childSize.GetMinElement() * (looseness - 1.0f)) {
+						break;
+					}
+					if (nodes[node].firstChild == -1) {
+						Split(node);
+					}
+					node = nodes[node].firstChild + ChildIndex(nodes[node].position, pos);
+					GrowBounds(node, minBounds, maxBounds);
+				}
+				nodes[node].contents.push_back(index);
+			}
+
+			void OperateOnContents(OctreeFunc<T> func) {
+				std::list<OctreeEntry<T>> list;
+				for (int n = 0; n < nodeCount; ++n) {
+					const std::vector<int>& contents = nodes[n].contents;
+					if (contents.empty()) {
+						continue;
+					}
+					list.clear();
+					for (int i : contents) {
+						list.push_back(entries[i]);
+					}
+					func(list);
+				}
+			}
+
+			/*
+			Calls func with every object whose box overlaps the given box.
+			*/
+			template<class F>
+			void QueryAABB(const Vector3& pos, const Vector3& halfSize, F&& func) const {
+				QueryEntries(pos, halfSize, [&](int entry) {
+					func(entries[entry].object);
+				});
+			}
+
+			/*
+			Walks the nodes the ray passes through, nearest first. func is called
+			with each object whose box the ray hits, and returns the distance of
+			the object's actual hit (or FLT_MAX if it missed) - nodes and boxes
+			further away than the closest hit so far are skipped. Returning a
+			negative value from func stops the raycast there and then.
+			*/
+			template<class F>
+			void RayCast(const Ray& r, F&& func, float maxDistance = FLT_MAX) const {
+				Vector3 rayPos	= r.GetPosition();
+				Vector3 rayDir	= r.GetDirection();
+				Vector3 invDir	= Vector3(1.0f / rayDir.x, 1.0f / rayDir.y, 1.0f / rayDir.z);
+
+				float closest = maxDistance;
+				float tEnter;
+
+				if (!CollisionDetection::RaySlabTest(rayPos, invDir, nodes[0].minBounds, nodes[0].maxBounds, closest, tEnter)) {
+					return;
+				}
+
+				std::pair<float, int> stack[StackSize];
+				int count = 0;
+				stack[count++] = { tEnter, 0 };
+
+				while (count > 0) {
+					auto [nodeDistance, index] = stack[--count];
+					if (nodeDistance > closest) {
+						continue;
+					}
+					const OctreeNode& node = nodes[index];
+
+					for (int i : node.contents) {
+						const OctreeEntry<T>& e = entries[i];
+						if (!CollisionDetection::RaySlabTest(rayPos, invDir, e.pos - e.size, e.pos + e.size, closest, tEnter)) {
+							continue;
+						}
+						float hitDistance = func(e.object);
+						if (hitDistance < 0.0f) {
+							return;
+						}
+						closest = std::min(closest, hitDistance);
+					}
+
+					if (node.firstChild == -1) {
+						continue;
+					}
+					//Push the children furthest first, so the nearest gets popped next
+					int firstPushed = count;
+					for (int i = 0; i < 8; ++i) {
+						const OctreeNode& child = nodes[node.firstChild + i];
+						if (child.IsEmpty()) {
+							continue;
+						}
+						if (CollisionDetection::RaySlabTest(rayPos, invDir, child.minBounds, child.maxBounds, closest, tEnter)) {
+							stack[count++] = { tEnter, node.firstChild + i };
+						}
+					}
+					std::sort(stack + firstPushed, stack + count, [](const auto& a, const auto& b) {
+						return a.first > b.first;
+					});
+				}
+			}
+
+			//Works just like DynamicAABBTree::RayCastPacket
+			template<class F>
+			void RayCastPacket(const RayPacket& packet, const float* closest, F&& func) const {
+				float tEnter[RayPacket::Width];
+
+				//Children nearest the first ray's origin get pushed last, so they're visited first
+				int flip = (packet.dirX[0] < 0.0f ? 1 : 0) | (packet.dirY[0] < 0.0f ? 2 : 0) | (packet.dirZ[0] < 0.0f ? 4 : 0);
+
+				int stack[StackSize];
+				int count = 0;
+				stack[count++] = 0;
+
+				while (count > 0) {
+					const OctreeNode& node = nodes[stack[--count]];
+					if (node.IsEmpty() || packet.SlabTest(node.minBounds, node.maxBounds, closest, tEnter) == 0) {
+						continue;
+					}
+					for (int i : node.contents) {
+						const OctreeEntry<T>& e = entries[i];
+						int lanes = packet.SlabTest(e.pos - e.size, e.pos + e.size, closest, tEnter);
+						if (lanes != 0) {
+							func(e.object, lanes);
+						}
+					}
+					if (node.firstChild != -1) {
+						for (int i = 7; i >= 0; --i) {
+							stack[count++] = node.firstChild + (i ^ flip);
+						}
+					}
+				}
+			}
+
+			/*
+			Writes every pair of overlapping entries into the given buffer. As
+			entries only ever live in one node, each entry just queries the tree
+			with its own box and keeps the partners with a higher index, so every
+			pair comes out exactly once with no sorting needed.
+			*/
+			void GetCandidatePairs(std::vector<std::pair<T, T>>& pairs) const {
+				pairs.clear();
+				for (int i = 0; i < (int)entries.size(); ++i) {
+					const OctreeEntry<T>& a = entries[i];
+					QueryEntries(a.pos, a.size, [&](int j) {
+						if (j > i) {
+							pairs.emplace_back(a.object, entries[j].object);
+						}
+					});
+				}
+			}
+
+			int GetNodeCount() const {
+				return nodeCount;
+			}
+
+			int GetEntryCount() const {
+				return (int)entries.size();
+			}
+
+		protected:
+			struct OctreeNode {
+				Vector3				position;
+				Vector3				size;
+				int					firstChild;
+				std::vector<int>	contents;
+
+				//The union of every entry in this subtree - far tighter than the
+				//loose bounds for culling, and empty (min > max) if there are none
+				Vector3				minBounds;
+				Vector3				maxBounds;
+
+				bool IsEmpty() const {
+					return minBounds.x > maxBounds.x;
+				}
+			};
+
+			static bool Contains(const Vector3& nodePos, const Vector3& nodeSize, const Vector3& point) {
+				Vector3 delta = point - nodePos;
+				return	std::abs(delta.x) <= nodeSize.x &&
+						std::abs(delta.y) <= nodeSize.y &&
+						std::abs(delta.z) <= nodeSize.z;
+			}
+
+			static int ChildIndex(const Vector3& nodePos, const Vector3& point) {
+				return	(point.x >= nodePos.x ? 1 : 0) |
+						(point.y >= nodePos.y ? 2 : 0) |
+						(point.z >= nodePos.z ? 4 : 0);
+			}
+
+			template<class F>
+			void QueryEntries(const Vector3& pos, const Vector3& halfSize, F&& func) const {
+				Vector3 minBounds = pos - halfSize;
+				Vector3 maxBounds = pos + halfSize;
+
+				int stack[StackSize];
+				int count = 0;
+				stack[count++] = 0;
+
+				while (count > 0) {
+					const OctreeNode& node = nodes[stack[--count]];
+					if (!Overlaps(node.minBounds, node.maxBounds, minBounds, maxBounds)) {
+						continue;
+					}
+					for (int i : node.contents) {
+						const OctreeEntry<T>& e = entries[i];
+						if (CollisionDetection::AABBTest(pos, e.pos, halfSize, e.size)) {
+							func(i);
+						}
+					}
+					if (node.firstChild != -1) {
+						for (int i = 0; i < 8; ++i) {
+							stack[count++] = node.firstChild + i;
+						}
+					}
+				}
+			}
+
+			static bool Overlaps(const Vector3& minA, const Vector3& maxA, const Vector3& minB, const Vector3& maxB) {
+				return	minA.x <= maxB.x && maxA.x >= minB.x &&
+						minA.y <= maxB.y && maxA.y >= minB.y &&
+						minA.z <= maxB.z && maxA.z >= minB.z;
+			}
+
+			void GrowBounds(int index, const Vector3& minBounds, const Vector3& maxBounds) {
+				nodes[index].minBounds = Vector3::Min(nodes[index].minBounds, minBounds);
+				nodes[index].maxBounds = Vector3::Max(nodes[index].maxBounds, maxBounds);
+			}
+
+			void ResetNode(int index, const Vector3& pos, const Vector3& halfSize) {
+				OctreeNode& node = nodes[index];
+				node.position	= pos;
+				node.size		= halfSize;
+				node.firstChild	= -1;
+				node.contents.clear();
+				node.minBounds	= Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+				node.maxBounds	= Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			}
+
+			void Split(int index) {
+				int firstChild = nodeCount;
+				nodeCount += 8;
+				if ((int)nodes.size() < nodeCount) {
+					nodes.resize(nodeCount);
+				}
+
+				Vector3 pos			= nodes[index].position;
+				Vector3 halfSize	= nodes[index].size / 2.0f;
+
+				for (int i = 0; i < 8; ++i) {
+					Vector3 offset(
+						(i & 1) ? halfSize.x : -halfSize.x,
+						(i & 2) ? halfSize.y : -halfSize.y,
+						(i & 4) ? halfSize.z : -halfSize.z
+					);
+					ResetNode(firstChild + i, pos + offset, halfSize);
+				}
+				nodes[index].firstChild = firstChild;
+			}
+
+			std::vector<OctreeNode>			nodes;
+			std::vector<OctreeEntry<T>>		entries;
+
+			int		nodeCount;
+			Vector3 size;
+			int		maxDepth;
+			float	looseness;
+		};
+	}
+}
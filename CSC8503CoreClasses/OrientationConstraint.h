@@ -13,6 +13,11 @@ namespace NCL {
 
 			void UpdateConstraint(float dt) override;
 
+			void GetConstrainedObjects(GameObject*& a, GameObject*& b) const override {
+				a = objectA;
+				b = objectB;
+			}
+
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
@@ -17,19 +17,24 @@ PhysicsObject::~PhysicsObject()	{
 
 }
 
+//Anything that pushes an object will wake it back up
 void PhysicsObject::ApplyAngularImpulse(const Vector3& force) {
+	Wake();
 	angularVelocity += inverseInteriaTensor * force;
 }
 
 void PhysicsObject::ApplyLinearImpulse(const Vector3& force) {
+	Wake();
 	linearVelocity += force * inverseMass;
 }
 
 void PhysicsObject::AddForce(const Vector3& addedForce) {
+	Wake();
 	force += addedForce;
 }
 
 void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3& position) {
+	Wake();
 	Vector3 localPos = position - transform->GetPosition();
 
 	force  += addedForce;
@@ -37,9 +42,19 @@ void PhysicsObject::AddForceAtPosition(const Vector3& addedForce, const Vector3&
 }
 
 void PhysicsObject::AddTorque(const Vector3& addedTorque) {
+	Wake();
 	torque += addedTorque;
 }
 
+//A sleeping object is left exactly where it is until something wakes it
+void PhysicsObject::Sleep() {
+	isAsleep		= true;
+	linearVelocity	= Vector3();
+	angularVelocity	= Vector3();
+	force			= Vector3();
+	torque			= Vector3();
+}
+
 void PhysicsObject::ClearForces() {
 	force				= Vector3();
 	torque				= Vector3();
@@ -36,6 +36,22 @@ namespace NCL {
 				return inverseMass;
 			}
 
+			void SetElasticity(float e) {
+				elasticity = e;
+			}
+
+			float GetElasticity() const {
+				return elasticity;
+			}
+
+			void SetFriction(float f) {
+				friction = f;
+			}
+
+			float GetFriction() const {
+				return friction;
+			}
+
 			void ApplyAngularImpulse(const Vector3& force);
 			void ApplyLinearImpulse(const Vector3& force);
 			
@@ -62,10 +78,69 @@ namespace NCL {
 
 			void UpdateInertiaTensor();
 
+			//Per axis, in the object's own space
+			Vector3 GetInverseInertia() const {
+				return inverseInertia;
+			}
+
 			Matrix3 GetInertiaTensor() const {
 				return inverseInteriaTensor;
 			}
 
+			//For the RigidBodyStore, which keeps its own copy up to date as the object turns
+			void SetInertiaTensor(const Matrix3& tensor) {
+				inverseInteriaTensor = tensor;
+			}
+
+			bool IsAsleep() const {
+				return isAsleep;
+			}
+
+			//An object that's already awake keeps its sleep timer, as the
+			//contact solver pushes on resting objects every step
+			void Wake() {
+				if (isAsleep) {
+					isAsleep	= false;
+					sleepTimer	= 0.0f;
+				}
+			}
+
+			void Sleep();
+
+			float GetSleepTimer() const {
+				return sleepTimer;
+			}
+
+			void SetSleepTimer(float t) {
+				sleepTimer = t;
+			}
+
+			//Small, fast objects that could pass right through something thin in
+			//one step are swept along their path, and stopped where they'd hit
+			void SetContinuousCollision(bool state) {
+				continuousCollision = state;
+			}
+
+			bool HasContinuousCollision() const {
+				return continuousCollision;
+			}
+
+			int GetIslandIndex() const {
+				return islandIndex;
+			}
+
+			void SetIslandIndex(int index) {
+				islandIndex = index;
+			}
+
+			int GetBodySlot() const {
+				return bodySlot;
+			}
+
+			void SetBodySlot(int slot) {
+				bodySlot = slot;
+			}
+
 		protected:
 			const CollisionVolume* volume;
 			Transform*		transform;
@@ -83,6 +158,14 @@ namespace NCL {
 			Vector3 torque;
 			Vector3 inverseInertia;
 			Matrix3 inverseInteriaTensor;
+
+			//sleeping
+			bool	isAsleep	= false;
+			float	sleepTimer	= 0.0f;	//how long we've been slow enough to sleep
+			int		islandIndex	= -1;	//scratch space for PhysicsSystem::UpdateIslands
+			int		bodySlot	= -1;	//where we are in PhysicsSystem's RigidBodyStore
+
+			bool	continuousCollision = false;
 		};
 	}
 }
@@ -0,0 +1,194 @@
+#include "PhysicsProfiler.h"
+#include "Debug.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	float MillisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+		auto now = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<float, std::milli>(now - start).count();
+	}
+}
+
+PhysicsProfiler::ScopedTimer::ScopedTimer(PhysicsProfiler& p, PhysicsPhase phase) : profiler(p), phase(phase) {
+	if (profiler.enabled) {
+		start = std::chrono::high_resolution_clock::now();
+	}
+}
+
+PhysicsProfiler::ScopedTimer::~ScopedTimer() {
+	if (profiler.enabled) {
+		profiler.AddTime(phase, MillisecondsSince(start));
+	}
+}
+
+PhysicsProfiler::PhysicsProfiler(int historySize) {
+	history.resize(std::max(1, historySize));
+}
+
+void PhysicsProfiler::Clear() {
+	current			= PhysicsFrameProfile();
+	historyNext		= 0;
+	historyCount	= 0;
+}
+
+void PhysicsProfiler::BeginFrame() {
+	current		= PhysicsFrameProfile();
+	frameStart	= std::chrono::high_resolution_clock::now();
+}
+
+void PhysicsProfiler::EndFrame() {
+	if (!enabled) {
+		return;
+	}
+	current.totalTime = MillisecondsSince(frameStart);
+
+	history[historyNext] = current;
+	historyNext	 = (historyNext + 1) % (int)history.size();
+	historyCount = std::min(historyCount + 1, (int)history.size());
+}
+
+const PhysicsFrameProfile& PhysicsProfiler::GetFrame(int framesAgo) const {
+	int index = historyNext - 1 - framesAgo;
+	index = (index % (int)history.size() + (int)history.size()) % (int)history.size();
+	return history[index];
+}
+
+PhysicsFrameProfile PhysicsProfiler::GetAverage() const {
+	PhysicsFrameProfile average;
+	if (historyCount == 0) {
+		return average;
+	}
+	//Counters are summed as floats so the average doesn't get truncated along the way
+	float counterSums[(int)PhysicsCounter::Count] = {};
+	for (int i = 0; i < historyCount; ++i) {
+		const PhysicsFrameProfile& frame = GetFrame(i);
+		for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+			average.phaseTimes[p] += frame.phaseTimes[p];
+		}
+		for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+			counterSums[c] += (float)frame.counters[c];
+		}
+		average.totalTime += frame.totalTime;
+	}
+	float scale = 1.0f / historyCount;
+	for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+		average.phaseTimes[p] *= scale;
+	}
+	for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+		average.counters[c] = (int)std::round(counterSums[c] * scale);
+	}
+	average.totalTime *= scale;
+	return average;
+}
+
+const char* PhysicsProfiler::GetPhaseName(PhysicsPhase phase) {
+	switch (phase) {
+		case PhysicsPhase::SyncBodies:			return "SyncBodies";
+		case PhysicsPhase::UpdateAABBs:			return "UpdateAABBs";
+		case PhysicsPhase::IntegrateAccel:		return "IntegrateAccel";
+		case PhysicsPhase::BroadPhase:			return "BroadPhase";
+		case PhysicsPhase::NarrowPhase:			return "NarrowPhase";
+		case PhysicsPhase::SolveContacts:		return "SolveContacts";
+		case PhysicsPhase::Constraints:			return "Constraints";
+		case PhysicsPhase::IntegrateVelocity:	return "IntegrateVelocity";
+		case PhysicsPhase::Islands:				return "Islands";
+		case PhysicsPhase::WriteBack:			return "WriteBack";
+		case PhysicsPhase::CollisionList:		return "CollisionList";
+		case PhysicsPhase::RaycastTree:			return "RaycastTree";
+		case PhysicsPhase::Count:				break;
+	}
+	return "Unknown";
+}
+
+const char* PhysicsProfiler::GetCounterName(PhysicsCounter counter) {
+	switch (counter) {
+		case PhysicsCounter::Objects:				return "Objects";
+		case PhysicsCounter::Ticks:					return "Ticks";
+		case PhysicsCounter::CandidatePairs:		return "CandidatePairs";
+		case PhysicsCounter::FilteredPairs:			return "FilteredPairs";
+		case PhysicsCounter::Contacts:				return "Contacts";
+		case PhysicsCounter::ConstraintIterations:	return "ConstraintIterations";
+		case PhysicsCounter::SleepingBodies:		return "SleepingBodies";
+		case PhysicsCounter::Count:					break;
+	}
+	return "Unknown";
+}
+
+void PhysicsProfiler::DrawSummary(const Vector2& pos) const {
+	PhysicsFrameProfile average = GetAverage();
+	const float lineHeight = 3.0f;
+	Vector2 linePos = pos;
+
+	std::stringstream	stream;
+	stream << std::fixed << std::setprecision(2);
+	auto printLine = [&](const Vector4& colour) {
+		Debug::Print(stream.str(), linePos, colour);
+		stream.str("");
+		linePos.y += lineHeight;
+	};
+
+	stream << "Physics: " << average.totalTime << "ms (" << historyCount << " frame avg)";
+	printLine(Debug::YELLOW);
+	for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+		stream << GetPhaseName((PhysicsPhase)p) << ": " << average.phaseTimes[p] << "ms";
+		printLine(Debug::WHITE);
+	}
+	for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+		stream << GetCounterName((PhysicsCounter)c) << ": " << average.counters[c];
+		printLine(Debug::CYAN);
+	}
+}
+
+bool PhysicsProfiler::SaveCSV(const std::string& filename) const {
+	std::ofstream file(filename);
+	if (!file) {
+		return false;
+	}
+	file << "frame,totalMS";
+	for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+		file << "," << GetPhaseName((PhysicsPhase)p) << "MS";
+	}
+	for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+		file << "," << GetCounterName((PhysicsCounter)c);
+	}
+	file << "\n";
+
+	for (int i = historyCount - 1; i >= 0; --i) {
+		const PhysicsFrameProfile& frame = GetFrame(i);
+		file << (historyCount - 1 - i) << "," << frame.totalTime;
+		for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+			file << "," << frame.phaseTimes[p];
+		}
+		for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+			file << "," << frame.counters[c];
+		}
+		file << "\n";
+	}
+	return true;
+}
+
+bool PhysicsProfiler::SaveJSON(const std::string& filename) const {
+	std::ofstream file(filename);
+	if (!file) {
+		return false;
+	}
+	file << "{\n\t\"frames\": [\n";
+	for (int i = historyCount - 1; i >= 0; --i) {
+		const PhysicsFrameProfile& frame = GetFrame(i);
+		file << "\t\t{ \"totalMS\": " << frame.totalTime;
+		for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+			file << ", \"" << GetPhaseName((PhysicsPhase)p) << "MS\": " << frame.phaseTimes[p];
+		}
+		for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+			file << ", \"" << GetCounterName((PhysicsCounter)c) << "\": " << frame.counters[c];
+		}
+		file << (i > 0 ? " },\n" : " }\n");
+	}
+	file << "\t]\n}\n";
+	return true;
+}
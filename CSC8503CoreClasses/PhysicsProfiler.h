@@ -0,0 +1,115 @@
+#pragma once
+#include <chrono>
+
+namespace NCL {
+	namespace CSC8503 {
+		enum class PhysicsPhase {
+			SyncBodies,		//Reading the RigidBodyStore back from the objects, once a frame
+			UpdateAABBs,
+			IntegrateAccel,
+			BroadPhase,
+			NarrowPhase,
+			SolveContacts,
+			Constraints,
+			IntegrateVelocity,
+			Islands,
+			WriteBack,		//Interpolating or rebuilding matrices
+			CollisionList,
+			RaycastTree,	//Leaving a tree for raycasts between updates
+			Count
+		};
+
+		enum class PhysicsCounter {
+			Objects,
+			Ticks,
+			CandidatePairs,		//Pairs the broadphase handed to the narrowphase
+			FilteredPairs,		//Pairs the collision layers or static checks threw away
+			Contacts,			//Pairs the narrowphase found touching
+			ConstraintIterations,
+			SleepingBodies,
+			Count
+		};
+
+		//Everything we measured over one call to PhysicsSystem::Update
+		struct PhysicsFrameProfile {
+			float	phaseTimes[(int)PhysicsPhase::Count]	= {};	//milliseconds
+			int		counters[(int)PhysicsCounter::Count]	= {};
+			float	totalTime								= 0.0f;
+		};
+
+		/*
+		Times each phase of the physics update, and keeps a rolling history
+		of the last few hundred frames so we can see what an optimisation
+		actually bought us. Phases are timed with a ScopedTimer, which adds
+		on to the current frame, so a phase run once per tick adds up to
+		its whole cost for the frame.
+		*/
+		class PhysicsProfiler	{
+		public:
+			class ScopedTimer	{
+			public:
+				ScopedTimer(PhysicsProfiler& p, PhysicsPhase phase);
+				~ScopedTimer();
+			protected:
+				PhysicsProfiler&	profiler;
+				PhysicsPhase		phase;
+				std::chrono::high_resolution_clock::time_point start;
+			};
+
+			PhysicsProfiler(int historySize = 300);
+
+			void SetEnabled(bool state) {
+				enabled = state;
+			}
+
+			bool IsEnabled() const {
+				return enabled;
+			}
+
+			void BeginFrame();
+			void EndFrame();
+			void Clear();
+
+			void AddTime(PhysicsPhase phase, float ms) {
+				current.phaseTimes[(int)phase] += ms;
+			}
+
+			void SetCounter(PhysicsCounter counter, int value) {
+				current.counters[(int)counter] = value;
+			}
+
+			void AddCounter(PhysicsCounter counter, int value) {
+				current.counters[(int)counter] += value;
+			}
+
+			int GetHistoryCount() const {
+				return historyCount;
+			}
+
+			//0 is the most recent frame
+			const PhysicsFrameProfile& GetFrame(int framesAgo) const;
+
+			PhysicsFrameProfile GetAverage() const;
+
+			static const char* GetPhaseName(PhysicsPhase phase);
+			static const char* GetCounterName(PhysicsCounter counter);
+
+			//Prints the averages through Debug::Print, starting at pos and going down
+			void DrawSummary(const Maths::Vector2& pos) const;
+
+			//One row/entry per frame in the history, oldest first
+			bool SaveCSV(const std::string& filename) const;
+			bool SaveJSON(const std::string& filename) const;
+
+		protected:
+			bool enabled = true;
+
+			PhysicsFrameProfile current;
+			std::chrono::high_resolution_clock::time_point frameStart;
+
+			std::vector<PhysicsFrameProfile>	history;
+			int									historyNext		= 0;
+			int									historyCount	= 0;
+		};
+	}
+}
@@ -9,19 +9,22 @@
 #include "Debug.h"
 #include "Window.h"
 #include <functional>
+#include <bit>
+#include <array>
 using namespace NCL;
 using namespace CSC8503;
 
-PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g) {
+PhysicsSystem::PhysicsSystem(GameWorld& g, BroadPhaseType broadPhase, int workerThreads) : gameWorld(g), quadTree(Vector2(1024, 1024), 7, 6), octree(Vector3(1024, 1024, 1024), 7), workerPool(workerThreads) {
 	applyGravity = false;
-	useBroadPhase = false;
-	dTOffset = 0.0f;
+	SetBroadPhaseType(broadPhase);
 	globalDamping = 0.995f;
 	SetGravity(Vector3(0.0f, -9.8f, 0.0f));
 	dampingFactor = .4f;
+	std::fill(std::begin(layerMatrix), std::end(layerMatrix), ~0u);
 }
 
 PhysicsSystem::~PhysicsSystem() {
+	gameWorld.SetRaycastOctree(nullptr);
 }
 
 void PhysicsSystem::SetGravity(const Vector3& g) {
@@ -39,113 +42,329 @@ any collisions they are in.
 
 */
 void PhysicsSystem::Clear() {
-	allCollisions.clear();
+	allCollisions.Clear();
+	broadphaseCollisions.clear();
+	ResetBroadPhaseState();
+	bodyStore.Clear();
+	constraintSolver.Clear();
+	convexCaches.clear();
+	tickScheduler.Reset();
+	sleepStats = SleepStats();
 }
 
-/*
+void PhysicsSystem::SetBroadPhaseType(BroadPhaseType type) {
+	broadPhaseType	= type;
+	useBroadPhase	= type != BroadPhaseType::None;
+	broadphaseCollisions.clear();
+	ResetBroadPhaseState();
+	gameWorld.SetRaycastOctree(nullptr);
+}
 
-This is the core of the physics engine update
+const char* PhysicsSystem::GetBroadPhaseName(BroadPhaseType type) {
+	switch (type) {
+		case BroadPhaseType::None:			return "None";
+		case BroadPhaseType::QuadTree:		return "QuadTree";
+		case BroadPhaseType::AABBTree:		return "AABBTree";
+		case BroadPhaseType::SweepAndPrune:	return "SweepAndPrune";
+		case BroadPhaseType::Octree:		return "Octree";
+	}
+	return "Unknown";
+}
 
+void PhysicsSystem::SetLayerCollisions(int layerA, int layerB, bool state) {
+	if (state) {
+		layerMatrix[layerA] |= 1u << layerB;
+		layerMatrix[layerB] |= 1u << layerA;
+	}
+	else {
+		layerMatrix[layerA] &= ~(1u << layerB);
+		layerMatrix[layerB] &= ~(1u << layerA);
+	}
+}
+
+bool PhysicsSystem::GetLayerCollisions(int layerA, int layerB) const {
+	return (layerMatrix[layerA] & (1u << layerB)) != 0;
+}
+
+/*
+Decides whether a pair is worth handing to the narrowphase at all. Two
+objects that can't be moved can't be pushed apart either, so there's no
+point testing them - in the maze, that's most of the pairs there are.
+Otherwise each object has to be in a layer the other's mask accepts, and
+at least one pairing of their layers has to be allowed by the matrix.
 */
+bool PhysicsSystem::ShouldTestPair(const GameObject* a, const GameObject* b) const {
+	const PhysicsObject* physA = a->GetPhysicsObject();
+	const PhysicsObject* physB = b->GetPhysicsObject();
+	bool staticA = !physA || physA->GetInverseMass() == 0.0f || a->IsStaticGeometry();
+	bool staticB = !physB || physB->GetInverseMass() == 0.0f || b->IsStaticGeometry();
+	if (staticA && staticB) {
+		return false;
+	}
 
-bool useSimpleContainer = false;
+	unsigned int categoryA = a->GetCollisionCategory();
+	unsigned int categoryB = b->GetCollisionCategory();
+	if (!(categoryA & b->GetCollisionMask()) || !(categoryB & a->GetCollisionMask())) {
+		return false;
+	}
+	for (unsigned int layers = categoryA; layers; layers &= layers - 1) {
+		if (layerMatrix[std::countr_zero(layers)] & categoryB) {
+			return true;
+		}
+	}
+	return false;
+}
 
-int constraintIterationCount = 10;
+void PhysicsSystem::AddBroadPhasePair(GameObject* a, GameObject* b) {
+	if (!ShouldTestPair(a, b)) {
+		profiler.AddCounter(PhysicsCounter::FilteredPairs, 1);
+		return;
+	}
+	//Ordered by world ID rather than address, so a world steps the same
+	//however its objects happened to land in memory
+	if (a->GetWorldID() > b->GetWorldID()) {
+		std::swap(a, b);
+	}
+	CollisionDetection::CollisionInfo info;
+	info.a = a;
+	info.b = b;
+	broadphaseCollisions.push_back(info);
+}
 
-//This is the fixed timestep we'd LIKE to have
-const int   idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
+void PhysicsSystem::UseSleeping(bool state) {
+	useSleeping = state;
+	if (!useSleeping) {
+		WakeAll();
+	}
+}
 
 /*
-This is the fixed update we actually have...
-If physics takes too long it starts to kill the framerate, it'll drop the
-iteration count down until the FPS stabilises, even if that ends up
-being at a low rate.
+
+This is the core of the physics engine update
+
 */
-int realHZ = idealHZ;
-float realDT = idealDT;
 
-void PhysicsSystem::Update(float dt) {
+//Debug controls for whoever is at the keyboard
+void PhysicsSystem::UpdateKeys() {
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
+		int next = ((int)broadPhaseType + 1) % ((int)BroadPhaseType::Octree + 1);
+		SetBroadPhaseType((BroadPhaseType)next);
+		std::cout << "Setting broadphase to " << GetBroadPhaseName(broadPhaseType) << std::endl;
 	}
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::N)) {
 		useSimpleContainer = !useSimpleContainer;
 		std::cout << "Setting broad container to " << useSimpleContainer << std::endl;
 	}
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::I)) {
-		constraintIterationCount--;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
+		SetConstraintIterations(constraintIterations - 1);
+		std::cout << "Setting constraint iterations to " << constraintIterations << std::endl;
 	}
 	if (Window::GetKeyboard()->KeyPressed(KeyCodes::O)) {
-		constraintIterationCount++;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
+		SetConstraintIterations(constraintIterations + 1);
+		std::cout << "Setting constraint iterations to " << constraintIterations << std::endl;
+	}
+
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F5)) {
+		drawProfile = !drawProfile;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyCodes::F6)) {
+		if (profiler.SaveCSV("PhysicsProfile.csv") && profiler.SaveJSON("PhysicsProfile.json")) {
+			std::cout << "Saved physics profile to PhysicsProfile.csv and PhysicsProfile.json" << std::endl;
+		}
+		else {
+			std::cout << "Couldn't save physics profile!" << std::endl;
+		}
 	}
+}
 
-	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
+void PhysicsSystem::Update(float dt) {
+	//There's no keyboard when running headless (ie in the benchmarks)
+	if (useKeyboardControls && Window::GetKeyboard()) {
+		UpdateKeys();
+	}
+
+	profiler.BeginFrame();
 
 	GameTimer t;
 	t.GetTimeDeltaSeconds();
 
-	if (useBroadPhase) {
+	sleepStats.sleepEvents	= 0;
+	sleepStats.wakeEvents	= 0;
+	sleepStats.skippedPairs	= 0;
+
+	//Physics always steps by the same amount, however long the frame was.
+	//Leftover time carries on to the next frame, and is what we interpolate by
+	int ticks = tickScheduler.Advance(dt);
+
+	//The integrator's copy of every body is only read back from the objects
+	//once a frame, whatever the game did to them since the last one
+	if (ticks > 0) {
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::SyncBodies);
+		std::vector<GameObject*>::const_iterator first;
+		std::vector<GameObject*>::const_iterator last;
+		gameWorld.GetObjectIterators(first, last);
+		bodyStore.SyncBodies(first, last, gameWorld.GetWorldStateID());
+		bodyStore.BeginFrame();
+	}
+	if (ticks > 0 && useBroadPhase) {
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::UpdateAABBs);
+		SyncStaticTree();
 		UpdateObjectAABBs();
 	}
-	int iteratorCount = 0;
-	while (dTOffset > realDT) {
-		IntegrateAccel(realDT); //Update accelerations from external forces
-		if (useBroadPhase) {
-			BroadPhase();
-			NarrowPhase();
+	for (int i = 0; i < ticks; ++i) {
+		if (useInterpolation && i == ticks - 1) {
+			StorePreviousPoses();
+		}
+		Step(tickScheduler.GetTickTime());
+	}
+
+	//Hand the velocities back, and reset the forces now we've finished with them
+	if (ticks > 0) {
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::SyncBodies);
+		bodyStore.EndFrame();
+	}
+
+	//Objects only need their matrices rebuilt once a frame
+	{
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::WriteBack);
+		if (useInterpolation) {
+			if (interpolationWorldState != gameWorld.GetWorldStateID()) {
+				ResetInterpolation();
+			}
+			bodyStore.InterpolateTransforms(tickScheduler.GetAlpha());
 		}
 		else {
-			BasicCollisionDetection();
+			bodyStore.WriteBackTransforms();
 		}
+	}
 
-		//This is our simple iterative solver - 
-		//we just run things multiple times, slowly moving things forward
-		//and then rechecking that the constraints have been met		
-		float constraintDt = realDT / (float)constraintIterationCount;
-		for (int i = 0; i < constraintIterationCount; ++i) {
-			UpdateConstraints(constraintDt);
-		}
-		IntegrateVelocity(realDT); //update positions from new velocity changes
+	if (ticks > 0) {
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::CollisionList);
+		UpdateCollisionList(); //Remove any old collisions
+	}
 
-		dTOffset -= realDT;
-		iteratorCount++;
+	//Leave a tree matching where everything ended up, so that raycasts
+	//made before the next update see the same world we just simulated
+	if (ticks > 0) {
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::RaycastTree);
+		UpdateRaycastTree();
 	}
 
-	ClearForces();	//Once we've finished with the forces, reset them to zero
+	t.Tick();
+	tickScheduler.RecordTickCost(t.GetTimeDeltaSeconds());
 
-	UpdateCollisionList(); //Remove any old collisions
+	GameObjectIterator first;
+	GameObjectIterator last;
+	gameWorld.GetObjectIterators(first, last);
+	profiler.SetCounter(PhysicsCounter::Objects, (int)(last - first));
+	profiler.SetCounter(PhysicsCounter::Ticks, ticks);
+	profiler.SetCounter(PhysicsCounter::ConstraintIterations, ticks * constraintIterations);
+	profiler.SetCounter(PhysicsCounter::SleepingBodies, sleepStats.sleepingBodies);
+	profiler.EndFrame();
+
+	if (drawProfile) {
+		profiler.DrawSummary(Vector2(60, 5));
+	}
+}
 
-	t.Tick();
-	float updateTime = t.GetTimeDeltaSeconds();
+/*
+One fixed length step of the whole simulation
+*/
+void PhysicsSystem::Step(float dt) {
+	stepCount++;
+	{
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::IntegrateAccel);
+		IntegrateAccel(dt); //Update accelerations from external forces
+	}
+	if (useBroadPhase) {
+		{
+			PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::BroadPhase);
+			BroadPhase();
+		}
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::NarrowPhase);
+		NarrowPhase();
+	}
+	else {
+		//Without a broadphase, every pair gets the full test, so it all counts as narrowphase
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::NarrowPhase);
+		BasicCollisionDetection();
+	}
+	{
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::SolveContacts);
+		SolveContacts();
+	}
 
-	//Uh oh, physics is taking too long...
-	if (updateTime > realDT) {
-		realHZ /= 2;
-		realDT *= 2;
-		std::cout << "Dropping iteration count due to long physics time...(now " << realHZ << ")\n";
+	//This is our simple iterative solver -
+	//we just run things multiple times, slowly moving things forward
+	//and then rechecking that the constraints have been met
+	float constraintDt = dt / (float)constraintIterations;
+	{
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::Constraints);
+		CopyConstrainedBodiesOut();
+		if (useParallelConstraints) {
+			UpdateColouredConstraints(constraintDt, constraintIterations);
+		}
+		else {
+			for (int i = 0; i < constraintIterations; ++i) {
+				UpdateConstraints(constraintDt);
+			}
+		}
+		CopyConstrainedBodiesIn();
+	}
+	{
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::IntegrateVelocity);
+		if (useContinuousCollision) {
+			SweepFastBodies(dt);
+		}
+		IntegrateVelocity(dt); //update positions from new velocity changes
+		StopFastBodies();
 	}
-	else if (dt * 2 < realDT) { //we have plenty of room to increase iteration count!
-		int temp = realHZ;
-		realHZ *= 2;
-		realDT /= 2;
 
-		if (realHZ > idealHZ) {
-			realHZ = idealHZ;
-			realDT = idealDT;
+	if (useSleeping) {
+		PhysicsProfiler::ScopedTimer timer(profiler, PhysicsPhase::Islands);
+		UpdateIslands(dt);
+	}
+}
+
+/*
+Every physics object remembers where it was before the last step of the
+frame, so the renderer can draw it partway between there and where it is now
+*/
+void PhysicsSystem::StorePreviousPoses() {
+	gameWorld.OperateOnContents(
+		[](GameObject* o) {
+			if (o->GetPhysicsObject() && !o->IsStaticGeometry()) {
+				o->GetTransform().StorePreviousPose();
+			}
 		}
-		if (temp != realHZ) {
-			std::cout << "Raising iteration count due to short physics time...(now " << realHZ << ")\n";
+	);
+}
+
+//Objects may have been removed from the world, so we can't trust the list
+//of transforms being interpolated - just snap everything to where it is
+void PhysicsSystem::ResetInterpolation() {
+	bodyStore.ResetInterpolation();
+	gameWorld.OperateOnContents(
+		[](GameObject* o) {
+			if (o->GetPhysicsObject()) {
+				o->GetTransform().StorePreviousPose();
+				o->GetTransform().UpdateMatrix();
+			}
 		}
+	);
+	interpolationWorldState = gameWorld.GetWorldStateID();
+}
+
+void PhysicsSystem::UseInterpolation(bool state) {
+	useInterpolation = state;
+	if (!useInterpolation) {
+		bodyStore.WriteBackTransforms();
 	}
 }
 
 /*
 Later on we're going to need to keep track of collisions
-across multiple frames, so we store them in a set.
+across multiple frames, so we store them in the contact cache.
 
 The first time they are added, we tell the objects they are colliding.
 The frame they are to be removed, we tell them they're no longer colliding.
@@ -155,19 +374,23 @@ OnCollisionBegin / OnCollisionEnd functions (removing health when hit by a
 rocket launcher, gaining a point when the player hits the gold coin, and so on).
 */
 void PhysicsSystem::UpdateCollisionList() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
-		if ((*i).framesLeft == numCollisionFrames && i->a->GetIsInteractable() && i->b->GetIsInteractable()) {
-			i->a->OnCollisionBegin(i->b);
-			i->b->OnCollisionBegin(i->a);
+	for (int i = 0; i < allCollisions.Size(); ) {
+		CachedContact& contact = allCollisions[i];
+		CollisionDetection::CollisionInfo& in = contact.info;
+		if (!contact.hasBegun) {
+			if (in.a->GetIsInteractable() && in.b->GetIsInteractable()) {
+				in.a->OnCollisionBegin(in.b);
+				in.b->OnCollisionBegin(in.a);
+			}
+			contact.hasBegun = true;
 		}
 
-		CollisionDetection::CollisionInfo& in = const_cast<CollisionDetection::CollisionInfo&>(*i);
 		in.framesLeft--;
 
-		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
-			i = allCollisions.erase(i);
+		if (in.framesLeft < 0) {
+			in.a->OnCollisionEnd(in.b);
+			in.b->OnCollisionEnd(in.a);
+			allCollisions.RemoveAt(i); //the last contact moves into slot i
 		}
 		else {
 			++i;
@@ -175,10 +398,21 @@ void PhysicsSystem::UpdateCollisionList() {
 	}
 }
 
+//Static geometry had its box worked out when it went into the static tree. Fast
+//bodies' boxes cover a whole step's movement, so the broadphase finds whatever
+//they might hit on the way, not just what they're touching now
 void PhysicsSystem::UpdateObjectAABBs() {
+	float tickTime = tickScheduler.GetTickTime();
 	gameWorld.OperateOnContents(
-		[](GameObject* g) {
+		[&](GameObject* g) {
+			if (g->IsStaticGeometry()) {
+				return;
+			}
 			g->UpdateBroadphaseAABB();
+			PhysicsObject* phys = g->GetPhysicsObject();
+			if (useContinuousCollision && phys && phys->HasContinuousCollision()) {
+				g->SweepBroadphaseAABB(phys->GetLinearVelocity() * tickTime);
+			}
 		}
 	);
 }
@@ -207,15 +441,26 @@ void PhysicsSystem::BasicCollisionDetection() {
 				continue;
 			}
 
+			if (!ShouldTestPair(*i, *j)) {
+				profiler.AddCounter(PhysicsCounter::FilteredPairs, 1);
+				continue;
+			}
+
+			if (IsPairAsleep(*i, *j)) {
+				CollisionDetection::CollisionInfo info;
+				info.a = *i;
+				info.b = *j;
+				KeepSleepingContact(info);
+				continue;
+			}
+
+			profiler.AddCounter(PhysicsCounter::CandidatePairs, 1);
 			CollisionDetection::CollisionInfo info;
 			if (CollisionDetection::ObjectIntersection(*i, *j, info)) {
-				if (((*i)->GetGameObjectType() == GameObjectType::Player && (*j)->GetGameObjectType() == GameObjectType::Throwable) || ((*j)->GetGameObjectType() == GameObjectType::Player && (*i)->GetGameObjectType() == GameObjectType::Throwable)) {
-					return;
-				}
 				//std::cout << "Collision between" << (*i)->GetName() << " and " << (*j)->GetName() << std::endl;
-				ImpulseResolveCollision(*info.a, *info.b, info.point);
 				info.framesLeft = numCollisionFrames;
-				allCollisions.insert(info);
+				allCollisions.Insert(info).manifold.Update(info, stepCount);
+				profiler.AddCounter(PhysicsCounter::Contacts, 1);
 			}
 
 		}
@@ -227,50 +472,157 @@ void PhysicsSystem::BasicCollisionDetection() {
 In tutorial 5, we start determining the correct response to a collision,
 so that objects separate back out.
 
-*/
-void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, CollisionDetection::ContactPoint& p) const {
-	PhysicsObject* physA = a.GetPhysicsObject();
-	PhysicsObject* physB = b.GetPhysicsObject();
-
-	Transform& transformA = a.GetTransform();
-	Transform& transformB = b.GetTransform();
+Rather than resolving each contact once, we now solve every contact point
+found this step together, a few times over, much like the constraints. Each
+point remembers the total impulse it has applied, which lets us clamp the
+total rather than each little correction - a point can pull back some of
+an earlier push, but never pull the objects together overall. Those totals
+are kept for the next step too, so a resting stack starts off already
+holding itself up, rather than having to find that again every step.
 
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+Friction pushes against sliding along the contact, but never harder than
+the friction coefficient times the push holding the objects together.
+*/
+void PhysicsSystem::SolveContacts() {
+	solverContacts.clear();
 
-	if (totalMass == 0)
-		return;
+	for (CachedContact& contact : allCollisions) {
+		ContactManifold& manifold = contact.manifold;
+		if (manifold.lastStep != stepCount || manifold.pointCount == 0) {
+			continue;
+		}
+		GameObject* a = manifold.objectA;
+		GameObject* b = manifold.objectB;
 
-	transformA.SetPosition(transformA.GetPosition() - (p.normal * p.penetration * (physA->GetInverseMass() / totalMass)));
-	transformB.SetPosition(transformB.GetPosition() + (p.normal * p.penetration * (physB->GetInverseMass() / totalMass)));
+		PhysicsObject* physA = a->GetPhysicsObject();
+		PhysicsObject* physB = b->GetPhysicsObject();
 
-	Vector3 relativeA = p.localA;
-	Vector3 relativeB = p.localB;
+		float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+		int slotA = bodyStore.FindSlot(*physA);
+		int slotB = bodyStore.FindSlot(*physB);
+		if (totalMass == 0 || slotA < 0 || slotB < 0) {
+			continue;
+		}
+		//Anything being pushed is woken up, the same as an impulse on the PhysicsObject would
+		physA->Wake();
+		physB->Wake();
+
+		Transform& transformA = a->GetTransform();
+		Transform& transformB = b->GetTransform();
+
+		//Push the objects back apart first, by the deepest point. We leave
+		//them overlapping by a hair, or resting objects would end up just
+		//touching, stop counting as colliding, and fall for a step
+		float penetration = 0.0f;
+		for (int i = 0; i < manifold.pointCount; ++i) {
+			penetration = std::max(penetration, manifold.points[i].penetration - penetrationSlop);
+		}
+		const Vector3& normal = manifold.normal;
+		transformA.SetPosition(transformA.GetPosition() - (normal * penetration * (physA->GetInverseMass() / totalMass)));
+		transformB.SetPosition(transformB.GetPosition() + (normal * penetration * (physB->GetInverseMass() / totalMass)));
+		bodyStore.SetPosition(*physA, transformA.GetPosition());
+		bodyStore.SetPosition(*physB, transformB.GetPosition());
 
-	Vector3 angVelocityA = Vector3::Cross(physA->GetAngularVelocity(), relativeA);
-	Vector3 angVelocityB = Vector3::Cross(physB->GetAngularVelocity(), relativeB);
+		//AABBs can't turn to match their object, so contacts mustn't spin them
+		bool rotateA = a->GetBoundingVolume()->type != VolumeType::AABB;
+		bool rotateB = b->GetBoundingVolume()->type != VolumeType::AABB;
 
-	Vector3 fullVelocityA = physA->GetLinearVelocity() + angVelocityA;
-	Vector3 fullVelocityB = physB->GetLinearVelocity() + angVelocityB;
+		Matrix3 inertiaA = rotateA ? bodyStore.GetInertiaTensor(slotA) : Matrix3::Scale(Vector3());
+		Matrix3 inertiaB = rotateB ? bodyStore.GetInertiaTensor(slotB) : Matrix3::Scale(Vector3());
 
-	Vector3 contactVelocity = fullVelocityB - fullVelocityA;
+		Quaternion orientationA = transformA.GetOrientation();
+		Quaternion orientationB = transformB.GetOrientation();
 
+		float elasticity	= physA->GetElasticity() * physB->GetElasticity();
+		float friction		= std::sqrt(physA->GetFriction() * physB->GetFriction());
 
-	float impulseForce = Vector3::Dot(contactVelocity, p.normal);
+		Vector3 tangents[2];
+		if (std::abs(normal.x) > 0.57735f) {
+			tangents[0] = Vector3(normal.y, -normal.x, 0.0f).Normalised();
+		}
+		else {
+			tangents[0] = Vector3(0.0f, normal.z, -normal.y).Normalised();
+		}
+		tangents[1] = Vector3::Cross(normal, tangents[0]);
+
+		auto effectiveMass = [&](const Vector3& relativeA, const Vector3& relativeB, const Vector3& axis) {
+			Vector3 angularA = Vector3::Cross(inertiaA * Vector3::Cross(relativeA, axis), relativeA);
+			Vector3 angularB = Vector3::Cross(inertiaB * Vector3::Cross(relativeB, axis), relativeB);
+			float k = totalMass + Vector3::Dot(angularA + angularB, axis);
+			return k > 0.0f ? 1.0f / k : 0.0f;
+		};
+
+		for (int i = 0; i < manifold.pointCount; ++i) {
+			SolverContact sc;
+			sc.slotA	= slotA;
+			sc.slotB	= slotB;
+			sc.point	= &manifold.points[i];
+			sc.rotateA	= rotateA;
+			sc.rotateB	= rotateB;
+
+			sc.relativeA	= orientationA * sc.point->localA;
+			sc.relativeB	= orientationB * sc.point->localB;
+			sc.normal		= normal;
+			sc.tangents[0]	= tangents[0];
+			sc.tangents[1]	= tangents[1];
+			sc.friction		= friction;
+
+			sc.normalMass		= effectiveMass(sc.relativeA, sc.relativeB, normal);
+			sc.tangentMass[0]	= effectiveMass(sc.relativeA, sc.relativeB, tangents[0]);
+			sc.tangentMass[1]	= effectiveMass(sc.relativeA, sc.relativeB, tangents[1]);
+
+			//Only bounce off things we actually hit, or resting objects never settle
+			float approachSpeed = Vector3::Dot(ContactVelocity(sc), normal);
+			sc.velocityBias = approachSpeed < -restitutionThreshold ? -elasticity * approachSpeed : 0.0f;
+
+			solverContacts.push_back(sc);
+		}
+	}
 
-	Vector3 inertiaA = Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, p.normal), relativeB);
+	for (SolverContact& sc : solverContacts) {
+		ApplyContactImpulse(sc, sc.normal * sc.point->normalImpulse +
+			sc.tangents[0] * sc.point->tangentImpulse[0] +
+			sc.tangents[1] * sc.point->tangentImpulse[1]);
+	}
 
-	float angularEffect = Vector3::Dot(inertiaA + inertiaB, p.normal);
-	float cRestitution = .66f;
-	float j = (-(1.f + cRestitution) * impulseForce) / (totalMass + angularEffect);
+	for (int iteration = 0; iteration < contactIterationCount; ++iteration) {
+		for (SolverContact& sc : solverContacts) {
+			ManifoldPoint& p = *sc.point;
+
+			float maxFriction = sc.friction * p.normalImpulse;
+			for (int t = 0; t < 2; ++t) {
+				float lambda	= -Vector3::Dot(ContactVelocity(sc), sc.tangents[t]) * sc.tangentMass[t];
+				float total		= std::clamp(p.tangentImpulse[t] + lambda, -maxFriction, maxFriction);
+				lambda = total - p.tangentImpulse[t];
+				p.tangentImpulse[t] = total;
+				ApplyContactImpulse(sc, sc.tangents[t] * lambda);
+			}
 
-	Vector3 fullImpulse = p.normal * j;
+			float lambda	= (sc.velocityBias - Vector3::Dot(ContactVelocity(sc), sc.normal)) * sc.normalMass;
+			float total		= std::max(p.normalImpulse + lambda, 0.0f);
+			lambda = total - p.normalImpulse;
+			p.normalImpulse = total;
+			ApplyContactImpulse(sc, sc.normal * lambda);
+		}
+	}
+}
 
-	physA->ApplyLinearImpulse(-fullImpulse);
-	physB->ApplyLinearImpulse(fullImpulse);
+//How fast B's contact point is moving away from A's
+Vector3 PhysicsSystem::ContactVelocity(const SolverContact& sc) const {
+	Vector3 velocityA = bodyStore.GetLinearVelocity(sc.slotA) + Vector3::Cross(bodyStore.GetAngularVelocity(sc.slotA), sc.relativeA);
+	Vector3 velocityB = bodyStore.GetLinearVelocity(sc.slotB) + Vector3::Cross(bodyStore.GetAngularVelocity(sc.slotB), sc.relativeB);
+	return velocityB - velocityA;
+}
 
-	physA->ApplyAngularImpulse(Vector3::Cross(relativeA, -fullImpulse));
-	physB->ApplyAngularImpulse(Vector3::Cross(relativeB, fullImpulse));
+void PhysicsSystem::ApplyContactImpulse(const SolverContact& sc, const Vector3& impulse) {
+	bodyStore.ApplyLinearImpulse(sc.slotA, -impulse);
+	bodyStore.ApplyLinearImpulse(sc.slotB, impulse);
+	if (sc.rotateA) {
+		bodyStore.ApplyAngularImpulse(sc.slotA, Vector3::Cross(sc.relativeA, -impulse));
+	}
+	if (sc.rotateB) {
+		bodyStore.ApplyAngularImpulse(sc.slotB, Vector3::Cross(sc.relativeB, impulse));
+	}
 }
 
 /*
@@ -282,47 +634,501 @@ compare the collisions that we absolutely need to.
 
 */
 void PhysicsSystem::BroadPhase() {
+	switch (broadPhaseType) {
+		case BroadPhaseType::AABBTree:		AABBTreeBroadPhase();		break;
+		case BroadPhaseType::SweepAndPrune:	SweepAndPruneBroadPhase();	break;
+		case BroadPhaseType::Octree:		OctreeBroadPhase();			break;
+		default:							QuadTreeBroadPhase();		break;
+	}
+	StaticBroadPhase();
+}
+
+void PhysicsSystem::QuadTreeBroadPhase() {
 	broadphaseCollisions.clear();
-	QuadTree<GameObject*> tree(Vector2(1024, 1024), 7, 6);
+	quadTree.Clear();
 
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
 	gameWorld.GetObjectIterators(first, last);
 	for (auto i = first; i != last; ++i) {
 		Vector3 halfSizes;
-		if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+		if ((*i)->IsStaticGeometry() || !(*i)->GetBroadphaseAABB(halfSizes)) {
 			continue;
 		}
 
 		Vector3 pos = (*i)->GetTransform().GetPosition();
-		tree.Insert(*i, pos, halfSizes);
+		quadTree.Insert(*i, pos, halfSizes);
+	}
+
+	quadTree.GetCandidatePairs(candidatePairs);
+
+	for (const auto& [a, b] : candidatePairs) {
+		AddBroadPhasePair(a, b);
+	}
+}
+
+/*
+
+Rather than rebuilding a structure every step, the AABB tree keeps a 'fat'
+box around every object. Only objects that have moved outside of their fat
+box get reinserted, and only those need to look for new pairs - everything
+else just keeps the pairs it had last step, until the fat boxes separate.
+
+*/
+void PhysicsSystem::AABBTreeBroadPhase() {
+	SyncBroadPhaseTree();
+
+	for (auto& [object, proxy] : treeProxies) {
+		Vector3 halfSizes;
+		object->GetBroadphaseAABB(halfSizes);
+
+		Vector3 displacement;
+		if (PhysicsObject* phys = object->GetPhysicsObject()) {
+			displacement = bodyStore.GetLinearVelocity(*phys) * tickScheduler.GetTickTime();
+		}
+		if (broadPhaseTree.Move(proxy, object->GetTransform().GetPosition(), halfSizes, displacement)) {
+			movedProxies.push_back(proxy);
+		}
+	}
+
+	for (int proxy : movedProxies) {
+		Vector3 minBounds;
+		Vector3 maxBounds;
+		broadPhaseTree.GetFatAABB(proxy, minBounds, maxBounds);
+		broadPhaseTree.Query(minBounds, maxBounds, [&](int other) {
+			//Every overlap is kept, and only filtered on the way out - a pair's
+			//layers or masses can change while the two sit inside each other's
+			//fat boxes, and the pair wouldn't be looked for again until they left
+			if (other != proxy) {
+				treePairs.insert({ std::min(proxy, other), std::max(proxy, other) });
+			}
+			return true;
+		});
+	}
+	movedProxies.clear();
+
+	//Pairs are kept for as long as their fat boxes overlap, but only go on
+	//to the narrowphase once the objects' own boxes do, like the other broadphases
+	broadphaseCollisions.clear();
+	for (auto i = treePairs.begin(); i != treePairs.end(); ) {
+		if (!broadPhaseTree.TestFatOverlap(i->first, i->second)) {
+			i = treePairs.erase(i);
+			continue;
+		}
+		GameObject* a = broadPhaseTree.GetObject(i->first);
+		GameObject* b = broadPhaseTree.GetObject(i->second);
+		++i;
+
+		Vector3 halfSizesA;
+		Vector3 halfSizesB;
+		a->GetBroadphaseAABB(halfSizesA);
+		b->GetBroadphaseAABB(halfSizesB);
+		if (CollisionDetection::AABBTest(a->GetTransform().GetPosition(), b->GetTransform().GetPosition(), halfSizesA, halfSizesB)) {
+			AddBroadPhasePair(a, b);
+		}
+	}
+}
+
+/*
+The tree outlives any single step, so it needs to hear about objects being
+added to or removed from the world. GameWorld bumps its state counter on
+every add/remove, so we only walk the object list when something changed.
+*/
+void PhysicsSystem::SyncBroadPhaseTree() {
+	if (treeWorldState == gameWorld.GetWorldStateID()) {
+		return;
+	}
+	treeWorldState = gameWorld.GetWorldStateID();
+
+	std::map<GameObject*, int> oldProxies;
+	oldProxies.swap(treeProxies);
+
+	std::vector<GameObject*> added;
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		Vector3 halfSizes;
+		if ((*i)->IsStaticGeometry() || !(*i)->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		auto found = oldProxies.find(*i);
+		if (found == oldProxies.end()) {
+			added.push_back(*i);
+			continue;
+		}
+		treeProxies.insert(*found);
+		oldProxies.erase(found);
 	}
 
-	tree.OperateOnContents([&](std::list<QuadTreeEntry<GameObject*>>& data) {
-		CollisionDetection::CollisionInfo info;
-		for (auto i = data.begin(); i != data.end(); ++i) {
-			for (auto j = std::next(i); j != data.end(); ++j){
-				info.a = std::min((*i).object, (*j).object);
-				info.b = std::max((*i).object, (*j).object);
-				broadphaseCollisions.insert(info);
+	//Anything left over has left the world. Removals go first, as the
+	//tree will hand their proxy IDs straight back out to new objects
+	if (!oldProxies.empty()) {
+		std::set<int> removed;
+		for (auto& [object, proxy] : oldProxies) {
+			broadPhaseTree.Remove(proxy);
+			removed.insert(proxy);
+		}
+		for (auto i = treePairs.begin(); i != treePairs.end(); ) {
+			if (removed.count(i->first) || removed.count(i->second)) {
+				i = treePairs.erase(i);
+			}
+			else {
+				++i;
 			}
 		}
+		movedProxies.erase(std::remove_if(movedProxies.begin(), movedProxies.end(),
+			[&](int proxy) { return removed.count(proxy) > 0; }), movedProxies.end());
+	}
+
+	for (GameObject* object : added) {
+		Vector3 halfSizes;
+		object->GetBroadphaseAABB(halfSizes);
+		int proxy = broadPhaseTree.Insert(object, object->GetTransform().GetPosition(), halfSizes);
+		treeProxies.emplace(object, proxy);
+		movedProxies.push_back(proxy);
+	}
+}
+
+/*
+Sort and sweep keeps its endpoint lists between steps, so a step where
+nothing much has moved only costs a near-linear pass over each axis. If the
+world's contents have changed we just start the lists again from scratch.
+*/
+void PhysicsSystem::SweepAndPruneBroadPhase() {
+	if (sweepWorldState != gameWorld.GetWorldStateID()) {
+		sweepWorldState = gameWorld.GetWorldStateID();
+		sweepAndPrune.Clear();
+		sweepObjects.clear();
+
+		std::vector<GameObject*>::const_iterator first;
+		std::vector<GameObject*>::const_iterator last;
+		gameWorld.GetObjectIterators(first, last);
+		for (auto i = first; i != last; ++i) {
+			Vector3 halfSizes;
+			if ((*i)->IsStaticGeometry() || !(*i)->GetBroadphaseAABB(halfSizes)) {
+				continue;
+			}
+			sweepAndPrune.Insert(*i, (*i)->GetTransform().GetPosition(), halfSizes);
+			sweepObjects.push_back(*i);
+		}
+	}
+
+	for (int i = 0; i < (int)sweepObjects.size(); ++i) {
+		Vector3 halfSizes;
+		sweepObjects[i]->GetBroadphaseAABB(halfSizes);
+		sweepAndPrune.SetBounds(i, sweepObjects[i]->GetTransform().GetPosition(), halfSizes);
+	}
+	sweepAndPrune.UpdatePairs();
+
+	broadphaseCollisions.clear();
+	sweepAndPrune.OperateOnPairs([&](GameObject* a, GameObject* b) {
+		AddBroadPhasePair(a, b);
 	});
 }
 
+/*
+The octree is rebuilt from scratch every step, but as a loose octree never
+splits objects across nodes, that's just one walk down the tree per object.
+Unlike the QuadTree it partitions height too, so tall or stacked scenes
+don't all pile up into the same leaves.
+*/
+void PhysicsSystem::OctreeBroadPhase() {
+	BuildOctree();
+	octree.GetCandidatePairs(candidatePairs);
+
+	broadphaseCollisions.clear();
+	for (const auto& [a, b] : candidatePairs) {
+		AddBroadPhasePair(a, b);
+	}
+}
+
+void PhysicsSystem::BuildOctree() {
+	octree.Clear();
+
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		Vector3 halfSizes;
+		if ((*i)->IsStaticGeometry() || !(*i)->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		octree.Insert(*i, (*i)->GetTransform().GetPosition(), halfSizes);
+	}
+}
+
+/*
+Static geometry never moves, so rather than going through the broadphase
+with everything else it's built into its own BVH, and only rebuilt when
+static objects are added to or removed from the world. Adding a dynamic
+object changes the world state too, so we check the static objects are
+really any different before throwing the tree away.
+*/
+void PhysicsSystem::SyncStaticTree() {
+	if (staticWorldState == gameWorld.GetWorldStateID()) {
+		return;
+	}
+	staticWorldState = gameWorld.GetWorldStateID();
+
+	std::vector<std::pair<GameObject*, int>> currentStatics;
+	gameWorld.OperateOnContents(
+		[&](GameObject* o) {
+			if (o->IsStaticGeometry() && o->GetBoundingVolume()) {
+				currentStatics.emplace_back(o, o->GetWorldID());
+			}
+		}
+	);
+	if (currentStatics == staticObjects) {
+		return;
+	}
+	staticObjects.swap(currentStatics);
+
+	staticTree.Clear();
+	for (auto& [object, worldID] : staticObjects) {
+		object->UpdateBroadphaseAABB();
+		Vector3 halfSizes;
+		object->GetBroadphaseAABB(halfSizes);
+		staticTree.Add(object, object->GetTransform().GetPosition(), halfSizes);
+	}
+	staticTree.Build();
+}
+
+//Only moving objects look for static geometry, which never looks for itself
+void PhysicsSystem::StaticBroadPhase() {
+	if (staticTree.GetObjectCount() == 0) {
+		return;
+	}
+	gameWorld.OperateOnContents(
+		[&](GameObject* o) {
+			Vector3 halfSizes;
+			if (o->IsStaticGeometry() || !o->GetBroadphaseAABB(halfSizes)) {
+				return;
+			}
+			Vector3 pos = o->GetTransform().GetPosition();
+			staticTree.Query(pos - halfSizes, pos + halfSizes, [&](GameObject* other) {
+				AddBroadPhasePair(o, other);
+				return true;
+			});
+		}
+	);
+}
+
+//Throws away everything the persistent broadphases remember between steps
+/*
+Raycasts go through whichever tree the broadphase already keeps - the
+octree is rebuilt, and the AABB tree just has its proxies moved to where
+the objects ended up. The other broadphases have nothing a ray can walk,
+so they keep the AABB tree up to date purely for raycasts. That's cheap,
+as most proxies still fit inside their fat boxes and aren't touched.
+*/
+void PhysicsSystem::UpdateRaycastTree() {
+	UpdateObjectAABBs();
+	SyncStaticTree();
+
+	if (broadPhaseType == BroadPhaseType::Octree) {
+		BuildOctree();
+		gameWorld.SetRaycastOctree(&octree, &staticTree);
+		return;
+	}
+	SyncBroadPhaseTree();
+	for (auto& [object, proxy] : treeProxies) {
+		Vector3 halfSizes;
+		object->GetBroadphaseAABB(halfSizes);
+		if (broadPhaseTree.Move(proxy, object->GetTransform().GetPosition(), halfSizes)) {
+			movedProxies.push_back(proxy);
+		}
+	}
+	//Only the AABB tree broadphase ever looks for pairs amongst the moved proxies
+	if (broadPhaseType != BroadPhaseType::AABBTree) {
+		movedProxies.clear();
+	}
+	gameWorld.SetRaycastTree(&broadPhaseTree, &staticTree);
+}
+
+void PhysicsSystem::ResetBroadPhaseState() {
+	broadPhaseTree.Clear();
+	treeProxies.clear();
+	treePairs.clear();
+	movedProxies.clear();
+	treeWorldState = -1;
+
+	sweepAndPrune.Clear();
+	sweepObjects.clear();
+	sweepWorldState = -1;
+
+	staticTree.Clear();
+	staticObjects.clear();
+	staticWorldState = -1;
+}
+
 /*
 
 The broadphase will now only give us likely collisions, so we can now go through them,
 and work out if they are truly colliding, and if so, add them into the main collision list
+
+The intersection tests only read the world, so they're split across the worker
+threads, each writing into its own list. Resolving collisions moves objects
+though, so that's left until every test is done, and happens on this thread
+in pair order - that way we get the same result however many threads we use.
+
+Before testing, the pairs are bucketed by which of CollisionDetection's pair
+tests they need, so the tests run in long runs of the same kind rather than
+jumping between them on every pair. The sphere / sphere and AABB / AABB runs
+are the most common by far, so they go through the batched SSE tests instead.
 */
 void PhysicsSystem::NarrowPhase() {
-	for (std::set<CollisionDetection::CollisionInfo>::iterator i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i){
-		CollisionDetection::CollisionInfo info = *i;
-		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)){
-			info.framesLeft = numCollisionFrames;
-			ImpulseResolveCollision(*info.a, *info.b, info.point);
-			allCollisions.insert(info);
+	const int pairSlots = CollisionDetection::VolumeSlots * CollisionDetection::VolumeSlots;
+
+	narrowPhaseAwake.clear();
+	for (auto i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); ++i) {
+		if (IsPairAsleep(i->a, i->b)) {
+			KeepSleepingContact(*i);
+			sleepStats.skippedPairs++;
+			continue;
+		}
+		narrowPhaseAwake.push_back(*i);
+	}
+
+	static const auto convexPairFlags = [] {
+		std::array<bool, pairSlots> flags{};
+		for (int a = 0; a < CollisionDetection::VolumeSlots; ++a) {
+			for (int b = 0; b < CollisionDetection::VolumeSlots; ++b) {
+				flags[a * CollisionDetection::VolumeSlots + b] = CollisionDetection::IsConvexPair((VolumeType)(1 << a), (VolumeType)(1 << b));
+			}
 		}
+		return flags;
+	}();
+
+	//A counting sort, so pairs of the same kind stay in broadphase order
+	int slotStarts[pairSlots + 1] = {};
+	narrowPhaseSlots.resize(narrowPhaseAwake.size());
+	for (size_t i = 0; i < narrowPhaseAwake.size(); ++i) {
+		const CollisionVolume* volA = narrowPhaseAwake[i].a->GetBoundingVolume();
+		const CollisionVolume* volB = narrowPhaseAwake[i].b->GetBoundingVolume();
+		int slot = (volA && volB) ? CollisionDetection::GetPairSlot(volA->type, volB->type) : pairSlots - 1;
+		narrowPhaseSlots[i] = slot;
+		slotStarts[slot + 1]++;
+	}
+	for (int i = 0; i < pairSlots; ++i) {
+		slotStarts[i + 1] += slotStarts[i];
+	}
+	narrowPhasePairs.resize(narrowPhaseAwake.size());
+	for (size_t i = 0; i < narrowPhaseAwake.size(); ++i) {
+		CollisionDetection::CollisionInfo& pair = narrowPhasePairs[slotStarts[narrowPhaseSlots[i]]++];
+		pair = narrowPhaseAwake[i];
+		pair.convexCache = nullptr;
+		if (convexPairFlags[narrowPhaseSlots[i]]) {
+			//Handed out here rather than in the tests, as the map can't be added to from several threads
+			GJKCache& cache = convexCaches[ContactCache::GetPairID(pair.a, pair.b)];
+			cache.lastStep		= stepCount;
+			pair.convexCache	= &cache;
+		}
+	}
+	if (stepCount % ConvexCacheLifetime == 0) {
+		std::erase_if(convexCaches, [&](const auto& entry) {
+			return stepCount - entry.second.lastStep > ConvexCacheLifetime;
+		});
+	}
+	//Each slot's start has been moved along to its end, which is where the next slot starts
+	const int sphereSlot	= CollisionDetection::GetPairSlot(VolumeType::Sphere, VolumeType::Sphere);
+	const int aabbSlot		= CollisionDetection::GetPairSlot(VolumeType::AABB, VolumeType::AABB);
+	const int sphereFirst	= sphereSlot > 0 ? slotStarts[sphereSlot - 1] : 0;
+	const int sphereLast	= useBatchedNarrowPhase ? slotStarts[sphereSlot] : sphereFirst;
+	const int aabbFirst		= aabbSlot > 0 ? slotStarts[aabbSlot - 1] : 0;
+	const int aabbLast		= useBatchedNarrowPhase ? slotStarts[aabbSlot] : aabbFirst;
+
+	int ranges = useParallelNarrowPhase ? workerPool.GetThreadCount() : 1;
+	narrowPhaseContacts.resize(ranges);
+	for (auto& contacts : narrowPhaseContacts) {
+		contacts.clear();
+	}
+	sphereBatches.resize(ranges);
+	aabbBatches.resize(ranges);
+
+	auto testPairs = [&](int first, int last, int range) {
+		std::vector<CollisionDetection::CollisionInfo>& contacts = narrowPhaseContacts[range];
+		for (int i = first; i < last; ++i) {
+			if ((i >= sphereFirst && i < sphereLast) || (i >= aabbFirst && i < aabbLast)) {
+				continue;
+			}
+			CollisionDetection::CollisionInfo info = narrowPhasePairs[i];
+			if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
+				contacts.push_back(info);
+			}
+		}
+		TestSpherePairs(std::max(first, sphereFirst), std::min(last, sphereLast), sphereBatches[range], contacts);
+		TestAABBPairs(std::max(first, aabbFirst), std::min(last, aabbLast), aabbBatches[range], contacts);
+	};
+	if (useParallelNarrowPhase) {
+		workerPool.ParallelFor((int)narrowPhasePairs.size(), narrowPhaseMinRange, testPairs);
+	}
+	else {
+		testPairs(0, (int)narrowPhasePairs.size(), 0);
+	}
+
+	narrowPhaseResults.clear();
+	for (const auto& contacts : narrowPhaseContacts) {
+		narrowPhaseResults.insert(narrowPhaseResults.end(), contacts.begin(), contacts.end());
+	}
+	std::stable_sort(narrowPhaseResults.begin(), narrowPhaseResults.end(),
+		[](const CollisionDetection::CollisionInfo& a, const CollisionDetection::CollisionInfo& b) {
+			return ContactCache::GetPairID(a.a, a.b) < ContactCache::GetPairID(b.a, b.b);
+		});
+
+	profiler.AddCounter(PhysicsCounter::CandidatePairs, (int)narrowPhasePairs.size());
+	profiler.AddCounter(PhysicsCounter::Contacts, (int)narrowPhaseResults.size());
+
+	for (CollisionDetection::CollisionInfo& info : narrowPhaseResults) {
+		info.framesLeft = numCollisionFrames;
+		if (info.a->GetPhysicsObject()->IsAsleep() || info.b->GetPhysicsObject()->IsAsleep()) {
+			sleepStats.wakeEvents++; //the contact solver's impulses will wake it up
+		}
+		allCollisions.Insert(info).manifold.Update(info, stepCount);
+	}
+}
+
+//The batched tests only find the normal and penetration, the contact points are built here
+void PhysicsSystem::TestSpherePairs(int first, int last, SpherePairBatch& batch, std::vector<CollisionDetection::CollisionInfo>& contacts) const {
+	if (first >= last) {
+		return;
+	}
+	batch.Clear();
+	for (int i = first; i < last; ++i) {
+		const CollisionDetection::CollisionInfo& pair = narrowPhasePairs[i];
+		batch.Add(pair.a->GetTransform().GetPosition(), ((const SphereVolume*)pair.a->GetBoundingVolume())->GetRadius(),
+			pair.b->GetTransform().GetPosition(), ((const SphereVolume*)pair.b->GetBoundingVolume())->GetRadius());
+	}
+	batch.Test();
+	for (int hit : batch.GetHits()) {
+		CollisionDetection::CollisionInfo info = narrowPhasePairs[first + hit];
+		Vector3 normal = batch.GetNormal(hit);
+		float radiusA = ((const SphereVolume*)info.a->GetBoundingVolume())->GetRadius();
+		float radiusB = ((const SphereVolume*)info.b->GetBoundingVolume())->GetRadius();
+		info.AddContactPoint(normal * radiusA, -normal * radiusB, normal, batch.GetPenetration(hit));
+		contacts.push_back(info);
+	}
+}
+
+void PhysicsSystem::TestAABBPairs(int first, int last, AABBPairBatch& batch, std::vector<CollisionDetection::CollisionInfo>& contacts) const {
+	if (first >= last) {
+		return;
+	}
+	batch.Clear();
+	for (int i = first; i < last; ++i) {
+		const CollisionDetection::CollisionInfo& pair = narrowPhasePairs[i];
+		batch.Add(pair.a->GetTransform().GetPosition(), ((const AABBVolume*)pair.a->GetBoundingVolume())->GetHalfDimensions(),
+			pair.b->GetTransform().GetPosition(), ((const AABBVolume*)pair.b->GetBoundingVolume())->GetHalfDimensions());
+	}
+	batch.Test();
+	for (int hit : batch.GetHits()) {
+		CollisionDetection::CollisionInfo info = narrowPhasePairs[first + hit];
+		info.pointCount = 0;
+		CollisionDetection::AddAABBContacts(info.a->GetTransform().GetPosition(), ((const AABBVolume*)info.a->GetBoundingVolume())->GetHalfDimensions(),
+			info.b->GetTransform().GetPosition(), ((const AABBVolume*)info.b->GetBoundingVolume())->GetHalfDimensions(),
+			batch.GetFace(hit), batch.GetPenetration(hit), info);
+		contacts.push_back(info);
 	}
 }
 
@@ -336,110 +1142,405 @@ based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
 */
 void PhysicsSystem::IntegrateAccel(float dt) {
+	bodyStore.IntegrateAccel(dt, applyGravity ? gravity : Vector3());
+}
+
+/*
+This function integrates linear and angular velocity into
+position and orientation. It may be called multiple times
+throughout a physics update, to slowly move the objects through
+the world, looking for collisions.
+*/
+void PhysicsSystem::IntegrateVelocity(float dt) {
+	float frameDamping = 1.f - (dampingFactor * dt);
+
+	bodyStore.IntegrateVelocity(dt, frameDamping);
+}
+
+/*
+Continuous collision, for objects flagged as fast. Before they're moved,
+each one is swept as a sphere along the path it's about to take, against
+everything the broadphase paired it with - its box was grown to cover the
+whole step, so that's everything it could reach. If the sweep touches
+something on the way, the object is stopped just past that point after
+integration, keeping its velocity. Next step the narrowphase finds it
+slightly overlapping whatever it hit, and the contact solver bounces it off
+as usual, rather than it ending the step on the far side of a thin wall.
+
+The sphere is the largest that fits inside the object, so boxes and hulls
+get stopped a little late rather than early - they always end up touching.
+Objects already touching at the start are left to the contact solver, and
+objects moving less than fastBodyThreshold of their size can't get through
+anything without the narrowphase seeing it, so aren't swept at all.
+*/
+void PhysicsSystem::SweepFastBodies(float dt) {
+	fastBodyStops.clear();
+
+	auto sweepRadius = [](const CollisionVolume& volume) {
+		switch (volume.type) {
+			case VolumeType::Sphere:	return ((const SphereVolume&)volume).GetRadius();
+			case VolumeType::Capsule:	return ((const CapsuleVolume&)volume).GetRadius();
+			case VolumeType::AABB: {
+				Vector3 size = ((const AABBVolume&)volume).GetHalfDimensions();
+				return std::min(size.x, std::min(size.y, size.z));
+			}
+			case VolumeType::OBB: {
+				Vector3 size = ((const OBBVolume&)volume).GetHalfDimensions();
+				return std::min(size.x, std::min(size.y, size.z));
+			}
+			case VolumeType::ConvexHull: {
+				Vector3 size = ((const ConvexHullVolume&)volume).GetHalfDimensions();
+				return std::min(size.x, std::min(size.y, size.z));
+			}
+			default:
+				return 0.0f;
+		}
+	};
+
+	auto sweep = [&](GameObject* object, GameObject* other) {
+		PhysicsObject* phys = object->GetPhysicsObject();
+		if (!phys || !phys->HasContinuousCollision() || phys->IsAsleep() || !object->GetBoundingVolume()) {
+			return;
+		}
+		float radius = sweepRadius(*object->GetBoundingVolume());
+		Vector3 motion	= bodyStore.GetLinearVelocity(*phys) * dt;
+		float distance	= motion.Length();
+		if (radius <= 0.0f || distance <= radius * fastBodyThreshold) {
+			return;
+		}
+		Vector3 start		= object->GetTransform().GetPosition();
+		Vector3 direction	= motion / distance;
+
+		float	hitDistance;
+		Vector3 normal;
+		if (!CollisionDetection::SphereSweep(start, radius, direction, distance, *other, hitDistance, normal) || hitDistance <= 0.0f) {
+			return;
+		}
+		//Far enough past the touching point that the narrowphase will see the overlap
+		Vector3 stop = start + direction * std::min(hitDistance + penetrationSlop * 2.0f, distance);
+
+		for (FastBodyStop& s : fastBodyStops) {
+			if (s.object == object) {
+				if ((stop - start).LengthSquared() < (s.position - start).LengthSquared()) {
+					s.position = stop;
+				}
+				return;
+			}
+		}
+		fastBodyStops.push_back({ object, stop });
+	};
+
+	if (useBroadPhase) {
+		for (const CollisionDetection::CollisionInfo& pair : broadphaseCollisions) {
+			sweep(pair.a, pair.b);
+			sweep(pair.b, pair.a);
+		}
+		return;
+	}
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
-
 	gameWorld.GetObjectIterators(first, last);
 	for (auto i = first; i != last; ++i) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr) {
+		PhysicsObject* phys = (*i)->GetPhysicsObject();
+		if (!phys || !phys->HasContinuousCollision()) {
 			continue;
 		}
-		float inverseMass = object->GetInverseMass();
+		for (auto j = first; j != last; ++j) {
+			if (i != j && (*j)->GetPhysicsObject() && ShouldTestPair(*i, *j)) {
+				sweep(*i, *j);
+			}
+		}
+	}
+}
 
-		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
-		Vector3 accel = force * inverseMass;
+void PhysicsSystem::StopFastBodies() {
+	for (const FastBodyStop& s : fastBodyStops) {
+		s.object->GetTransform().SetPosition(s.position);
+		bodyStore.SetPosition(*s.object->GetPhysicsObject(), s.position);
+	}
+	fastBodyStops.clear();
+}
 
-		if (applyGravity && inverseMass > 0 && (*i)->GetIsAffectedByGravity()) {
-			accel += gravity;
-		}
+/*
 
-		linearVel += accel * dt;
-		object->SetLinearVelocity(linearVel);
+As part of the final physics tutorials, we add in the ability
+to constrain objects based on some extra calculation, allowing
+us to model springs and ropes etc.
 
-		Vector3 torque = object->GetTorque();
-		Vector3 angVel = object->GetAngularVelocity();
+*/
+void PhysicsSystem::UpdateConstraints(float dt) {
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	gameWorld.GetConstraintIterators(first, last);
 
-		object->UpdateInertiaTensor();
-		Vector3 angAccel = object->GetInertiaTensor() * torque;
+	for (auto i = first; i != last; ++i) {
+		UpdateConstraint(*i, dt);
+	}
+}
 
-		angVel += angAccel * dt;
-		object->SetAngularVelocity(angVel);
+void PhysicsSystem::UpdateConstraint(Constraint* c, float dt) {
+	//Constraints push on their objects every step, which would keep
+	//waking them, so a chain that has gone to sleep is left alone
+	GameObject* a;
+	GameObject* b;
+	c->GetConstrainedObjects(a, b);
+	if (a && b && IsPairAsleep(a, b)) {
+		return;
 	}
+	c->UpdateConstraint(dt);
 }
 
 /*
-This function integrates linear and angular velocity into
-position and orientation. It may be called multiple times
-throughout a physics update, to slowly move the objects through
-the world, looking for collisions.
+Constraints still work through their PhysicsObjects, so the bodies they
+hold together are given their velocities and inertia tensors from the
+RigidBodyStore before the constraints run, and the store takes back
+whatever the constraints did to them afterwards. There are far fewer of
+these than there are bodies, so it's cheaper than keeping every object
+up to date.
 */
-void PhysicsSystem::IntegrateVelocity(float dt) {
+void PhysicsSystem::CopyConstrainedBodiesOut() {
+	constrainedBodies.clear();
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	gameWorld.GetConstraintIterators(first, last);
+	for (auto i = first; i != last; ++i) {
+		GameObject* a;
+		GameObject* b;
+		(*i)->GetConstrainedObjects(a, b);
+		for (GameObject* o : { a, b }) {
+			if (o && o->GetPhysicsObject()) {
+				constrainedBodies.push_back(o->GetPhysicsObject());
+			}
+		}
+	}
+	for (PhysicsObject* object : constrainedBodies) {
+		bodyStore.CopyToObject(*object);
+	}
+}
+
+void PhysicsSystem::CopyConstrainedBodiesIn() {
+	for (PhysicsObject* object : constrainedBodies) {
+		bodyStore.CopyFromObject(*object);
+	}
+}
+
+/*
+The same iterations as UpdateConstraints, but with the PositionConstraints
+pulled out into the ConstraintSolver's flat arrays and split into colours
+that share no objects, so each colour can be spread across the worker
+threads. Anything else still goes through UpdateConstraint after each pass,
+which needs the velocities copied out and back in around it.
+*/
+void PhysicsSystem::UpdateColouredConstraints(float dt, int iterations) {
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	gameWorld.GetConstraintIterators(first, last);
+	constraintSolver.Build(first, last, gameWorld.GetConstraintStateID());
+
+	int linkCount = constraintSolver.GetLinkCount();
+	for (int i = 0; i < linkCount; ++i) {
+		GameObject* a;
+		GameObject* b;
+		constraintSolver.GetLinkObjects(i, a, b);
+		constraintSolver.SetLinkActive(i, !IsPairAsleep(a, b));
+	}
+	const std::vector<Constraint*>& others = constraintSolver.GetOtherConstraints();
+
+	constraintSolver.Gather();
+	for (int i = 0; i < iterations; ++i) {
+		constraintSolver.SolveIteration(dt, &workerPool, constraintMinRange);
+		if (!others.empty()) {
+			constraintSolver.Scatter();
+			for (Constraint* c : others) {
+				UpdateConstraint(c, dt);
+			}
+			constraintSolver.Gather();
+		}
+	}
+	constraintSolver.Scatter();
+}
+
+/*
+Objects that have been slow for long enough are put to sleep, and skip
+integration and the narrowphase until something touches them. Objects that
+are touching or constrained together form an island, and an island only
+goes to sleep as a whole - otherwise the bottom of a stack could fall
+asleep and stop holding up the objects still settling on top of it. In the
+same way, waking any object in an island wakes the rest of it.
+
+Immovable objects don't join islands, or the floor would tie the whole
+level into one big island that could never sleep.
+*/
+void PhysicsSystem::UpdateIslands(float dt) {
+	islandBodies.clear();
+
 	std::vector<GameObject*>::const_iterator first;
 	std::vector<GameObject*>::const_iterator last;
-
 	gameWorld.GetObjectIterators(first, last);
-	float frameLinearDamping = 1.f - (dampingFactor * dt);
-
 	for (auto i = first; i != last; ++i) {
 		PhysicsObject* object = (*i)->GetPhysicsObject();
 		if (object == nullptr) {
 			continue;
 		}
+		if (object->GetInverseMass() == 0.0f) {
+			object->SetIslandIndex(-1);
+			continue;
+		}
+		object->SetIslandIndex((int)islandBodies.size());
+		islandBodies.push_back(*i);
 
-		Transform& transform = (*i)->GetTransform();
+		if (object->IsAsleep()) {
+			continue;
+		}
+		float linearSpeed	= bodyStore.GetLinearVelocity(*object).LengthSquared();
+		float angularSpeed	= bodyStore.GetAngularVelocity(*object).LengthSquared();
+		if (linearSpeed < sleepLinearThreshold * sleepLinearThreshold &&
+			angularSpeed < sleepAngularThreshold * sleepAngularThreshold) {
+			object->SetSleepTimer(object->GetSleepTimer() + dt);
+		}
+		else {
+			object->SetSleepTimer(0.0f);
+		}
+	}
 
-		Vector3 position = transform.GetPosition();
-		Vector3 linearVel = object->GetLinearVelocity();
-		position += linearVel * dt;
-		transform.SetPosition(position);
+	int bodyCount = (int)islandBodies.size();
+	islandParents.resize(bodyCount);
+	for (int i = 0; i < bodyCount; ++i) {
+		islandParents[i] = i;
+	}
 
-		linearVel = linearVel * frameLinearDamping;
-		object->SetLinearVelocity(linearVel);
+	for (const CachedContact& contact : allCollisions) {
+		JoinIslands(contact.info.a, contact.info.b);
+	}
 
-		Quaternion orientation = transform.GetOrientation();
-		Vector3 angVel = object->GetAngularVelocity();
+	std::vector<Constraint*>::const_iterator firstConstraint;
+	std::vector<Constraint*>::const_iterator lastConstraint;
+	gameWorld.GetConstraintIterators(firstConstraint, lastConstraint);
+	for (auto i = firstConstraint; i != lastConstraint; ++i) {
+		GameObject* a;
+		GameObject* b;
+		(*i)->GetConstrainedObjects(a, b);
+		if (a && b) {
+			JoinIslands(a, b);
+		}
+	}
 
-		orientation = orientation + (Quaternion(angVel * dt * .5f, 0.f) * orientation);
-		orientation.Normalise();
+	//An island with nothing awake in it stays asleep, an island that has
+	//only rested objects goes to sleep, and anything else is woken up
+	islandAwake.assign(bodyCount, 0);
+	islandRested.assign(bodyCount, 1);
+	for (int i = 0; i < bodyCount; ++i) {
+		PhysicsObject* object = islandBodies[i]->GetPhysicsObject();
+		if (object->IsAsleep()) {
+			continue;
+		}
+		int island = FindIsland(i);
+		islandAwake[island] = 1;
+		if (object->GetSleepTimer() < sleepTime) {
+			islandRested[island] = 0;
+		}
+	}
 
-		transform.SetOrientation(orientation);
+	sleepStats.islands			= 0;
+	sleepStats.awakeBodies		= 0;
+	sleepStats.sleepingBodies	= 0;
+	for (int i = 0; i < bodyCount; ++i) {
+		PhysicsObject* object = islandBodies[i]->GetPhysicsObject();
+		int island = FindIsland(i);
+		if (island == i) {
+			sleepStats.islands++;
+		}
+		if (islandAwake[island]) {
+			if (islandRested[island]) {
+				if (!object->IsAsleep()) {
+					object->Sleep();
+					sleepStats.sleepEvents++;
+				}
+			}
+			else if (object->IsAsleep()) {
+				object->Wake();
+				sleepStats.wakeEvents++;
+			}
+		}
+		//Catches anything the contact solver or constraints woke this step too
+		bodyStore.SetAwake(*object, !object->IsAsleep());
+		if (object->IsAsleep()) {
+			sleepStats.sleepingBodies++;
+		}
+		else {
+			sleepStats.awakeBodies++;
+		}
+	}
+}
 
-		float frameAngularDamping = 1.f - (dampingFactor * dt);
+int PhysicsSystem::FindIsland(int body) {
+	while (islandParents[body] != body) {
+		islandParents[body] = islandParents[islandParents[body]];
+		body = islandParents[body];
+	}
+	return body;
+}
 
-		angVel = angVel * frameAngularDamping;
-		object->SetAngularVelocity(angVel);
+void PhysicsSystem::JoinIslands(GameObject* a, GameObject* b) {
+	PhysicsObject* physA = a->GetPhysicsObject();
+	PhysicsObject* physB = b->GetPhysicsObject();
+	if (physA == nullptr || physB == nullptr) {
+		return;
+	}
+	int indexA = physA->GetIslandIndex();
+	int indexB = physB->GetIslandIndex();
+	if (indexA < 0 || indexB < 0) {
+		return;
+	}
+	int islandA = FindIsland(indexA);
+	int islandB = FindIsland(indexB);
+	if (islandA != islandB) {
+		islandParents[std::max(islandA, islandB)] = std::min(islandA, islandB);
 	}
 }
 
 /*
-Once we're finished with a physics update, we have to
-clear out any accumulated forces, ready to receive new
-ones in the next 'game' frame.
+A pair can be skipped if neither object can be moving - at least one is
+asleep, and the other is either asleep too or is an immovable object that
+isn't being moved about by its velocity.
 */
-void PhysicsSystem::ClearForces() {
-	gameWorld.OperateOnContents(
-		[](GameObject* o) {
-			o->GetPhysicsObject()->ClearForces();
+bool PhysicsSystem::IsPairAsleep(GameObject* a, GameObject* b) const {
+	if (!useSleeping) {
+		return false;
+	}
+	PhysicsObject* physA = a->GetPhysicsObject();
+	PhysicsObject* physB = b->GetPhysicsObject();
+	if (physA == nullptr || physB == nullptr) {
+		return false;
+	}
+	if (!physA->IsAsleep() && !physB->IsAsleep()) {
+		return false;
+	}
+	auto isResting = [&](const PhysicsObject* o) {
+		if (o->IsAsleep()) {
+			return true;
 		}
-	);
+		return o->GetInverseMass() == 0.0f &&
+			bodyStore.GetLinearVelocity(*o).LengthSquared() == 0.0f &&
+			bodyStore.GetAngularVelocity(*o).LengthSquared() == 0.0f;
+	};
+	return isResting(physA) && isResting(physB);
 }
 
-
-/*
-
-As part of the final physics tutorials, we add in the ability
-to constrain objects based on some extra calculation, allowing
-us to model springs and ropes etc.
-
-*/
-void PhysicsSystem::UpdateConstraints(float dt) {
-	std::vector<Constraint*>::const_iterator first;
-	std::vector<Constraint*>::const_iterator last;
-	gameWorld.GetConstraintIterators(first, last);
-
-	for (auto i = first; i != last; ++i) {
-		(*i)->UpdateConstraint(dt);
+//Sleeping objects are still touching whatever they went to sleep on, so
+//their collisions are kept alive rather than timing out with OnCollisionEnd
+void PhysicsSystem::KeepSleepingContact(const CollisionDetection::CollisionInfo& info) {
+	if (CachedContact* contact = allCollisions.Find(ContactCache::GetPairID(info.a, info.b))) {
+		contact->info.framesLeft = numCollisionFrames;
 	}
+}
+
+void PhysicsSystem::WakeAll() {
+	gameWorld.OperateOnContents(
+		[](GameObject* o) {
+			if (PhysicsObject* phys = o->GetPhysicsObject()) {
+				phys->Wake();
+			}
+		}
+	);
 }
\ No newline at end of file
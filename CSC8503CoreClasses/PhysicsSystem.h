@@ -1,17 +1,126 @@
 #pragma once
 #include "GameWorld.h"
+#include "FlatQuadTree.h"
+#include "DynamicAABBTree.h"
+#include "StaticBVH.h"
+#include "SweepAndPrune.h"
+#include "ThreadPool.h"
+#include "ContactBatch.h"
+#include "GJK.h"
+#include "RigidBodyStore.h"
+#include "ContactCache.h"
+#include "ConstraintSolver.h"
+#include "TickScheduler.h"
+#include "PhysicsProfiler.h"
+#include <unordered_map>
+#include <algorithm>
 
 namespace NCL {
 	namespace CSC8503 {
+		enum class BroadPhaseType {
+			None,			//Test every pair of objects against each other
+			QuadTree,		//Refilled every step, but reuses its memory
+			AABBTree,		//Persistent, only moved objects are touched
+			SweepAndPrune,	//Persistent sorted endpoints, insertion sorted each step
+			Octree			//Loose octree refilled every step, also used by GameWorld::Raycast
+		};
+
+		//Counters for how much work sleeping is saving us. Body and island
+		//counts describe the last step, event and pair counts cover the
+		//whole of the last Update
+		struct SleepStats {
+			int islands			= 0;
+			int awakeBodies		= 0;
+			int sleepingBodies	= 0;
+			int sleepEvents		= 0;	//bodies put to sleep
+			int wakeEvents		= 0;	//bodies woken by a contact or their island
+			int skippedPairs	= 0;	//broadphase pairs not narrowphased
+		};
+
+		//One contact point, set up for the contact solver
+		struct SolverContact {
+			int				slotA;	//Both objects' slots in the RigidBodyStore
+			int				slotB;
+			ManifoldPoint*	point;
+			bool			rotateA;
+			bool			rotateB;
+
+			Vector3 relativeA;	//World space offsets from each object to the contact
+			Vector3 relativeB;
+			Vector3 normal;
+			Vector3 tangents[2];
+
+			float	normalMass;
+			float	tangentMass[2];
+			float	velocityBias;	//The separating speed restitution is aiming for
+			float	friction;
+		};
+
 		class PhysicsSystem	{
 		public:
-			PhysicsSystem(GameWorld& g);
+			//workerThreads sizes the narrowphase's pool, 0 being one per hardware thread. Worlds
+			//stepped side by side by a WorldScheduler want 1, so they don't each start their own
+			PhysicsSystem(GameWorld& g, BroadPhaseType broadPhase = BroadPhaseType::None, int workerThreads = 0);
 			~PhysicsSystem();
 
 			void Clear();
 
 			void Update(float dt);
 
+			//How many fixed steps physics takes per second, whatever the framerate
+			void SetTickRate(float hz) {
+				tickScheduler.SetTickRate(hz);
+			}
+
+			float GetTickRate() const {
+				return tickScheduler.GetTickRate();
+			}
+
+			//Beyond this many steps in one frame, physics gives up on catching up
+			void SetMaxTicksPerFrame(int ticks) {
+				tickScheduler.SetMaxTicksPerFrame(ticks);
+			}
+
+			const TickStats& GetTickStats() const {
+				return tickScheduler.GetStats();
+			}
+
+			//Draws objects between their last two steps, rather than snapping
+			//to wherever the most recent one left them
+			void UseInterpolation(bool state);
+
+			bool IsInterpolationEnabled() const {
+				return useInterpolation;
+			}
+
+			PhysicsProfiler& GetProfiler() {
+				return profiler;
+			}
+
+			//The narrowphase's worker threads, free to use between updates (ie for GameWorld::RaycastBatch)
+			ThreadPool& GetWorkerPool() {
+				return workerPool;
+			}
+
+			//Lets whoever is at the keyboard change settings. Turn it off for any
+			//world that isn't updated on the thread that owns the window
+			void UseKeyboardControls(bool state) {
+				useKeyboardControls = state;
+			}
+
+			void SetConstraintIterations(int iterations) {
+				constraintIterations = std::max(1, iterations);
+			}
+
+			int GetConstraintIterations() const {
+				return constraintIterations;
+			}
+
+			//Shows the profiler's averages on screen every update (F5 toggles it)
+			void DrawProfile(bool state) {
+				drawProfile = state;
+			}
+
 			void UseGravity(bool state) {
 				applyGravity = state;
 			}
@@ -29,36 +138,226 @@ namespace NCL {
 			void SetDampingFactor(float dmpFactor) {
 				dampingFactor = dmpFactor;
 			}
+
+			void SetBroadPhaseType(BroadPhaseType type);
+
+			BroadPhaseType GetBroadPhaseType() const {
+				return broadPhaseType;
+			}
+
+			static const char* GetBroadPhaseName(BroadPhaseType type);
+
+			void UseSleeping(bool state);
+
+			bool IsSleepingEnabled() const {
+				return useSleeping;
+			}
+
+			//Objects slower than these for sleepTime seconds can be put to sleep
+			void SetSleepThresholds(float linearSpeed, float angularSpeed) {
+				sleepLinearThreshold	= linearSpeed;
+				sleepAngularThreshold	= angularSpeed;
+			}
+
+			void SetSleepTime(float t) {
+				sleepTime = t;
+			}
+
+			void SetContactIterations(int iterations) {
+				contactIterationCount = iterations;
+			}
+
+			int GetContactIterations() const {
+				return contactIterationCount;
+			}
+
+			const SleepStats& GetSleepStats() const {
+				return sleepStats;
+			}
+
+			void UseParallelNarrowPhase(bool state) {
+				useParallelNarrowPhase = state;
+			}
+
+			bool IsParallelNarrowPhaseEnabled() const {
+				return useParallelNarrowPhase;
+			}
+
+			//Tests sphere / sphere and AABB / AABB pairs four at a time,
+			//rather than through CollisionDetection one by one
+			void UseBatchedNarrowPhase(bool state) {
+				useBatchedNarrowPhase = state;
+			}
+
+			bool IsBatchedNarrowPhaseEnabled() const {
+				return useBatchedNarrowPhase;
+			}
+
+			//Sweeps objects flagged with PhysicsObject::SetContinuousCollision
+			//along their path each step, so they can't skip through things
+			void UseContinuousCollision(bool state) {
+				useContinuousCollision = state;
+			}
+
+			bool IsContinuousCollisionEnabled() const {
+				return useContinuousCollision;
+			}
+
+			//Solves PositionConstraints in coloured batches across the worker
+			//threads, rather than one at a time through the constraint list
+			void UseParallelConstraints(bool state) {
+				useParallelConstraints = state;
+			}
+
+			bool IsParallelConstraintsEnabled() const {
+				return useParallelConstraints;
+			}
+
+			//Layers are the bit numbers in GameObject collision categories, and
+			//start off all colliding with each other. Pairs of static objects
+			//never collide, whatever their layers
+			void SetLayerCollisions(int layerA, int layerB, bool state);
+			bool GetLayerCollisions(int layerA, int layerB) const;
+
+			static const int MaxCollisionLayers = 32;
 		protected:
+			bool ShouldTestPair(const GameObject* a, const GameObject* b) const;
+			void AddBroadPhasePair(GameObject* a, GameObject* b);
+
 			void BasicCollisionDetection();
 			void BroadPhase();
+			void QuadTreeBroadPhase();
+			void AABBTreeBroadPhase();
+			void UpdateRaycastTree();
+			void SyncBroadPhaseTree();
+			void SweepAndPruneBroadPhase();
+			void OctreeBroadPhase();
+			void BuildOctree();
+			void ResetBroadPhaseState();
+			void SyncStaticTree();
+			void StaticBroadPhase();
 			void NarrowPhase();
+			void TestSpherePairs(int first, int last, SpherePairBatch& batch, std::vector<CollisionDetection::CollisionInfo>& contacts) const;
+			void TestAABBPairs(int first, int last, AABBPairBatch& batch, std::vector<CollisionDetection::CollisionInfo>& contacts) const;
 
-			void ClearForces();
+			void UpdateKeys();
+			void Step(float dt);
+			void StorePreviousPoses();
+			void ResetInterpolation();
 
 			void IntegrateAccel(float dt);
 			void IntegrateVelocity(float dt);
+			void SweepFastBodies(float dt);
+			void StopFastBodies();
 
 			void UpdateConstraints(float dt);
+			void UpdateColouredConstraints(float dt, int iterations);
+			void UpdateConstraint(Constraint* c, float dt);
+			void CopyConstrainedBodiesOut();
+			void CopyConstrainedBodiesIn();
+
+			void UpdateIslands(float dt);
+			int  FindIsland(int body);
+			void JoinIslands(GameObject* a, GameObject* b);
+			bool IsPairAsleep(GameObject* a, GameObject* b) const;
+			void KeepSleepingContact(const CollisionDetection::CollisionInfo& info);
+			void WakeAll();
 
 			void UpdateCollisionList();
 			void UpdateObjectAABBs();
 
-			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
+			void SolveContacts();
+			Vector3 ContactVelocity(const SolverContact& sc) const;
+			void ApplyContactImpulse(const SolverContact& sc, const Vector3& impulse);
 
 			GameWorld& gameWorld;
 
 			bool	applyGravity;
 			Vector3 gravity;
-			float	dTOffset;
 			float	globalDamping;
 			float dampingFactor;
 
-			std::set<CollisionDetection::CollisionInfo> allCollisions;
-			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
-			std::vector<CollisionDetection::CollisionInfo> broadphaseCollisionsVec;
+			ContactCache allCollisions;
+			std::vector<SolverContact> solverContacts;
+			PhysicsProfiler	profiler;
+			bool			drawProfile				= false;
+			bool			useKeyboardControls		= true;
+			bool			useSimpleContainer		= false;
+
+			TickScheduler	tickScheduler;
+			bool			useInterpolation		= true;
+			int				interpolationWorldState	= -1;
+
+			int		stepCount				= 0;
+			int		contactIterationCount	= 5;
+			int		constraintIterations	= 10;
+			float	restitutionThreshold	= 1.0f;	//Slower impacts than this don't bounce
+			float	penetrationSlop			= 0.01f;	//How much overlap we leave resting contacts
+			std::vector<CollisionDetection::CollisionInfo> broadphaseCollisions;
+			unsigned int layerMatrix[MaxCollisionLayers];	//Bit n of entry m is set if layers m and n collide
 			bool useBroadPhase		= true;
 			int numCollisionFrames	= 5;
+
+			BroadPhaseType broadPhaseType = BroadPhaseType::None;
+
+			FlatQuadTree<GameObject*>						quadTree;
+			Octree<GameObject*>								octree;
+			std::vector<std::pair<GameObject*, GameObject*>>	candidatePairs;
+
+			DynamicAABBTree<GameObject*>				broadPhaseTree;
+			std::map<GameObject*, int>					treeProxies;
+			std::set<std::pair<int, int>>				treePairs;
+			std::vector<int>							movedProxies;
+			int											treeWorldState = -1;
+
+			StaticBVH<GameObject*>						staticTree;
+			std::vector<std::pair<GameObject*, int>>	staticObjects;	//And their world IDs, to spot any changes
+			int											staticWorldState = -1;
+
+			SweepAndPrune<GameObject*>	sweepAndPrune;
+			std::vector<GameObject*>	sweepObjects;
+			int							sweepWorldState = -1;
+
+			bool	useSleeping				= true;
+			float	sleepLinearThreshold	= 0.3f;
+			float	sleepAngularThreshold	= 0.3f;
+			float	sleepTime				= 0.5f;
+			SleepStats	sleepStats;
+
+			std::vector<GameObject*>	islandBodies;
+			std::vector<int>			islandParents;
+			std::vector<char>			islandAwake;
+			std::vector<char>			islandRested;
+
+			RigidBodyStore	bodyStore;
+
+			ThreadPool	workerPool;
+			bool		useParallelNarrowPhase	= true;
+			int			narrowPhaseMinRange		= 64;	//pairs per thread before it's worth waking another
+			std::vector<CollisionDetection::CollisionInfo>				narrowPhaseAwake;	//in broadphase order
+			std::vector<int>											narrowPhaseSlots;
+			std::vector<CollisionDetection::CollisionInfo>				narrowPhasePairs;	//grouped by pair test
+			std::vector<std::vector<CollisionDetection::CollisionInfo>>	narrowPhaseContacts;
+			std::vector<CollisionDetection::CollisionInfo>				narrowPhaseResults;
+			bool						useBatchedNarrowPhase = true;
+			std::vector<SpherePairBatch>	sphereBatches;	//one of each per narrowphase range
+			std::vector<AABBPairBatch>		aabbBatches;
+
+			struct FastBodyStop {
+				GameObject* object;
+				Vector3		position;	//just past where it first touched something
+			};
+			bool						useContinuousCollision	= true;
+			float						fastBodyThreshold		= 0.5f;	//of its radius a body must move in a step to be swept
+			std::vector<FastBodyStop>	fastBodyStops;
+
+			static constexpr int ConvexCacheLifetime = 64;	//steps a GJK cache is kept without its pair turning up
+			std::unordered_map<uint64_t, GJKCache>	convexCaches;
+
+			ConstraintSolver	constraintSolver;
+			std::vector<PhysicsObject*>	constrainedBodies;	//Copied out of the RigidBodyStore around the constraints
+			bool				useParallelConstraints	= true;
+			int					constraintMinRange		= 256;	//links per thread within a colour
 		};
 	}
 }
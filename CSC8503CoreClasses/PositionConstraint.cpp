@@ -30,7 +30,7 @@ void PositionConstraint::UpdateConstraint(float dt) {
 	float currentDistance = relativePos.Length();
 	float offset = distance - currentDistance;
 
-	if (abs(offset) > .0f) {
+	if (std::abs(offset) > .0f) {
 		Vector3 offsetDir = relativePos.Normalised();
 
 		PhysicsObject* physA = objectA->GetPhysicsObject();
@@ -12,6 +12,15 @@ namespace NCL {
 
 			void UpdateConstraint(float dt) override;
 
+			void GetConstrainedObjects(GameObject*& a, GameObject*& b) const override {
+				a = objectA;
+				b = objectB;
+			}
+
+			float GetDistance() const {
+				return distance;
+			}
+
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
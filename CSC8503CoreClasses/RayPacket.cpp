@@ -0,0 +1,128 @@
+#include "RayPacket.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RAYPACKET_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+RayPacket::RayPacket(const Ray* rays, int rayCount) {
+	count		= std::clamp(rayCount, 0, Width);
+	activeLanes = (1 << count) - 1;
+
+	for (int i = 0; i < Width; ++i) {
+		//Spare lanes copy the first ray, so they don't fill the tests with NaNs
+		const Ray& r = rays[i < count ? i : 0];
+		Vector3 pos = count > 0 ? r.GetPosition() : Vector3();
+		Vector3 dir = count > 0 ? r.GetDirection() : Vector3(1, 0, 0);
+
+		posX[i]		= pos.x;
+		posY[i]		= pos.y;
+		posZ[i]		= pos.z;
+		dirX[i]		= dir.x;
+		dirY[i]		= dir.y;
+		dirZ[i]		= dir.z;
+		invDirX[i]	= 1.0f / dir.x;
+		invDirY[i]	= 1.0f / dir.y;
+		invDirZ[i]	= 1.0f / dir.z;
+	}
+}
+
+/*
+The same slab test as CollisionDetection::RaySlabTest, one lane per ray.
+Each axis clips the range of the ray inside the box, and a lane hits if
+there's anything left of its range by the end.
+*/
+int RayPacket::SlabTest(const Vector3& boxMin, const Vector3& boxMax, const float* maxDistance, float* tEnter) const {
+#ifdef RAYPACKET_USE_SSE
+	__m128 tMin = _mm_setzero_ps();
+	__m128 tMax = _mm_loadu_ps(maxDistance);
+
+	const float* pos[3]		= { posX, posY, posZ };
+	const float* invDir[3]	= { invDirX, invDirY, invDirZ };
+	for (int axis = 0; axis < 3; ++axis) {
+		__m128 p	= _mm_load_ps(pos[axis]);
+		__m128 inv	= _mm_load_ps(invDir[axis]);
+		__m128 t0	= _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxMin[axis]), p), inv);
+		__m128 t1	= _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxMax[axis]), p), inv);
+		tMin = _mm_max_ps(tMin, _mm_min_ps(t0, t1));
+		tMax = _mm_min_ps(tMax, _mm_max_ps(t0, t1));
+	}
+	_mm_storeu_ps(tEnter, tMin);
+	return _mm_movemask_ps(_mm_cmple_ps(tMin, tMax)) & activeLanes;
+#else
+	int hits = 0;
+	for (int i = 0; i < count; ++i) {
+		float tMin = 0.0f;
+		float tMax = maxDistance[i];
+		const float pos[3]		= { posX[i], posY[i], posZ[i] };
+		const float invDir[3]	= { invDirX[i], invDirY[i], invDirZ[i] };
+		for (int axis = 0; axis < 3; ++axis) {
+			float t0 = (boxMin[axis] - pos[axis]) * invDir[axis];
+			float t1 = (boxMax[axis] - pos[axis]) * invDir[axis];
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+		tEnter[i] = tMin;
+		if (tMin <= tMax) {
+			hits |= 1 << i;
+		}
+	}
+	return hits;
+#endif
+}
+
+/*
+Projects the sphere's centre onto each ray, and measures how far that
+point is from the centre - if it's within the radius, the ray goes
+through the sphere, entering it a little before the projected point.
+*/
+int RayPacket::SphereTest(const Vector3& centre, float radius, const float* maxDistance, float* tHit) const {
+#ifdef RAYPACKET_USE_SSE
+	__m128 px = _mm_load_ps(posX);
+	__m128 py = _mm_load_ps(posY);
+	__m128 pz = _mm_load_ps(posZ);
+	__m128 dx = _mm_load_ps(dirX);
+	__m128 dy = _mm_load_ps(dirY);
+	__m128 dz = _mm_load_ps(dirZ);
+
+	__m128 cx = _mm_sub_ps(_mm_set1_ps(centre.x), px);
+	__m128 cy = _mm_sub_ps(_mm_set1_ps(centre.y), py);
+	__m128 cz = _mm_sub_ps(_mm_set1_ps(centre.z), pz);
+	__m128 proj = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, dx), _mm_mul_ps(cy, dy)), _mm_mul_ps(cz, dz));
+
+	//The closest point on each ray, relative to the centre
+	__m128 qx = _mm_sub_ps(_mm_mul_ps(dx, proj), cx);
+	__m128 qy = _mm_sub_ps(_mm_mul_ps(dy, proj), cy);
+	__m128 qz = _mm_sub_ps(_mm_mul_ps(dz, proj), cz);
+	__m128 distSq	= _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz));
+	__m128 radiusSq = _mm_set1_ps(radius * radius);
+
+	__m128 offset	= _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radiusSq, distSq), _mm_setzero_ps()));
+	__m128 t		= _mm_sub_ps(proj, offset);
+	_mm_storeu_ps(tHit, t);
+
+	__m128 hit = _mm_and_ps(_mm_cmpge_ps(proj, _mm_setzero_ps()), _mm_cmple_ps(distSq, radiusSq));
+	hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_loadu_ps(maxDistance)));
+	return _mm_movemask_ps(hit) & activeLanes;
+#else
+	int hits = 0;
+	float radiusSq = radius * radius;
+	for (int i = 0; i < count; ++i) {
+		Vector3 pos(posX[i], posY[i], posZ[i]);
+		Vector3 dir(dirX[i], dirY[i], dirZ[i]);
+		float proj = Vector3::Dot(centre - pos, dir);
+		Vector3 q = pos + dir * proj - centre;
+		float distSq = Vector3::Dot(q, q);
+		tHit[i] = proj - std::sqrt(std::max(radiusSq - distSq, 0.0f));
+		if (proj >= 0.0f && distSq <= radiusSq && tHit[i] < maxDistance[i]) {
+			hits |= 1 << i;
+		}
+	}
+	return hits;
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Vector3.h"
+#include "Ray.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Up to four rays, stored lane by lane rather than ray by ray, so that
+		the slab and sphere tests can be run against all of them at once with
+		SSE. The spatial trees walk a whole packet down together, and only
+		visit a node once for every ray that might pass through it.
+
+		Tests return a mask with a bit set for each lane that hit, and only
+		count hits closer than that lane's maxDistance - so a lane that has
+		already found something can't be hit by anything behind it.
+		*/
+		struct RayPacket {
+			static constexpr int Width = 4;
+
+			alignas(16) float posX[Width];
+			alignas(16) float posY[Width];
+			alignas(16) float posZ[Width];
+			alignas(16) float dirX[Width];
+			alignas(16) float dirY[Width];
+			alignas(16) float dirZ[Width];
+			alignas(16) float invDirX[Width];
+			alignas(16) float invDirY[Width];
+			alignas(16) float invDirZ[Width];
+
+			int count;
+			int activeLanes;
+
+			//Takes up to Width rays, any lanes left over never hit anything
+			RayPacket(const Ray* rays, int rayCount);
+
+			Ray GetRay(int lane) const {
+				return Ray(Vector3(posX[lane], posY[lane], posZ[lane]), Vector3(dirX[lane], dirY[lane], dirZ[lane]));
+			}
+
+			//tEnter is how far along each lane's ray it enters the box
+			int SlabTest(const Vector3& boxMin, const Vector3& boxMax, const float* maxDistance, float* tEnter) const;
+
+			//Matches CollisionDetection::RaySphereIntersection, with tHit the distance to the sphere's surface
+			int SphereTest(const Vector3& centre, float radius, const float* maxDistance, float* tHit) const;
+		};
+	}
+}
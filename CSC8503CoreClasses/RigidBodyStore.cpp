@@ -0,0 +1,557 @@
+#include "RigidBodyStore.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "Transform.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RIGIDBODY_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+void RigidBodyStore::Clear() {
+	gameObjects.clear();
+	physicsObjects.clear();
+	transforms.clear();
+	movedTransforms.clear();
+	interpolatedTransforms.clear();
+	worldState		= -1;
+	awakeCount		= 0;
+	dynamicCount	= 0;
+	Resize(0);
+}
+
+#define RIGIDBODY_ARRAYS	&posX, &posY, &posZ,						\
+							&rotX, &rotY, &rotZ, &rotW,					\
+							&linVelX, &linVelY, &linVelZ,				\
+							&angVelX, &angVelY, &angVelZ,				\
+							&forceX, &forceY, &forceZ,					\
+							&torqueX, &torqueY, &torqueZ,				\
+							&invInertiaX, &invInertiaY, &invInertiaZ,	\
+							&tensorXX, &tensorYY, &tensorZZ,			\
+							&tensorXY, &tensorXZ, &tensorYZ,			\
+							&inverseMass, &gravityScale
+
+void RigidBodyStore::Resize(int count) {
+	for (std::vector<float>* a : { RIGIDBODY_ARRAYS }) {
+		a->resize(count);
+	}
+}
+
+/*
+Everything is put in world order - awake bodies, then sleeping ones, then
+static geometry - and the slots are then kept until the next time something
+is added to or removed from the world.
+*/
+void RigidBodyStore::SyncBodies(ObjectIterator first, ObjectIterator last, int newWorldState) {
+	if (worldState == newWorldState) {
+		return;
+	}
+	worldState = newWorldState;
+
+	gameObjects.clear();
+	physicsObjects.clear();
+	transforms.clear();
+	Resize(0);
+
+	for (int group = 0; group < 3; ++group) {
+		for (auto i = first; i != last; ++i) {
+			PhysicsObject* object = (*i)->GetPhysicsObject();
+			if (object == nullptr) {
+				continue;
+			}
+			int objectGroup = (*i)->IsStaticGeometry() ? 2 : (object->IsAsleep() ? 1 : 0);
+			if (objectGroup != group) {
+				continue;
+			}
+			object->SetBodySlot((int)physicsObjects.size());
+			gameObjects.push_back(*i);
+			physicsObjects.push_back(object);
+			transforms.push_back(&(*i)->GetTransform());
+		}
+		if (group == 0) {
+			awakeCount = (int)physicsObjects.size();
+		}
+		else if (group == 1) {
+			dynamicCount = (int)physicsObjects.size();
+		}
+	}
+	Resize(GetBodyCount());
+}
+
+/*
+Between frames the game can push objects about, wake them up, put them to
+sleep or just put them somewhere else, so this is the one time every body
+is read back from its objects.
+*/
+void RigidBodyStore::BeginFrame() {
+	for (int i = awakeCount; i < dynamicCount; ++i) {
+		if (!physicsObjects[i]->IsAsleep()) {
+			SwapSlots(i, awakeCount);
+			awakeCount++;
+		}
+	}
+	for (int i = awakeCount - 1; i >= 0; --i) {
+		if (physicsObjects[i]->IsAsleep()) {
+			awakeCount--;
+			SwapSlots(i, awakeCount);
+		}
+	}
+	int count = GetBodyCount();
+	for (int i = 0; i < count; ++i) {
+		LoadBody(i);
+	}
+}
+
+/*
+Sleeping bodies were stopped by PhysicsObject::Sleep, and static geometry
+is never moved by us. Anything still awake has probably moved this frame,
+and anything that fell asleep during it was added to movedTransforms then.
+
+We're finished with the forces too, so they're cleared while we're here,
+ready to receive new ones in the next 'game' frame - every object is a
+cache miss, so it's better not to go round them all twice.
+*/
+void RigidBodyStore::EndFrame() {
+	movedTransforms.insert(movedTransforms.end(), transforms.begin(), transforms.begin() + awakeCount);
+	for (int i = 0; i < awakeCount; ++i) {
+		PhysicsObject* object = physicsObjects[i];
+		object->SetLinearVelocity(GetLinearVelocity(i));
+		object->SetAngularVelocity(GetAngularVelocity(i));
+		object->SetInertiaTensor(GetInertiaTensor(i));
+		object->ClearForces();
+	}
+	int count = GetBodyCount();
+	for (int i = awakeCount; i < count; ++i) {
+		physicsObjects[i]->ClearForces();
+	}
+}
+
+//Objects keep their slot number, but it's only ours if it still points back at them
+int RigidBodyStore::FindSlot(const PhysicsObject& object) const {
+	int slot = object.GetBodySlot();
+	if (slot < 0 || slot >= GetBodyCount() || physicsObjects[slot] != &object) {
+		return -1;
+	}
+	return slot;
+}
+
+Matrix3 RigidBodyStore::GetInertiaTensor(int slot) const {
+	Matrix3 m;
+	m.array[0][0] = tensorXX[slot];
+	m.array[1][1] = tensorYY[slot];
+	m.array[2][2] = tensorZZ[slot];
+	m.array[0][1] = m.array[1][0] = tensorXY[slot];
+	m.array[0][2] = m.array[2][0] = tensorXZ[slot];
+	m.array[1][2] = m.array[2][1] = tensorYZ[slot];
+	return m;
+}
+
+Vector3 RigidBodyStore::GetLinearVelocity(const PhysicsObject& object) const {
+	int slot = FindSlot(object);
+	return slot < 0 ? object.GetLinearVelocity() : GetLinearVelocity(slot);
+}
+
+Vector3 RigidBodyStore::GetAngularVelocity(const PhysicsObject& object) const {
+	int slot = FindSlot(object);
+	return slot < 0 ? object.GetAngularVelocity() : GetAngularVelocity(slot);
+}
+
+//The same as PhysicsObject's, other than waking the object - the contact solver does that up front
+void RigidBodyStore::ApplyLinearImpulse(int slot, const Vector3& impulse) {
+	float invMass = inverseMass[slot];
+	linVelX[slot] += impulse.x * invMass;
+	linVelY[slot] += impulse.y * invMass;
+	linVelZ[slot] += impulse.z * invMass;
+}
+
+void RigidBodyStore::ApplyAngularImpulse(int slot, const Vector3& impulse) {
+	angVelX[slot] += tensorXX[slot] * impulse.x + tensorXY[slot] * impulse.y + tensorXZ[slot] * impulse.z;
+	angVelY[slot] += tensorXY[slot] * impulse.x + tensorYY[slot] * impulse.y + tensorYZ[slot] * impulse.z;
+	angVelZ[slot] += tensorXZ[slot] * impulse.x + tensorYZ[slot] * impulse.y + tensorZZ[slot] * impulse.z;
+}
+
+void RigidBodyStore::CopyToObject(PhysicsObject& object) const {
+	int slot = FindSlot(object);
+	if (slot >= 0) {
+		object.SetLinearVelocity(GetLinearVelocity(slot));
+		object.SetAngularVelocity(GetAngularVelocity(slot));
+		object.SetInertiaTensor(GetInertiaTensor(slot));
+	}
+}
+
+void RigidBodyStore::CopyFromObject(const PhysicsObject& object) {
+	int slot = FindSlot(object);
+	if (slot < 0) {
+		return;
+	}
+	Vector3 linearVel	= object.GetLinearVelocity();
+	Vector3 angVel		= object.GetAngularVelocity();
+	linVelX[slot] = linearVel.x;
+	linVelY[slot] = linearVel.y;
+	linVelZ[slot] = linearVel.z;
+	angVelX[slot] = angVel.x;
+	angVelY[slot] = angVel.y;
+	angVelZ[slot] = angVel.z;
+}
+
+/*
+Whatever the contact solver or constraints did to a sleeping body's slot
+is already in the arrays, so waking one doesn't need it read back in. Going
+to sleep stops it dead, the same as PhysicsObject::Sleep, and EndFrame
+won't be handing it its inertia tensor, so it gets that now.
+*/
+void RigidBodyStore::SetAwake(const PhysicsObject& object, bool state) {
+	int slot = FindSlot(object);
+	if (slot < 0 || slot >= dynamicCount || (slot < awakeCount) == state) {
+		return;
+	}
+	if (state) {
+		SwapSlots(slot, awakeCount);
+		awakeCount++;
+		return;
+	}
+	awakeCount--;
+	SwapSlots(slot, awakeCount);
+	movedTransforms.push_back(transforms[awakeCount]);
+	physicsObjects[awakeCount]->SetInertiaTensor(GetInertiaTensor(awakeCount));
+	for (std::vector<float>* a : {	&linVelX, &linVelY, &linVelZ,
+									&angVelX, &angVelY, &angVelZ,
+									&forceX, &forceY, &forceZ,
+									&torqueX, &torqueY, &torqueZ }) {
+		(*a)[awakeCount] = 0.0f;
+	}
+}
+
+void RigidBodyStore::SetPosition(const PhysicsObject& object, const Vector3& position) {
+	int slot = FindSlot(object);
+	if (slot >= 0) {
+		posX[slot] = position.x;
+		posY[slot] = position.y;
+		posZ[slot] = position.z;
+	}
+}
+
+void RigidBodyStore::SwapSlots(int a, int b) {
+	if (a == b) {
+		return;
+	}
+	std::swap(gameObjects[a], gameObjects[b]);
+	std::swap(physicsObjects[a], physicsObjects[b]);
+	std::swap(transforms[a], transforms[b]);
+	for (std::vector<float>* v : { RIGIDBODY_ARRAYS }) {
+		std::swap((*v)[a], (*v)[b]);
+	}
+	physicsObjects[a]->SetBodySlot(a);
+	physicsObjects[b]->SetBodySlot(b);
+}
+
+/*
+The world space inertia tensor only changes when the body turns, or its
+inertia is changed, so it's only rebuilt here if something other than the
+integrator has done either - the integrator rebuilds it as it goes. The
+object's copy is kept up to date too, for anything the game does with it.
+*/
+void RigidBodyStore::LoadBody(int i) {
+	PhysicsObject*	object		= physicsObjects[i];
+	Vector3			position	= transforms[i]->GetPosition();
+	Quaternion		orientation	= transforms[i]->GetOrientation();
+	Vector3			linearVel	= object->GetLinearVelocity();
+	Vector3			angVel		= object->GetAngularVelocity();
+	Vector3			force		= object->GetForce();
+	Vector3			torque		= object->GetTorque();
+	Vector3			invInertia	= object->GetInverseInertia();
+
+	bool turned =	orientation.x != rotX[i] || orientation.y != rotY[i] || orientation.z != rotZ[i] || orientation.w != rotW[i] ||
+					invInertia.x != invInertiaX[i] || invInertia.y != invInertiaY[i] || invInertia.z != invInertiaZ[i];
+
+	posX[i] = position.x;
+	posY[i] = position.y;
+	posZ[i] = position.z;
+
+	rotX[i] = orientation.x;
+	rotY[i] = orientation.y;
+	rotZ[i] = orientation.z;
+	rotW[i] = orientation.w;
+
+	linVelX[i] = linearVel.x;
+	linVelY[i] = linearVel.y;
+	linVelZ[i] = linearVel.z;
+
+	angVelX[i] = angVel.x;
+	angVelY[i] = angVel.y;
+	angVelZ[i] = angVel.z;
+
+	forceX[i] = force.x;
+	forceY[i] = force.y;
+	forceZ[i] = force.z;
+
+	torqueX[i] = torque.x;
+	torqueY[i] = torque.y;
+	torqueZ[i] = torque.z;
+
+	invInertiaX[i] = invInertia.x;
+	invInertiaY[i] = invInertia.y;
+	invInertiaZ[i] = invInertia.z;
+
+	inverseMass[i]	= object->GetInverseMass();
+	gravityScale[i]	= object->GetInverseMass() > 0 && gameObjects[i]->GetIsAffectedByGravity() ? 1.0f : 0.0f;
+
+	if (turned) {
+		UpdateInertiaTensor(i);
+		object->SetInertiaTensor(GetInertiaTensor(i));
+	}
+}
+
+/*
+R * diag(invInertia) * R transposed, with R the orientation's rotation
+matrix - the same as PhysicsObject::UpdateInertiaTensor, but written out
+so the kernel below can do four bodies at a time.
+*/
+void RigidBodyStore::UpdateInertiaTensor(int i) {
+	float x = rotX[i], y = rotY[i], z = rotZ[i], w = rotW[i];
+
+	float r00 = 1.0f - 2.0f * (y * y + z * z);
+	float r01 = 2.0f * (x * y - z * w);
+	float r02 = 2.0f * (x * z + y * w);
+	float r10 = 2.0f * (x * y + z * w);
+	float r11 = 1.0f - 2.0f * (x * x + z * z);
+	float r12 = 2.0f * (y * z - x * w);
+	float r20 = 2.0f * (x * z - y * w);
+	float r21 = 2.0f * (y * z + x * w);
+	float r22 = 1.0f - 2.0f * (x * x + y * y);
+
+	float s0 = invInertiaX[i], s1 = invInertiaY[i], s2 = invInertiaZ[i];
+
+	tensorXX[i] = r00 * r00 * s0 + r01 * r01 * s1 + r02 * r02 * s2;
+	tensorYY[i] = r10 * r10 * s0 + r11 * r11 * s1 + r12 * r12 * s2;
+	tensorZZ[i] = r20 * r20 * s0 + r21 * r21 * s1 + r22 * r22 * s2;
+	tensorXY[i] = r00 * r10 * s0 + r01 * r11 * s1 + r02 * r12 * s2;
+	tensorXZ[i] = r00 * r20 * s0 + r01 * r21 * s1 + r02 * r22 * s2;
+	tensorYZ[i] = r10 * r20 * s0 + r11 * r21 * s1 + r12 * r22 * s2;
+}
+
+//Turns the forces accumulated over the last frame into velocity changes
+void RigidBodyStore::IntegrateAccel(float dt, const Vector3& gravity) {
+	AccelKernel(dt, gravity);
+}
+
+void RigidBodyStore::AccelKernel(float dt, const Vector3& gravity) {
+	int i = 0;
+#ifdef RIGIDBODY_USE_SSE
+	const __m128 dtv	= _mm_set1_ps(dt);
+	const __m128 gx		= _mm_set1_ps(gravity.x);
+	const __m128 gy		= _mm_set1_ps(gravity.y);
+	const __m128 gz		= _mm_set1_ps(gravity.z);
+	for (; i + 4 <= awakeCount; i += 4) {
+		__m128 invMass	= _mm_loadu_ps(&inverseMass[i]);
+		__m128 gScale	= _mm_loadu_ps(&gravityScale[i]);
+
+		__m128 ax = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&forceX[i]), invMass), _mm_mul_ps(gx, gScale));
+		__m128 ay = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&forceY[i]), invMass), _mm_mul_ps(gy, gScale));
+		__m128 az = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&forceZ[i]), invMass), _mm_mul_ps(gz, gScale));
+
+		_mm_storeu_ps(&linVelX[i], _mm_add_ps(_mm_loadu_ps(&linVelX[i]), _mm_mul_ps(ax, dtv)));
+		_mm_storeu_ps(&linVelY[i], _mm_add_ps(_mm_loadu_ps(&linVelY[i]), _mm_mul_ps(ay, dtv)));
+		_mm_storeu_ps(&linVelZ[i], _mm_add_ps(_mm_loadu_ps(&linVelZ[i]), _mm_mul_ps(az, dtv)));
+
+		__m128 tx = _mm_loadu_ps(&torqueX[i]);
+		__m128 ty = _mm_loadu_ps(&torqueY[i]);
+		__m128 tz = _mm_loadu_ps(&torqueZ[i]);
+		__m128 xx = _mm_loadu_ps(&tensorXX[i]);
+		__m128 yy = _mm_loadu_ps(&tensorYY[i]);
+		__m128 zz = _mm_loadu_ps(&tensorZZ[i]);
+		__m128 xy = _mm_loadu_ps(&tensorXY[i]);
+		__m128 xz = _mm_loadu_ps(&tensorXZ[i]);
+		__m128 yz = _mm_loadu_ps(&tensorYZ[i]);
+
+		__m128 aax = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, tx), _mm_mul_ps(xy, ty)), _mm_mul_ps(xz, tz));
+		__m128 aay = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xy, tx), _mm_mul_ps(yy, ty)), _mm_mul_ps(yz, tz));
+		__m128 aaz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xz, tx), _mm_mul_ps(yz, ty)), _mm_mul_ps(zz, tz));
+
+		_mm_storeu_ps(&angVelX[i], _mm_add_ps(_mm_loadu_ps(&angVelX[i]), _mm_mul_ps(aax, dtv)));
+		_mm_storeu_ps(&angVelY[i], _mm_add_ps(_mm_loadu_ps(&angVelY[i]), _mm_mul_ps(aay, dtv)));
+		_mm_storeu_ps(&angVelZ[i], _mm_add_ps(_mm_loadu_ps(&angVelZ[i]), _mm_mul_ps(aaz, dtv)));
+	}
+#endif
+	for (; i < awakeCount; ++i) {
+		linVelX[i] += (forceX[i] * inverseMass[i] + gravity.x * gravityScale[i]) * dt;
+		linVelY[i] += (forceY[i] * inverseMass[i] + gravity.y * gravityScale[i]) * dt;
+		linVelZ[i] += (forceZ[i] * inverseMass[i] + gravity.z * gravityScale[i]) * dt;
+
+		float tx = torqueX[i];
+		float ty = torqueY[i];
+		float tz = torqueZ[i];
+		angVelX[i] += (tensorXX[i] * tx + tensorXY[i] * ty + tensorXZ[i] * tz) * dt;
+		angVelY[i] += (tensorXY[i] * tx + tensorYY[i] * ty + tensorYZ[i] * tz) * dt;
+		angVelZ[i] += (tensorXZ[i] * tx + tensorYZ[i] * ty + tensorZZ[i] * tz) * dt;
+	}
+}
+
+/*
+Moves every awake object along by its velocity, and then damps it down.
+The new positions go straight into the transforms, as the broadphase and
+narrowphase need them next step, but the matrices wait for
+WriteBackTransforms.
+*/
+void RigidBodyStore::IntegrateVelocity(float dt, float damping) {
+	VelocityKernel(dt, damping);
+
+	for (int i = 0; i < awakeCount; ++i) {
+		transforms[i]->SetPoseDeferred(Vector3(posX[i], posY[i], posZ[i]), Quaternion(rotX[i], rotY[i], rotZ[i], rotW[i]));
+	}
+}
+
+/*
+The orientation update is the same as adding Quaternion(angVel * dt * 0.5f, 0)
+* orientation, expanded out, before normalising the result. The inertia
+tensor is then rebuilt for the new orientation, as in UpdateInertiaTensor.
+*/
+void RigidBodyStore::VelocityKernel(float dt, float damping) {
+	int i = 0;
+#ifdef RIGIDBODY_USE_SSE
+	const __m128 dtv		= _mm_set1_ps(dt);
+	const __m128 halfDt		= _mm_set1_ps(dt * 0.5f);
+	const __m128 damp		= _mm_set1_ps(damping);
+	const __m128 zero		= _mm_setzero_ps();
+	const __m128 one		= _mm_set1_ps(1.0f);
+	const __m128 two		= _mm_set1_ps(2.0f);
+	for (; i + 4 <= awakeCount; i += 4) {
+		__m128 vx = _mm_loadu_ps(&linVelX[i]);
+		__m128 vy = _mm_loadu_ps(&linVelY[i]);
+		__m128 vz = _mm_loadu_ps(&linVelZ[i]);
+
+		_mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, dtv)));
+		_mm_storeu_ps(&posY[i], _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, dtv)));
+		_mm_storeu_ps(&posZ[i], _mm_add_ps(_mm_loadu_ps(&posZ[i]), _mm_mul_ps(vz, dtv)));
+
+		_mm_storeu_ps(&linVelX[i], _mm_mul_ps(vx, damp));
+		_mm_storeu_ps(&linVelY[i], _mm_mul_ps(vy, damp));
+		_mm_storeu_ps(&linVelZ[i], _mm_mul_ps(vz, damp));
+
+		__m128 wx = _mm_loadu_ps(&angVelX[i]);
+		__m128 wy = _mm_loadu_ps(&angVelY[i]);
+		__m128 wz = _mm_loadu_ps(&angVelZ[i]);
+
+		__m128 hx = _mm_mul_ps(wx, halfDt);
+		__m128 hy = _mm_mul_ps(wy, halfDt);
+		__m128 hz = _mm_mul_ps(wz, halfDt);
+
+		__m128 qx = _mm_loadu_ps(&rotX[i]);
+		__m128 qy = _mm_loadu_ps(&rotY[i]);
+		__m128 qz = _mm_loadu_ps(&rotZ[i]);
+		__m128 qw = _mm_loadu_ps(&rotW[i]);
+
+		__m128 nx = _mm_add_ps(qx, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(hx, qw), _mm_mul_ps(hy, qz)), _mm_mul_ps(hz, qy)));
+		__m128 ny = _mm_add_ps(qy, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(hy, qw), _mm_mul_ps(hz, qx)), _mm_mul_ps(hx, qz)));
+		__m128 nz = _mm_add_ps(qz, _mm_sub_ps(_mm_add_ps(_mm_mul_ps(hz, qw), _mm_mul_ps(hx, qy)), _mm_mul_ps(hy, qx)));
+		__m128 nw = _mm_sub_ps(qw, _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, qx), _mm_mul_ps(hy, qy)), _mm_mul_ps(hz, qz)));
+
+		__m128 magSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_add_ps(_mm_mul_ps(nz, nz), _mm_mul_ps(nw, nw)));
+		//Zero length quaternions are left alone, same as Quaternion::Normalise
+		__m128 valid	= _mm_cmpgt_ps(magSq, zero);
+		__m128 scale	= _mm_div_ps(one, _mm_sqrt_ps(_mm_or_ps(_mm_and_ps(valid, magSq), _mm_andnot_ps(valid, one))));
+
+		__m128 x = _mm_mul_ps(nx, scale);
+		__m128 y = _mm_mul_ps(ny, scale);
+		__m128 z = _mm_mul_ps(nz, scale);
+		__m128 w = _mm_mul_ps(nw, scale);
+		_mm_storeu_ps(&rotX[i], x);
+		_mm_storeu_ps(&rotY[i], y);
+		_mm_storeu_ps(&rotZ[i], z);
+		_mm_storeu_ps(&rotW[i], w);
+
+		_mm_storeu_ps(&angVelX[i], _mm_mul_ps(wx, damp));
+		_mm_storeu_ps(&angVelY[i], _mm_mul_ps(wy, damp));
+		_mm_storeu_ps(&angVelZ[i], _mm_mul_ps(wz, damp));
+
+		__m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z))));
+		__m128 r01 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(x, y), _mm_mul_ps(z, w)));
+		__m128 r02 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, z), _mm_mul_ps(y, w)));
+		__m128 r10 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, y), _mm_mul_ps(z, w)));
+		__m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(z, z))));
+		__m128 r12 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(y, z), _mm_mul_ps(x, w)));
+		__m128 r20 = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(x, z), _mm_mul_ps(y, w)));
+		__m128 r21 = _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(y, z), _mm_mul_ps(x, w)));
+		__m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+
+		__m128 s0 = _mm_loadu_ps(&invInertiaX[i]);
+		__m128 s1 = _mm_loadu_ps(&invInertiaY[i]);
+		__m128 s2 = _mm_loadu_ps(&invInertiaZ[i]);
+
+		//Each row of R scaled by the inverse inertia, dotted with each row of R
+		__m128 a0 = _mm_mul_ps(r00, s0), a1 = _mm_mul_ps(r01, s1), a2 = _mm_mul_ps(r02, s2);
+		__m128 b0 = _mm_mul_ps(r10, s0), b1 = _mm_mul_ps(r11, s1), b2 = _mm_mul_ps(r12, s2);
+		__m128 c0 = _mm_mul_ps(r20, s0), c1 = _mm_mul_ps(r21, s1), c2 = _mm_mul_ps(r22, s2);
+
+		_mm_storeu_ps(&tensorXX[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, r00), _mm_mul_ps(a1, r01)), _mm_mul_ps(a2, r02)));
+		_mm_storeu_ps(&tensorYY[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, r10), _mm_mul_ps(b1, r11)), _mm_mul_ps(b2, r12)));
+		_mm_storeu_ps(&tensorZZ[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, r20), _mm_mul_ps(c1, r21)), _mm_mul_ps(c2, r22)));
+		_mm_storeu_ps(&tensorXY[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, r10), _mm_mul_ps(a1, r11)), _mm_mul_ps(a2, r12)));
+		_mm_storeu_ps(&tensorXZ[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, r20), _mm_mul_ps(a1, r21)), _mm_mul_ps(a2, r22)));
+		_mm_storeu_ps(&tensorYZ[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, r20), _mm_mul_ps(b1, r21)), _mm_mul_ps(b2, r22)));
+	}
+#endif
+	for (; i < awakeCount; ++i) {
+		posX[i] += linVelX[i] * dt;
+		posY[i] += linVelY[i] * dt;
+		posZ[i] += linVelZ[i] * dt;
+
+		linVelX[i] *= damping;
+		linVelY[i] *= damping;
+		linVelZ[i] *= damping;
+
+		Quaternion orientation(rotX[i], rotY[i], rotZ[i], rotW[i]);
+		Vector3 angVel(angVelX[i], angVelY[i], angVelZ[i]);
+
+		orientation = orientation + (Quaternion(angVel * dt * 0.5f, 0.0f) * orientation);
+		orientation.Normalise();
+
+		rotX[i] = orientation.x;
+		rotY[i] = orientation.y;
+		rotZ[i] = orientation.z;
+		rotW[i] = orientation.w;
+
+		angVelX[i] *= damping;
+		angVelY[i] *= damping;
+		angVelZ[i] *= damping;
+
+		UpdateInertiaTensor(i);
+	}
+}
+
+//An object may have moved in several steps this frame, but only needs one new matrix
+void RigidBodyStore::WriteBackTransforms() {
+	movedTransforms.insert(movedTransforms.end(), interpolatedTransforms.begin(), interpolatedTransforms.end());
+	interpolatedTransforms.clear();
+	std::sort(movedTransforms.begin(), movedTransforms.end());
+	movedTransforms.erase(std::unique(movedTransforms.begin(), movedTransforms.end()), movedTransforms.end());
+	for (Transform* t : movedTransforms) {
+		t->UpdateMatrix();
+	}
+	movedTransforms.clear();
+}
+
+/*
+Something that moved during the last step needs interpolating every frame
+until the next step, even on frames that don't step at all. Anything that
+only moved in an earlier step has had its previous pose catch up with it,
+so it just needs one last ordinary rebuild before we forget about it.
+*/
+void RigidBodyStore::InterpolateTransforms(float alpha) {
+	if (!movedTransforms.empty()) {
+		for (Transform* t : interpolatedTransforms) {
+			t->UpdateMatrix();
+		}
+		std::sort(movedTransforms.begin(), movedTransforms.end());
+		movedTransforms.erase(std::unique(movedTransforms.begin(), movedTransforms.end()), movedTransforms.end());
+		interpolatedTransforms.swap(movedTransforms);
+		movedTransforms.clear();
+	}
+	for (Transform* t : interpolatedTransforms) {
+		t->UpdateInterpolatedMatrix(alpha);
+	}
+}
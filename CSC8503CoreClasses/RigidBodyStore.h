@@ -0,0 +1,132 @@
+#pragma once
+#include "Vector3.h"
+#include "Quaternion.h"
+#include "Matrix3.h"
+#include <vector>
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		class GameObject;
+		class PhysicsObject;
+		class Transform;
+
+		/*
+		Structure-of-arrays copy of every physics object's state. Each object
+		gets a slot when it's added to the world, which it keeps until the
+		world changes again, and every array is indexed by slot - so the
+		integration kernels can stream through them four bodies at a time
+		with SSE instead of hopping from GameObject to PhysicsObject to
+		Transform for every body. Awake bodies are kept at the front, then
+		sleeping ones, then static geometry, so a body going to sleep or
+		waking up just swaps slots with the one at the edge.
+
+		While PhysicsSystem::Update is running, the store is what the
+		velocities and world space inverse inertia tensors really are - the
+		contact solver and the integrator work straight on the arrays, and
+		only the objects with constraints on them are copied out and back in
+		around the constraints. Everything else is read back from the objects
+		once at the start of a frame, in BeginFrame, and handed back to them
+		once at the end, in EndFrame. Positions and orientations are written
+		to the Transforms every step without rebuilding the matrices, as the
+		broadphase and narrowphase work from them - WriteBackTransforms does
+		that once per frame, for every body that was moved during it.
+
+		Objects need their PhysicsObject before they're added to the world,
+		or they won't get a slot until something else is added or removed.
+		*/
+		class RigidBodyStore	{
+		public:
+			typedef std::vector<GameObject*>::const_iterator ObjectIterator;
+
+			void Clear();
+
+			//Gives every physics object a slot, if the world has changed since last time
+			void SyncBodies(ObjectIterator first, ObjectIterator last, int worldState);
+			//Picks up forces, velocities and anything moved or woken since the last frame
+			void BeginFrame();
+			//Hands the velocities and inertia tensors back to the objects, and clears their forces
+			void EndFrame();
+
+			//-1 if the object isn't in the store
+			int FindSlot(const PhysicsObject& object) const;
+
+			Vector3 GetLinearVelocity(int slot) const {
+				return Vector3(linVelX[slot], linVelY[slot], linVelZ[slot]);
+			}
+
+			Vector3 GetAngularVelocity(int slot) const {
+				return Vector3(angVelX[slot], angVelY[slot], angVelZ[slot]);
+			}
+
+			Matrix3 GetInertiaTensor(int slot) const;
+
+			//Straight from the object if it hasn't got a slot
+			Vector3 GetLinearVelocity(const PhysicsObject& object) const;
+			Vector3 GetAngularVelocity(const PhysicsObject& object) const;
+
+			void ApplyLinearImpulse(int slot, const Vector3& impulse);
+			void ApplyAngularImpulse(int slot, const Vector3& impulse);
+
+			//For code that still works through the PhysicsObject mid-frame, such as constraints
+			void CopyToObject(PhysicsObject& object) const;
+			void CopyFromObject(const PhysicsObject& object);
+
+			//Moves a body into or out of the awake slots, once it's been woken or put to sleep
+			void SetAwake(const PhysicsObject& object, bool state);
+			//For anything that moves a body between integration steps, such as the contact solver
+			void SetPosition(const PhysicsObject& object, const Vector3& position);
+
+			void IntegrateAccel(float dt, const Vector3& gravity);
+			void IntegrateVelocity(float dt, float damping);
+
+			void WriteBackTransforms();
+			//Like WriteBackTransforms, but the matrices are built alpha of the way
+			//from each transform's previous pose, and rebuilt every call until
+			//they've caught up with where the object actually is
+			void InterpolateTransforms(float alpha);
+			void ResetInterpolation() {
+				interpolatedTransforms.clear();
+			}
+
+			int GetBodyCount() const {
+				return (int)physicsObjects.size();
+			}
+
+			int GetAwakeCount() const {
+				return awakeCount;
+			}
+
+		protected:
+			void Resize(int count);
+			void SwapSlots(int a, int b);
+			void LoadBody(int slot);
+			void UpdateInertiaTensor(int slot);
+
+			void AccelKernel(float dt, const Vector3& gravity);
+			void VelocityKernel(float dt, float damping);
+
+			std::vector<GameObject*>	gameObjects;
+			std::vector<PhysicsObject*>	physicsObjects;
+			std::vector<Transform*>		transforms;
+			std::vector<Transform*>		movedTransforms;
+			std::vector<Transform*>		interpolatedTransforms;
+
+			int worldState		= -1;
+			int awakeCount		= 0;
+			int dynamicCount	= 0;	//awake and sleeping bodies - static geometry comes after
+
+			std::vector<float> posX, posY, posZ;
+			std::vector<float> rotX, rotY, rotZ, rotW;
+			std::vector<float> linVelX, linVelY, linVelZ;
+			std::vector<float> angVelX, angVelY, angVelZ;
+			std::vector<float> forceX, forceY, forceZ;
+			std::vector<float> torqueX, torqueY, torqueZ;
+			std::vector<float> invInertiaX, invInertiaY, invInertiaZ;	//in the body's own space
+			std::vector<float> tensorXX, tensorYY, tensorZZ;			//the world space inverse inertia tensor,
+			std::vector<float> tensorXY, tensorXZ, tensorYZ;			//which is symmetric so only needs 6
+			std::vector<float> inverseMass;
+			std::vector<float> gravityScale;
+		};
+	}
+}
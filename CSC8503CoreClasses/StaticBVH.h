@@ -0,0 +1,361 @@
+#pragma once
+#include "Vector3.h"
+#include "Ray.h"
+#include "CollisionDetection.h"
+#include "RayPacket.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		A bounding volume hierarchy for things that never move, like the
+		maze walls. Unlike the DynamicAABBTree it's built once, top down,
+		with the surface area heuristic choosing every split, and then
+		never touched until the static geometry changes - at which point
+		it's thrown away and built again from scratch.
+
+		Nodes are stored depth first, so a node's left child is always the
+		next node along, and leaves point at a run of the entry list.
+		*/
+		template<class T>
+		class StaticBVH {
+		public:
+			StaticBVH(int maxLeafSize = 4) {
+				leafSize = std::max(1, maxLeafSize);
+			}
+			~StaticBVH() {
+			}
+
+			void Clear() {
+				entries.clear();
+				nodes.clear();
+			}
+
+			//Objects are only queryable once Build has been called
+			void Add(T object, const Vector3& pos, const Vector3& halfSize) {
+				Entry e;
+				e.object	= object;
+				e.minBounds	= pos - halfSize;
+				e.maxBounds	= pos + halfSize;
+				e.centre	= pos;
+				entries.push_back(e);
+			}
+
+			void Build() {
+				nodes.clear();
+				if (entries.empty()) {
+					return;
+				}
+				nodes.reserve(entries.size() * 2);
+				BuildNode(0, (int)entries.size(), 0);
+			}
+
+			/*
+			Calls func with every object whose box overlaps the given one.
+			Returning false from func stops the query early.
+			*/
+			template<class F>
+			void Query(const Vector3& minBounds, const Vector3& maxBounds, F&& func) const {
+				if (nodes.empty()) {
+					return;
+				}
+				int stack[MaxDepth];
+				int count = 0;
+				stack[count++] = 0;
+
+				while (count > 0) {
+					int index = stack[--count];
+					const Node& node = nodes[index];
+					if (!Overlaps(node.minBounds, node.maxBounds, minBounds, maxBounds)) {
+						continue;
+					}
+					if (node.count > 0) {
+						for (int i = node.first; i < node.first + node.count; ++i) {
+							const Entry& e = entries[i];
+							if (Overlaps(e.minBounds, e.maxBounds, minBounds, maxBounds) && !func(e.object)) {
+								return;
+							}
+						}
+						continue;
+					}
+					stack[count++] = node.first;
+					stack[count++] = index + 1;
+				}
+			}
+
+			/*
+			Works just like Octree::RayCast - func is called with every object
+			whose box the ray passes through, nearest node first, and returns
+			the distance to keep looking up to, or a negative value to stop.
+			*/
+			template<class F>
+			void RayCast(const Ray& r, F&& func, float maxDistance = FLT_MAX) const {
+				if (nodes.empty()) {
+					return;
+				}
+				Vector3 rayPos	= r.GetPosition();
+				Vector3 rayDir	= r.GetDirection();
+				Vector3 invDir	= Vector3(1.0f / rayDir.x, 1.0f / rayDir.y, 1.0f / rayDir.z);
+
+				float closest = maxDistance;
+				float tEnter;
+				if (!CollisionDetection::RaySlabTest(rayPos, invDir, nodes[0].minBounds, nodes[0].maxBounds, closest, tEnter)) {
+					return;
+				}
+
+				std::pair<float, int> stack[MaxDepth];
+				int count = 0;
+				stack[count++] = { tEnter, 0 };
+
+				while (count > 0) {
+					auto [nodeDistance, index] = stack[--count];
+					if (nodeDistance > closest) {
+						continue;
+					}
+					const Node& node = nodes[index];
+					if (node.count > 0) {
+						for (int i = node.first; i < node.first + node.count; ++i) {
+							const Entry& e = entries[i];
+							if (!CollisionDetection::RaySlabTest(rayPos, invDir, e.minBounds, e.maxBounds, closest, tEnter)) {
+								continue;
+							}
+							float hitDistance = func(e.object);
+							if (hitDistance < 0.0f) {
+								return;
+							}
+							closest = std::min(closest, hitDistance);
+						}
+						continue;
+					}
+					//Push the further child first, so the nearer one gets popped next
+					float tLeft;
+					float tRight;
+					bool hitLeft	= CollisionDetection::RaySlabTest(rayPos, invDir, nodes[index + 1].minBounds, nodes[index + 1].maxBounds, closest, tLeft);
+					bool hitRight	= CollisionDetection::RaySlabTest(rayPos, invDir, nodes[node.first].minBounds, nodes[node.first].maxBounds, closest, tRight);
+					if (hitLeft && hitRight) {
+						if (tLeft < tRight) {
+							stack[count++] = { tRight, node.first };
+							stack[count++] = { tLeft, index + 1 };
+						}
+						else {
+							stack[count++] = { tLeft, index + 1 };
+							stack[count++] = { tRight, node.first };
+						}
+					}
+					else if (hitLeft) {
+						stack[count++] = { tLeft, index + 1 };
+					}
+					else if (hitRight) {
+						stack[count++] = { tRight, node.first };
+					}
+				}
+			}
+
+			//Works just like DynamicAABBTree::RayCastPacket
+			template<class F>
+			void RayCastPacket(const RayPacket& packet, const float* closest, F&& func) const {
+				if (nodes.empty()) {
+					return;
+				}
+				Vector3 dir(packet.dirX[0], packet.dirY[0], packet.dirZ[0]);
+				float	tEnter[RayPacket::Width];
+
+				int stack[MaxDepth];
+				int count = 0;
+				stack[count++] = 0;
+
+				while (count > 0) {
+					int index = stack[--count];
+					const Node& node = nodes[index];
+					if (packet.SlabTest(node.minBounds, node.maxBounds, closest, tEnter) == 0) {
+						continue;
+					}
+					if (node.count > 0) {
+						for (int i = node.first; i < node.first + node.count; ++i) {
+							const Entry& e = entries[i];
+							int lanes = packet.SlabTest(e.minBounds, e.maxBounds, closest, tEnter);
+							if (lanes != 0) {
+								func(e.object, lanes);
+							}
+						}
+						continue;
+					}
+					const Node& left	= nodes[index + 1];
+					const Node& right	= nodes[node.first];
+					bool leftFirst = Vector3::Dot(left.minBounds + left.maxBounds - right.minBounds - right.maxBounds, dir) < 0.0f;
+					stack[count++] = leftFirst ? node.first : index + 1;
+					stack[count++] = leftFirst ? index + 1 : node.first;
+				}
+			}
+
+			int GetObjectCount() const {
+				return (int)entries.size();
+			}
+
+			int GetNodeCount() const {
+				return (int)nodes.size();
+			}
+
+		protected:
+			//Deep enough for any tree Build makes, as it stops trusting the SAH past MaxSAHDepth
+			static const int MaxDepth		= 128;
+			static const int MaxSAHDepth	= 64;
+			static const int BinCount		= 12;
+
+			struct Entry {
+				T		object;
+				Vector3 minBounds;
+				Vector3 maxBounds;
+				Vector3 centre;
+			};
+
+			//For internal nodes, first is the right child and count is 0
+			struct Node {
+				Vector3 minBounds;
+				Vector3 maxBounds;
+				int		first;
+				int		count;
+			};
+
+			static bool Overlaps(const Vector3& minA, const Vector3& maxA, const Vector3& minB, const Vector3& maxB) {
+				return	minA.x <= maxB.x && maxA.x >= minB.x &&
+						minA.y <= maxB.y && maxA.y >= minB.y &&
+						minA.z <= maxB.z && maxA.z >= minB.z;
+			}
+
+			static float SurfaceArea(const Vector3& minBounds, const Vector3& maxBounds) {
+				Vector3 d = maxBounds - minBounds;
+				return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+			}
+
+			/*
+			Sorts the entries' centres into a few bins along each axis, and
+			tries a split between every pair of neighbouring bins. Each split
+			costs the area of either side times how many entries end up there,
+			and the cheapest one wins - unless keeping the whole lot in one leaf
+			would be cheaper still. If the SAH keeps making lopsided splits, we
+			just cut the entries in half to stop the tree getting too deep.
+			*/
+			int BuildNode(int first, int count, int depth) {
+				int index = (int)nodes.size();
+				nodes.emplace_back();
+
+				Vector3 minBounds		= entries[first].minBounds;
+				Vector3 maxBounds		= entries[first].maxBounds;
+				Vector3 centreMin		= entries[first].centre;
+				Vector3 centreMax		= entries[first].centre;
+				for (int i = first + 1; i < first + count; ++i) {
+					minBounds	= Vector3::Min(minBounds, entries[i].minBounds);
+					maxBounds	= Vector3::Max(maxBounds, entries[i].maxBounds);
+					centreMin	= Vector3::Min(centreMin, entries[i].centre);
+					centreMax	= Vector3::Max(centreMax, entries[i].centre);
+				}
+				nodes[index].minBounds	= minBounds;
+				nodes[index].maxBounds	= maxBounds;
+				nodes[index].first		= first;
+				nodes[index].count		= count;
+
+				if (count <= leafSize) {
+					return index;
+				}
+
+				int		bestAxis	= -1;
+				int		bestSplit	= 0;
+				float	bestCost	= count * SurfaceArea(minBounds, maxBounds);
+
+				for (int axis = 0; axis < 3 && depth < MaxSAHDepth; ++axis) {
+					float extent = centreMax[axis] - centreMin[axis];
+					if (extent <= 0.0f) {
+						continue;
+					}
+					int		binCounts[BinCount] = {};
+					Vector3 binMin[BinCount];
+					Vector3 binMax[BinCount];
+					for (int i = first; i < first + count; ++i) {
+						int b = BinIndex(entries[i].centre[axis], centreMin[axis], extent);
+						if (binCounts[b]++ == 0) {
+							binMin[b] = entries[i].minBounds;
+							binMax[b] = entries[i].maxBounds;
+						}
+						else {
+							binMin[b] = Vector3::Min(binMin[b], entries[i].minBounds);
+							binMax[b] = Vector3::Max(binMax[b], entries[i].maxBounds);
+						}
+					}
+					//Sweep in from the right first, so the left sweep can cost each split
+					float	rightCost[BinCount];
+					int		rightCount	= 0;
+					Vector3 rightMin;
+					Vector3 rightMax;
+					for (int b = BinCount - 1; b > 0; --b) {
+						if (binCounts[b] > 0) {
+							rightMin	= rightCount > 0 ? Vector3::Min(rightMin, binMin[b]) : binMin[b];
+							rightMax	= rightCount > 0 ? Vector3::Max(rightMax, binMax[b]) : binMax[b];
+							rightCount	+= binCounts[b];
+						}
+						rightCost[b] = rightCount > 0 ? rightCount * SurfaceArea(rightMin, rightMax) : 0.0f;
+					}
+					int		leftCount = 0;
+					Vector3 leftMin;
+					Vector3 leftMax;
+					for (int b = 0; b < BinCount - 1; ++b) {
+						if (binCounts[b] > 0) {
+							leftMin		= leftCount > 0 ? Vector3::Min(leftMin, binMin[b]) : binMin[b];
+							leftMax		= leftCount > 0 ? Vector3::Max(leftMax, binMax[b]) : binMax[b];
+							leftCount	+= binCounts[b];
+						}
+						if (leftCount == 0 || leftCount == count) {
+							continue;
+						}
+						float cost = leftCount * SurfaceArea(leftMin, leftMax) + rightCost[b + 1];
+						if (cost < bestCost) {
+							bestCost	= cost;
+							bestAxis	= axis;
+							bestSplit	= b + 1;
+						}
+					}
+				}
+
+				int middle;
+				if (bestAxis >= 0) {
+					float extent = centreMax[bestAxis] - centreMin[bestAxis];
+					auto firstRight = std::partition(entries.begin() + first, entries.begin() + first + count, [&](const Entry& e) {
+						return BinIndex(e.centre[bestAxis], centreMin[bestAxis], extent) < bestSplit;
+					});
+					middle = (int)(firstRight - entries.begin());
+				}
+				else if (depth < MaxSAHDepth) {
+					return index; //No split beats a leaf, or every centre is in the same place
+				}
+				else {
+					int axis = 0;
+					Vector3 extents = centreMax - centreMin;
+					if (extents.y > extents[axis]) {
+						axis = 1;
+					}
+					if (extents.z > extents[axis]) {
+						axis = 2;
+					}
+					middle = first + count / 2;
+					std::nth_element(entries.begin() + first, entries.begin() + middle, entries.begin() + first + count,
+						[axis](const Entry& a, const Entry& b) { return a.centre[axis] < b.centre[axis]; });
+				}
+
+				nodes[index].count = 0;
+				BuildNode(first, middle - first, depth + 1);
+				int right = BuildNode(middle, first + count - middle, depth + 1);
+				nodes[index].first = right;
+				return index;
+			}
+
+			static int BinIndex(float centre, float centreMin, float extent) {
+				int b = (int)(BinCount * (centre - centreMin) / extent);
+				return std::clamp(b, 0, BinCount - 1);
+			}
+
+			std::vector<Entry>	entries;
+			std::vector<Node>	nodes;
+			int					leafSize;
+		};
+	}
+}
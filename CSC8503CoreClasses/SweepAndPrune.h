@@ -0,0 +1,184 @@
+#pragma once
+#include "Vector3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	namespace CSC8503 {
+		/*
+		Sort and sweep broadphase that exploits frame to frame coherence.
+		Each axis keeps a sorted array of box endpoints between updates, and
+		as objects only move a little each step, an insertion sort puts them
+		back in order in close to linear time. Every swap between a min and a
+		max endpoint is exactly the moment two boxes start or stop overlapping
+		on that axis, so the pair list is maintained from the swaps alone.
+		*/
+		template<class T>
+		class SweepAndPrune {
+		public:
+			SweepAndPrune() {
+				Clear();
+			}
+			~SweepAndPrune() {
+			}
+
+			void Clear() {
+				objects.clear();
+				minBounds.clear();
+				maxBounds.clear();
+				pairs.clear();
+				for (int i = 0; i < 3; ++i) {
+					axes[i].clear();
+				}
+				needsRebuild	= false;
+				swapCount		= 0;
+			}
+
+			/*
+			New proxies are picked up by a full sort on the next UpdatePairs
+			call - adding objects is rare compared to moving them.
+			*/
+			int Insert(T object, const Vector3& pos, const Vector3& halfSize) {
+				int proxy = (int)objects.size();
+				objects.push_back(object);
+				minBounds.push_back(pos - halfSize);
+				maxBounds.push_back(pos + halfSize);
+				needsRebuild = true;
+				return proxy;
+			}
+
+			void SetBounds(int proxy, const Vector3& pos, const Vector3& halfSize) {
+				minBounds[proxy] = pos - halfSize;
+				maxBounds[proxy] = pos + halfSize;
+			}
+
+			void UpdatePairs() {
+				swapCount = 0;
+				if (needsRebuild) {
+					Rebuild();
+					return;
+				}
+				for (int axis = 0; axis < 3; ++axis) {
+					InsertionSort(axis);
+				}
+			}
+
+			template<class F>
+			void OperateOnPairs(F&& func) const {
+				for (const auto& p : pairs) {
+					func(objects[p.first], objects[p.second]);
+				}
+			}
+
+			int GetProxyCount() const {
+				return (int)objects.size();
+			}
+
+			int GetPairCount() const {
+				return (int)pairs.size();
+			}
+
+			//How many endpoint swaps the last update took - a measure of how coherent the scene is
+			int GetSwapCount() const {
+				return swapCount;
+			}
+
+		protected:
+			struct Endpoint {
+				float	value;
+				int		proxy;
+				bool	isMax;
+			};
+
+			//Mins sort before maxes at the same value, so touching boxes count as overlapping
+			static bool Before(const Endpoint& a, const Endpoint& b) {
+				return a.value < b.value || (a.value == b.value && !a.isMax && b.isMax);
+			}
+
+			bool Overlaps(int a, int b) const {
+				return	minBounds[a].x <= maxBounds[b].x && maxBounds[a].x >= minBounds[b].x &&
+						minBounds[a].y <= maxBounds[b].y && maxBounds[a].y >= minBounds[b].y &&
+						minBounds[a].z <= maxBounds[b].z && maxBounds[a].z >= minBounds[b].z;
+			}
+
+			std::pair<int, int> MakePair(int a, int b) const {
+				return { std::min(a, b), std::max(a, b) };
+			}
+
+			void RefreshValues(int axis) {
+				for (Endpoint& e : axes[axis]) {
+					e.value = e.isMax ? maxBounds[e.proxy][axis] : minBounds[e.proxy][axis];
+				}
+			}
+
+			/*
+			Full sort of every axis, followed by a single sweep along x to find
+			the initial set of overlapping pairs.
+			*/
+			void Rebuild() {
+				pairs.clear();
+				for (int axis = 0; axis < 3; ++axis) {
+					std::vector<Endpoint>& list = axes[axis];
+					list.clear();
+					list.reserve(objects.size() * 2);
+					for (int i = 0; i < (int)objects.size(); ++i) {
+						list.push_back({ minBounds[i][axis], i, false });
+						list.push_back({ maxBounds[i][axis], i, true });
+					}
+					std::sort(list.begin(), list.end(), Before);
+				}
+
+				std::vector<int> active;
+				for (const Endpoint& e : axes[0]) {
+					if (e.isMax) {
+						active.erase(std::find(active.begin(), active.end(), e.proxy));
+						continue;
+					}
+					for (int other : active) {
+						if (Overlaps(e.proxy, other)) {
+							pairs.insert(MakePair(e.proxy, other));
+						}
+					}
+					active.push_back(e.proxy);
+				}
+				needsRebuild = false;
+			}
+
+			void InsertionSort(int axis) {
+				RefreshValues(axis);
+				std::vector<Endpoint>& list = axes[axis];
+
+				for (int i = 1; i < (int)list.size(); ++i) {
+					Endpoint moving = list[i];
+					int j = i - 1;
+					while (j >= 0 && Before(moving, list[j])) {
+						const Endpoint& passed = list[j];
+						if (!moving.isMax && passed.isMax) {
+							//A min moving below a max - these two now overlap on this axis
+							if (Overlaps(moving.proxy, passed.proxy)) {
+								pairs.insert(MakePair(moving.proxy, passed.proxy));
+							}
+						}
+						else if (moving.isMax && !passed.isMax) {
+							//A max moving below a min - these two have separated
+							pairs.erase(MakePair(moving.proxy, passed.proxy));
+						}
+						list[j + 1] = passed;
+						--j;
+						swapCount++;
+					}
+					list[j + 1] = moving;
+				}
+			}
+
+			std::vector<T>			objects;
+			std::vector<Vector3>	minBounds;
+			std::vector<Vector3>	maxBounds;
+			std::vector<Endpoint>	axes[3];
+
+			std::set<std::pair<int, int>> pairs;
+
+			bool	needsRebuild;
+			int		swapCount;
+		};
+	}
+}
@@ -0,0 +1,79 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+ThreadPool::ThreadPool(int threadCount) {
+	if (threadCount <= 0) {
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	for (int i = 1; i < threadCount; ++i) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	jobReady.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void ThreadPool::ParallelFor(int count, int minRange, const RangeJob& job) {
+	if (count <= 0) {
+		return;
+	}
+	minRange = std::max(1, minRange);
+	int ranges = std::min(GetThreadCount(), (count + minRange - 1) / minRange);
+	if (ranges <= 1) {
+		job(0, count, 0);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob		= &job;
+		jobCount		= count;
+		jobRanges		= ranges;
+		pendingRanges	= ranges - 1;
+		generation++;
+	}
+	jobReady.notify_all();
+
+	RunRange(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	jobDone.wait(lock, [&] { return pendingRanges == 0; });
+	currentJob = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int index) {
+	int lastGeneration = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobReady.wait(lock, [&] { return shuttingDown || generation != lastGeneration; });
+		if (shuttingDown) {
+			return;
+		}
+		lastGeneration = generation;
+		if (index >= jobRanges) {
+			continue; //Not enough work to need this thread
+		}
+		lock.unlock();
+		RunRange(index);
+		lock.lock();
+		if (--pendingRanges == 0) {
+			jobDone.notify_one();
+		}
+	}
+}
+
+void ThreadPool::RunRange(int index) {
+	int first	= (int)((long long)jobCount * index / jobRanges);
+	int last	= (int)((long long)jobCount * (index + 1) / jobRanges);
+	(*currentJob)(first, last, index);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A fixed set of worker threads that sleep until handed a ParallelFor.
+		The work is split into one contiguous range per thread, and range i
+		always goes to thread i, so callers can give each range its own
+		output buffer and merge them back in a fixed order afterwards.
+		*/
+		class ThreadPool	{
+		public:
+			//(first, last, range index) - the range index is in [0, GetThreadCount())
+			typedef std::function<void(int, int, int)> RangeJob;
+
+			//0 threads uses one per hardware thread. The calling thread
+			//counts as one of them, so it always takes a share of the work
+			ThreadPool(int threadCount = 0);
+			~ThreadPool();
+
+			int GetThreadCount() const {
+				return (int)workers.size() + 1;
+			}
+
+			//Runs job over [0, count), never splitting it into ranges
+			//smaller than minRange. Returns once every range is done
+			void ParallelFor(int count, int minRange, const RangeJob& job);
+
+		protected:
+			void WorkerLoop(int index);
+			void RunRange(int index);
+
+			std::vector<std::thread> workers;
+
+			std::mutex				mutex;
+			std::condition_variable	jobReady;
+			std::condition_variable	jobDone;
+
+			const RangeJob* currentJob		= nullptr;
+			int				jobCount		= 0;
+			int				jobRanges		= 0;
+			int				pendingRanges	= 0;
+			int				generation		= 0;
+			bool			shuttingDown	= false;
+		};
+	}
+}
@@ -0,0 +1,50 @@
+#include "TickScheduler.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+TickScheduler::TickScheduler(float tickRate, int maxTicksPerFrame) {
+	SetTickRate(tickRate);
+	SetMaxTicksPerFrame(maxTicksPerFrame);
+	accumulator = 0.0f;
+}
+
+void TickScheduler::SetTickRate(float hz) {
+	tickRate	= std::max(1.0f, hz);
+	tickTime	= 1.0f / tickRate;
+	accumulator	= 0.0f;
+}
+
+void TickScheduler::Reset() {
+	accumulator	= 0.0f;
+	stats		= TickStats();
+}
+
+int TickScheduler::Advance(float dt) {
+	accumulator += std::max(0.0f, dt);
+
+	int ticks = (int)(accumulator / tickTime);
+	if (ticks > maxTicksPerFrame) {
+		ticks = maxTicksPerFrame;
+		float kept = tickTime * ticks;
+		stats.droppedTime += accumulator - kept;
+		stats.clampedFrames++;
+		accumulator = kept;
+	}
+	accumulator -= tickTime * ticks;
+	//Float error can leave us a hair under 0 or over a tick
+	accumulator = std::clamp(accumulator, 0.0f, tickTime);
+
+	stats.frameTicks	= ticks;
+	stats.totalTicks	+= ticks;
+	return ticks;
+}
+
+void TickScheduler::RecordTickCost(float seconds) {
+	if (stats.frameTicks == 0) {
+		return;
+	}
+	stats.lastTickCost		= seconds / stats.frameTicks;
+	stats.averageTickCost	= stats.averageTickCost == 0.0f ? stats.lastTickCost
+							: stats.averageTickCost * 0.9f + stats.lastTickCost * 0.1f;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+
+namespace NCL {
+	namespace CSC8503 {
+		//What the scheduler has been doing, for the debug overlay and profiling
+		struct TickStats {
+			int		frameTicks		= 0;	//ticks run for the last frame
+			int		totalTicks		= 0;
+			int		clampedFrames	= 0;	//frames that wanted more than the tick limit
+			float	droppedTime		= 0.0f;	//seconds of simulation skipped to catch up
+			float	lastTickCost	= 0.0f;	//seconds each tick took during the last frame
+			float	averageTickCost	= 0.0f;	//smoothed over the last few frames
+		};
+
+		/*
+		Turns variable frame times into a whole number of fixed-length ticks.
+		Frame time builds up in an accumulator and is paid out a tick at a
+		time, and whatever is left over becomes the interpolation alpha - how
+		far the renderer should be between the last two ticks.
+
+		If ticks start costing more than the time they simulate, every frame
+		would need more of them than the last (the 'spiral of death'). So no
+		frame gets more than maxTicksPerFrame, and any time beyond that is
+		thrown away - the game slows down rather than grinding to a halt.
+		*/
+		class TickScheduler	{
+		public:
+			TickScheduler(float tickRate = 120.0f, int maxTicksPerFrame = 8);
+
+			void SetTickRate(float hz);
+
+			float GetTickRate() const {
+				return tickRate;
+			}
+
+			float GetTickTime() const {
+				return tickTime;
+			}
+
+			void SetMaxTicksPerFrame(int ticks) {
+				maxTicksPerFrame = std::max(1, ticks);
+			}
+
+			int GetMaxTicksPerFrame() const {
+				return maxTicksPerFrame;
+			}
+
+			//Adds on a frame's worth of time, and returns how many ticks to run for it
+			int Advance(float dt);
+
+			//How long the ticks returned by the last Advance took to run, in seconds
+			void RecordTickCost(float seconds);
+
+			//0 is the tick before the last one, 1 is the last one
+			float GetAlpha() const {
+				return accumulator / tickTime;
+			}
+
+			void Reset();
+
+			const TickStats& GetStats() const {
+				return stats;
+			}
+
+		protected:
+			float	tickRate;
+			float	tickTime;
+			float	accumulator;
+			int		maxTicksPerFrame;
+
+			TickStats stats;
+		};
+	}
+}
@@ -18,6 +18,15 @@ void Transform::UpdateMatrix() {
 		Matrix4::Scale(scale);
 }
 
+void Transform::UpdateInterpolatedMatrix(float alpha) {
+	Vector3		lerpPosition	= previousPosition + (position - previousPosition) * alpha;
+	Quaternion	lerpOrientation	= Quaternion::Lerp(previousOrientation, orientation, alpha).Normalised();
+	matrix =
+		Matrix4::Translation(lerpPosition) *
+		Matrix4(lerpOrientation) *
+		Matrix4::Scale(scale);
+}
+
 Transform& Transform::SetPosition(const Vector3& worldPos) {
 	position = worldPos;
 	UpdateMatrix();
@@ -36,6 +45,14 @@ Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
 	return *this;
 }
 
+//Forgetting the previous pose means there's nothing to interpolate from
+Transform& Transform::Teleport(const Vector3& worldPos, const Quaternion& newOr) {
+	SetPoseDeferred(worldPos, newOr);
+	StorePreviousPose();
+	UpdateMatrix();
+	return *this;
+}
+
 void NCL::CSC8503::Transform::AddChild(Transform* child) {
 	children.push_back(child);
 	child->parent = this;
@@ -16,6 +16,22 @@ namespace NCL {
 			Transform& SetScale(const Vector3& worldScale);
 			Transform& SetOrientation(const Quaternion& newOr);
 
+			//Setting the position or orientation is treated as the object
+			//having moved there, so it's drawn sliding across from its last
+			//physics step. Teleport is for when it should just appear there
+			Transform& Teleport(const Vector3& worldPos, const Quaternion& newOr);
+			Transform& Teleport(const Vector3& worldPos) {
+				return Teleport(worldPos, orientation);
+			}
+
+			//Moves the transform without rebuilding its matrix, for when
+			//something is going to move it many times before it's drawn.
+			//Call UpdateMatrix once it has stopped moving!
+			void SetPoseDeferred(const Vector3& worldPos, const Quaternion& newOr) {
+				position	= worldPos;
+				orientation	= newOr;
+			}
+
 			Vector3 GetPosition() const {
 				return position;
 			}
@@ -32,6 +48,16 @@ namespace NCL {
 				return matrix;
 			}
 			void UpdateMatrix();
+
+			//Physics runs at a fixed rate, so to draw smoothly in between its
+			//steps we keep where we were before the last one, and build the
+			//matrix somewhere between there and where we are now
+			void StorePreviousPose() {
+				previousPosition	= position;
+				previousOrientation	= orientation;
+			}
+			void UpdateInterpolatedMatrix(float alpha);
+
 			void AddChild(Transform* child);
 			std::vector<Transform*>::const_iterator GetChildIteratorStart();
 			std::vector<Transform*>::const_iterator GetChildIteratorEnd();
@@ -40,6 +66,9 @@ namespace NCL {
 			Quaternion	orientation;
 			Vector3		position;
 
+			Vector3		previousPosition;
+			Quaternion	previousOrientation;
+
 			Vector3		scale;
 			
 			Transform* parent = nullptr;
@@ -0,0 +1,146 @@
+#include "WorldScheduler.h"
+#include "PhysicsSystem.h"
+#include "Debug.h"
+#include "GameTimer.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorldScheduler::WorldScheduler(int threadCount) {
+	if (threadCount <= 0) {
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	queues = std::vector<WorldQueue>(threadCount);
+	for (int i = 1; i < threadCount; ++i) {
+		workers.emplace_back(&WorldScheduler::WorkerLoop, this, i);
+	}
+}
+
+WorldScheduler::~WorldScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	updateReady.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+int WorldScheduler::AddWorld(const WorldUpdate& update) {
+	int index = (int)worlds.size();
+	worlds.push_back({ update, index % GetThreadCount() });
+	return index;
+}
+
+int WorldScheduler::AddWorld(PhysicsSystem& physics) {
+	return AddWorld([&physics](float dt) { physics.Update(dt); });
+}
+
+void WorldScheduler::Clear() {
+	worlds.clear();
+}
+
+void WorldScheduler::Update(float dt) {
+	GameTimer t;
+	t.GetTimeDeltaSeconds();
+
+	stats = WorldSchedulerStats();
+	//Nothing else touches the queues between updates, so they can be filled without locking
+	for (int i = 0; i < (int)worlds.size(); ++i) {
+		queues[worlds[i].homeThread].worlds.push_back(i);
+	}
+	if (!workers.empty() && worlds.size() > 1) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			updateDt		= dt;
+			pendingThreads	= (int)workers.size();
+			generation++;
+		}
+		updateReady.notify_all();
+
+		RunWorlds(0);
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			updateDone.wait(lock, [&] { return pendingThreads == 0; });
+		}
+		for (int i = 1; i < GetThreadCount(); ++i) {
+			Debug::AddEntries(queues[i].debugStrings, queues[i].debugLines);
+			queues[i].debugStrings.clear();
+			queues[i].debugLines.clear();
+		}
+	}
+	else {
+		updateDt = dt;
+		RunWorlds(0);
+	}
+
+	t.Tick();
+	stats.updateTime = t.GetTimeDeltaSeconds();
+}
+
+void WorldScheduler::WorkerLoop(int index) {
+	int lastGeneration = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		updateReady.wait(lock, [&] { return shuttingDown || generation != lastGeneration; });
+		if (shuttingDown) {
+			return;
+		}
+		lastGeneration = generation;
+		lock.unlock();
+		RunWorlds(index);
+		Debug::TakeThreadEntries(queues[index].debugStrings, queues[index].debugLines);
+		lock.lock();
+		if (--pendingThreads == 0) {
+			updateDone.notify_one();
+		}
+	}
+}
+
+/*
+Works through this thread's own queue first, then goes round the other
+threads' queues in turn, taking a world from whichever still has one.
+There's nothing to wait on once every queue is empty, as no more worlds
+get queued until the next update.
+*/
+void WorldScheduler::RunWorlds(int index) {
+	int updated = 0;
+	int stolen	= 0;
+
+	int		world;
+	bool	wasStolen;
+	while (PopWorld(index, world, wasStolen)) {
+		worlds[world].update(updateDt);
+		updated++;
+		stolen += wasStolen ? 1 : 0;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.worldsUpdated += updated;
+	stats.worldsStolen	+= stolen;
+}
+
+bool WorldScheduler::PopWorld(int index, int& world, bool& stolen) {
+	int threadCount = GetThreadCount();
+	for (int i = 0; i < threadCount; ++i) {
+		WorldQueue& queue = queues[(index + i) % threadCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.worlds.empty()) {
+			continue;
+		}
+		if (i == 0) {
+			world = queue.worlds.front();
+			queue.worlds.pop_front();
+		}
+		else {
+			world = queue.worlds.back();
+			queue.worlds.pop_back();
+		}
+		stolen = i != 0;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+#include "Debug.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class PhysicsSystem;
+
+		struct WorldSchedulerStats {
+			int		worldsUpdated	= 0;
+			int		worldsStolen	= 0;	//updated away from their home thread
+			float	updateTime		= 0.0f;	//seconds, for the whole of the last Update
+		};
+
+		/*
+		Updates lots of independent worlds at once - ie one per match on a
+		server - spread over a fixed set of threads. Every world has a home
+		thread it's always given to first, so it tends to stay in the same
+		cache from one update to the next, but a thread that runs out of its
+		own worlds takes them from the back of the others' queues rather
+		than sitting idle while one match is busier than the rest.
+
+		Worlds mustn't share anything they write to - give each its own
+		GameWorld and a PhysicsSystem with 1 worker thread, and turn off its
+		keyboard controls. Anything they draw through Debug ends up in the
+		calling thread's lists, wherever they were updated.
+		*/
+		class WorldScheduler	{
+		public:
+			typedef std::function<void(float)> WorldUpdate;
+
+			//0 threads uses one per hardware thread. The calling thread
+			//counts as one of them, so it always takes a share of the worlds
+			WorldScheduler(int threadCount = 0);
+			~WorldScheduler();
+
+			int GetThreadCount() const {
+				return (int)workers.size() + 1;
+			}
+
+			//Returns the world's index. Homes are handed out in turn
+			int AddWorld(const WorldUpdate& update);
+			int AddWorld(PhysicsSystem& physics);
+
+			int GetWorldCount() const {
+				return (int)worlds.size();
+			}
+
+			void Clear();
+
+			//Calls every world's update once with dt, returning when they're all done
+			void Update(float dt);
+
+			const WorldSchedulerStats& GetStats() const {
+				return stats;
+			}
+
+		protected:
+			struct World {
+				WorldUpdate update;
+				int			homeThread;
+			};
+
+			//Each thread's own worlds for this update. The owner takes from
+			//the front, and anyone stealing takes from the back
+			struct WorldQueue {
+				std::mutex		mutex;
+				std::deque<int>	worlds;
+
+				//Whatever the thread's worlds drew, until it's passed on to the calling thread
+				std::vector<Debug::DebugStringEntry>	debugStrings;
+				std::vector<Debug::DebugLineEntry>		debugLines;
+			};
+
+			void WorkerLoop(int index);
+			void RunWorlds(int index);
+			bool PopWorld(int index, int& world, bool& stolen);
+
+			std::vector<World>			worlds;
+			std::vector<WorldQueue>		queues;
+			std::vector<std::thread>	workers;
+
+			std::mutex				mutex;
+			std::condition_variable	updateReady;
+			std::condition_variable	updateDone;
+
+			float	updateDt		= 0.0f;
+			int		pendingThreads	= 0;
+			int		generation		= 0;
+			bool	shuttingDown	= false;
+
+			WorldSchedulerStats stats;
+		};
+	}
+}
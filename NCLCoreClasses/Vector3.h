@@ -82,6 +82,14 @@ namespace NCL::Maths {
 
 		static Vector3 MoveTowards(const Vector3& posA, const Vector3& posB, float maxDistanceDelta);
 
+		static Vector3	Min(const Vector3& a, const Vector3& b) {
+			return Vector3(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+		}
+
+		static Vector3	Max(const Vector3& a, const Vector3& b) {
+			return Vector3(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+		}
+
 		static constexpr float	Dot(const Vector3& a, const Vector3& b) {
 			return (a.x*b.x) + (a.y*b.y) + (a.z*b.z);
 		}
@@ -0,0 +1,92 @@
+#include "IntegrationBenchmark.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "SphereVolume.h"
+#include <random>
+#include <iomanip>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	std::vector<GameObject*> BuildBodies(GameWorld& world, const IntegrationSettings& settings) {
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> spin(-2.0f, 2.0f);
+		std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+		int side = (int)std::ceil(std::cbrt((float)settings.bodies));
+		std::vector<GameObject*> bodies;
+		for (int i = 0; i < settings.bodies; ++i) {
+			Vector3 cell((float)(i % side), (float)((i / side) % side), (float)(i / (side * side)));
+
+			GameObject* sphere = new GameObject("Body");
+			sphere->SetBoundingVolume((CollisionVolume*)new SphereVolume(0.5f));
+			sphere->GetTransform()
+				.SetScale(Vector3(0.5f, 0.5f, 0.5f))
+				.SetPosition(cell * settings.spacing)
+				.SetOrientation(Quaternion::EulerAnglesToQuaternion(angle(random), angle(random), angle(random)));
+
+			PhysicsObject* phys = new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume());
+			phys->SetInverseMass(1.0f);
+			phys->InitSphereInertia();
+			phys->SetAngularVelocity(Vector3(spin(random), spin(random), spin(random)));
+			sphere->SetPhysicsObject(phys);
+
+			world.AddGameObject(sphere);
+			bodies.push_back(sphere);
+		}
+		return bodies;
+	}
+
+	void RunIntegration(const IntegrationSettings& settings, BroadPhaseType broadPhase, int ticksPerFrame) {
+		GameWorld		world;
+		PhysicsSystem	physics(world, broadPhase);
+		physics.UseGravity(true);
+		physics.UseSleeping(false);
+		physics.UseKeyboardControls(false);
+		physics.SetTickRate(settings.tickRate);
+		physics.SetMaxTicksPerFrame(ticksPerFrame);
+
+		std::vector<GameObject*> bodies = BuildBodies(world, settings);
+
+		//A hair over the frame length, so rounding never drops a tick
+		float frameTime = (ticksPerFrame + 0.5f) / settings.tickRate;
+
+		double	syncTime		= 0.0;
+		double	accelTime		= 0.0;
+		double	velocityTime	= 0.0;
+		int		ticks			= 0;
+		for (int f = 0; f < settings.frames; ++f) {
+			for (GameObject* o : bodies) {
+				o->GetPhysicsObject()->AddForceAtPosition(Vector3(0, 5.0f, 0), o->GetTransform().GetPosition() + Vector3(0.25f, 0, 0));
+			}
+			physics.Update(frameTime);
+
+			const PhysicsFrameProfile& frame = physics.GetProfiler().GetFrame(0);
+			syncTime		+= frame.phaseTimes[(int)PhysicsPhase::SyncBodies];
+			accelTime		+= frame.phaseTimes[(int)PhysicsPhase::IntegrateAccel];
+			velocityTime	+= frame.phaseTimes[(int)PhysicsPhase::IntegrateVelocity];
+			ticks			+= frame.counters[(int)PhysicsCounter::Ticks];
+		}
+
+		//The sync is only paid once a frame, however many ticks it has
+		double total = syncTime + accelTime + velocityTime;
+		std::cout << ticksPerFrame << " ticks per frame: " << std::fixed << std::setprecision(3)
+			<< total / ticks << "ms per tick (sync " << syncTime / ticks << "ms, accel " << accelTime / ticks
+			<< "ms, velocity " << velocityTime / ticks << "ms), " << std::setprecision(0)
+			<< (double)settings.bodies * ticks / total << " bodies/ms, "
+			<< (double)settings.bodies * ticks / (accelTime + velocityTime) << " without the sync\n";
+
+		physics.Clear();
+		world.ClearAndErase();
+	}
+}
+
+void NCL::CSC8503::IntegrationBenchmark(const IntegrationSettings& settings, BroadPhaseType broadPhase) {
+	std::cout << "Integration benchmark: " << settings.bodies << " bodies, " << settings.frames << " frames at "
+		<< settings.tickRate << "Hz, " << PhysicsSystem::GetBroadPhaseName(broadPhase) << "\n";
+	for (int ticksPerFrame = 1; ticksPerFrame <= 4; ticksPerFrame *= 2) {
+		RunIntegration(settings, broadPhase, ticksPerFrame);
+	}
+}
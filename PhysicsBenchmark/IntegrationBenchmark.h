@@ -0,0 +1,22 @@
+#pragma once
+#include "PhysicsSystem.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		struct IntegrationSettings {
+			int		bodies		= 10000;
+			int		frames		= 300;
+			float	tickRate	= 60.0f;
+			float	spacing		= 3.0f;	//far enough apart that nothing ever touches
+		};
+
+		/*
+		Lets a grid of spinning spheres fall through empty space, being pushed
+		off centre every frame, and times just the integration phases - at
+		one, two and four ticks a frame, as the bodies are only read back from
+		and handed back to their objects once a frame. Reports how many bodies
+		are integrated per millisecond, with and without that sync.
+		*/
+		void IntegrationBenchmark(const IntegrationSettings& settings, BroadPhaseType broadPhase);
+	}
+}
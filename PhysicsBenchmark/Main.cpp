@@ -0,0 +1,120 @@
+/*
+Headless benchmarks for the physics code, so changes to it can be timed
+without a window, a renderer or any input - and on machines that can't
+open either.
+
+	PhysicsBenchmark								runs every stress scene
+	PhysicsBenchmark <scene> [size] [steps] [broadphase]
+
+scene is one of spheres, bricks, bridges, maze, all, ropes, pairs, throws,
+worlds or integrate.
+For ropes, size is the number of links, and the coloured constraint solver
+is raced against the serial constraint list instead. For pairs, size is the
+number of pairs and steps the number of times they're all tested, timing
+each narrowphase test on its own. For throws, size is the number of spheres
+fired at a thin wall, with and without continuous collision. For worlds,
+size is the number of matches updated side by side at 30Hz, across more
+and more threads. For integrate, size is the number of free falling bodies,
+and steps the number of frames. broadphase is the index of a BroadPhaseType.
+*/
+#include "StressTest.h"
+#include "RopeBenchmark.h"
+#include "NarrowphaseBenchmark.h"
+#include "ThrowBenchmark.h"
+#include "MultiWorldBenchmark.h"
+#include "IntegrationBenchmark.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Sizes that take a few seconds each on a desktop
+	const int DefaultSizes[(int)StressScene::Count] = { 1000, 20, 20, 200 };
+	const int DefaultSteps = 600;
+	const char* SceneArguments[(int)StressScene::Count] = { "spheres", "bricks", "bridges", "maze" };
+
+	void RunScene(StressScene scene, int size, int steps, BroadPhaseType broadPhase) {
+		StressTest test(broadPhase);
+		test.BuildScene(scene, size > 0 ? size : DefaultSizes[(int)scene]);
+		test.Run(steps);
+		std::cout << "\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string sceneName	= argc > 1 ? argv[1] : "all";
+	int			size		= argc > 2 ? atoi(argv[2]) : 0;
+	int			steps		= argc > 3 ? std::max(1, atoi(argv[3])) : DefaultSteps;
+	int			broadPhase	= argc > 4 ? atoi(argv[4]) : (int)BroadPhaseType::AABBTree;
+	broadPhase = std::clamp(broadPhase, 0, (int)BroadPhaseType::Octree);
+
+	if (sceneName == "ropes") {
+		RopeSettings settings;
+		if (size > 0) {
+			settings.links = size;
+		}
+		if (argc > 3) {
+			settings.steps = steps;
+		}
+		RopeBenchmark(settings);
+		return 0;
+	}
+	if (sceneName == "pairs") {
+		NarrowphaseSettings settings;
+		if (size > 0) {
+			settings.pairs = size;
+		}
+		if (argc > 3) {
+			settings.repeats = steps;
+		}
+		NarrowphaseBenchmark(settings);
+		return 0;
+	}
+	if (sceneName == "throws") {
+		ThrowSettings settings;
+		if (size > 0) {
+			settings.throwables = size;
+		}
+		if (argc > 3) {
+			settings.steps = steps;
+		}
+		ThrowBenchmark(settings, (BroadPhaseType)broadPhase);
+		return 0;
+	}
+	if (sceneName == "worlds") {
+		MultiWorldSettings settings;
+		if (size > 0) {
+			settings.worlds = size;
+		}
+		if (argc > 3) {
+			settings.steps = steps;
+		}
+		MultiWorldBenchmark(settings, (BroadPhaseType)broadPhase);
+		return 0;
+	}
+	if (sceneName == "integrate") {
+		IntegrationSettings settings;
+		if (size > 0) {
+			settings.bodies = size;
+		}
+		if (argc > 3) {
+			settings.frames = steps;
+		}
+		IntegrationBenchmark(settings, (BroadPhaseType)broadPhase);
+		return 0;
+	}
+
+	for (int s = 0; s < (int)StressScene::Count; ++s) {
+		if (sceneName == "all" || sceneName == SceneArguments[s]) {
+			RunScene((StressScene)s, size, steps, (BroadPhaseType)broadPhase);
+			if (sceneName != "all") {
+				return 0;
+			}
+		}
+	}
+	if (sceneName != "all") {
+		std::cout << "Unknown scene " << sceneName << "\n";
+		return 1;
+	}
+	return 0;
+}
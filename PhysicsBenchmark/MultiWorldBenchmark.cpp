@@ -0,0 +1,166 @@
+#include "MultiWorldBenchmark.h"
+#include "WorldScheduler.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "AABBVolume.h"
+#include "SphereVolume.h"
+#include <random>
+#include <memory>
+#include <iomanip>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const float ArenaSize	= 30.0f;
+	const float PlayerForce	= 40.0f;
+
+	/*
+	A walled arena with crates dropped about it and players shoving their
+	way around - about what one match's physics does on the server.
+	*/
+	class Match	{
+	public:
+		Match(const MultiWorldSettings& settings, BroadPhaseType broadPhase, int seed) : physics(world, broadPhase, 1), random(seed) {
+			physics.UseGravity(true);
+			physics.UseKeyboardControls(false);
+			physics.SetTickRate(settings.tickRate);
+
+			AddCube(Vector3(0, -2, 0), Vector3(ArenaSize, 2, ArenaSize), 0.0f);
+			for (int side = -1; side <= 1; side += 2) {
+				AddCube(Vector3(side * ArenaSize, 2, 0), Vector3(1, 2, ArenaSize), 0.0f);
+				AddCube(Vector3(0, 2, side * ArenaSize), Vector3(ArenaSize, 2, 1), 0.0f);
+			}
+
+			std::uniform_real_distribution<float> floor(-ArenaSize * 0.8f, ArenaSize * 0.8f);
+			std::uniform_real_distribution<float> height(1.0f, 10.0f);
+			for (int i = 0; i < settings.crates; ++i) {
+				AddCube(Vector3(floor(random), height(random), floor(random)), Vector3(0.5f, 0.5f, 0.5f), 1.0f);
+			}
+			for (int i = 0; i < settings.players; ++i) {
+				players.push_back(AddSphere(Vector3(floor(random), 1.0f, floor(random)), 1.0f, 0.5f));
+			}
+		}
+
+		~Match() {
+			physics.Clear();
+			world.ClearAndErase();
+		}
+
+		void Update(float dt) {
+			std::uniform_real_distribution<float> push(-PlayerForce, PlayerForce);
+			for (GameObject* p : players) {
+				p->GetPhysicsObject()->AddForce(Vector3(push(random), 0, push(random)));
+			}
+			physics.Update(dt);
+		}
+
+		//Where everything ended up, added together
+		double Checksum() {
+			double total = 0.0;
+			world.OperateOnContents([&](GameObject* o) {
+				const Vector3& p = o->GetTransform().GetPosition();
+				total += p.x + p.y * 3.0 + p.z * 7.0;
+			});
+			return total;
+		}
+
+	protected:
+		GameObject* AddCube(const Vector3& position, const Vector3& halfSize, float inverseMass) {
+			GameObject* cube = new GameObject("Crate");
+			cube->SetBoundingVolume((CollisionVolume*)new AABBVolume(halfSize));
+			cube->GetTransform()
+				.SetPosition(position)
+				.SetScale(halfSize * 2);
+			cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+			cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+			cube->GetPhysicsObject()->InitCubeInertia();
+			cube->SetStaticGeometry(inverseMass == 0.0f);
+			world.AddGameObject(cube);
+			return cube;
+		}
+
+		GameObject* AddSphere(const Vector3& position, float radius, float inverseMass) {
+			GameObject* sphere = new GameObject("Player");
+			sphere->SetBoundingVolume((CollisionVolume*)new SphereVolume(radius));
+			sphere->GetTransform()
+				.SetScale(Vector3(radius, radius, radius))
+				.SetPosition(position);
+			sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+			sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+			sphere->GetPhysicsObject()->InitSphereInertia();
+			world.AddGameObject(sphere);
+			return sphere;
+		}
+
+		GameWorld		world;
+		PhysicsSystem	physics;
+		std::mt19937	random;
+		std::vector<GameObject*> players;
+	};
+
+	//Returns every match's checksum, in match order
+	std::vector<double> RunMatches(const MultiWorldSettings& settings, BroadPhaseType broadPhase, int threads) {
+		WorldScheduler scheduler(threads);
+		std::vector<std::unique_ptr<Match>> matches;
+		for (int i = 0; i < settings.worlds; ++i) {
+			matches.push_back(std::make_unique<Match>(settings, broadPhase, 1000 + i));
+			Match* m = matches.back().get();
+			scheduler.AddWorld([m](float dt) { m->Update(dt); });
+		}
+
+		const float tickTime = 1.0f / settings.tickRate;
+		double	updateTotal	= 0.0;
+		double	slowest		= 0.0;
+		int		stolen		= 0;
+		for (int s = 0; s < settings.steps; ++s) {
+			scheduler.Update(tickTime);
+			const WorldSchedulerStats& stats = scheduler.GetStats();
+			updateTotal += stats.updateTime;
+			slowest		= std::max(slowest, (double)stats.updateTime);
+			stolen		+= stats.worldsStolen;
+		}
+
+		//Each thread has a tick's worth of time per tick to spend on matches
+		double average			= updateTotal / settings.steps;
+		double matchesPerThread	= settings.worlds * tickTime / average / scheduler.GetThreadCount();
+		std::cout << std::setw(3) << scheduler.GetThreadCount() << " threads: "
+			<< std::fixed << std::setprecision(3) << average * 1000.0 << "ms per tick (slowest "
+			<< slowest * 1000.0 << "ms), " << (float)stolen / settings.steps << " matches stolen per tick, "
+			<< std::setprecision(1) << matchesPerThread << " matches per thread at " << settings.tickRate << "Hz";
+
+		std::vector<double> checksums;
+		for (auto& m : matches) {
+			checksums.push_back(m->Checksum());
+		}
+		return checksums;
+	}
+}
+
+void NCL::CSC8503::MultiWorldBenchmark(const MultiWorldSettings& settings, BroadPhaseType broadPhase) {
+	int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	std::cout << "Multi world benchmark: " << settings.worlds << " matches of " << settings.players << " players and "
+		<< settings.crates << " crates, " << settings.steps << " ticks at " << settings.tickRate << "Hz, "
+		<< PhysicsSystem::GetBroadPhaseName(broadPhase) << ", " << hardwareThreads << " hardware threads\n";
+
+	std::vector<double> reference = RunMatches(settings, broadPhase, 1);
+	std::cout << "\n";
+
+	//Always tries a few threads, even on one core, so the stealing gets some use
+	int maxThreads = std::max(4, hardwareThreads);
+	std::vector<int> threadCounts;
+	for (int threads = 2; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for (int threads : threadCounts) {
+		std::vector<double> checksums = RunMatches(settings, broadPhase, threads);
+		int differences = 0;
+		for (int i = 0; i < settings.worlds; ++i) {
+			differences += checksums[i] != reference[i] ? 1 : 0;
+		}
+		std::cout << ", " << differences << " matches differ from 1 thread\n";
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "PhysicsSystem.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		struct MultiWorldSettings {
+			int		worlds		= 64;
+			int		steps		= 300;
+			float	tickRate	= 30.0f;
+			int		players		= 8;	//spheres pushed about at random, so the matches never go to sleep
+			int		crates		= 60;
+		};
+
+		/*
+		Builds worlds small arenas, each its own GameWorld and PhysicsSystem,
+		and updates them all through a WorldScheduler at a fixed tick rate,
+		once for each thread count up to the hardware's. Reports how many
+		matches each thread could keep up with at that rate, and checks every
+		match ended up exactly where it did on one thread - if any state was
+		shared between them, where they were updated would change that.
+		*/
+		void MultiWorldBenchmark(const MultiWorldSettings& settings, BroadPhaseType broadPhase);
+	}
+}
@@ -0,0 +1,148 @@
+#include "NarrowphaseBenchmark.h"
+#include "CollisionDetection.h"
+#include "ContactBatch.h"
+#include "GJK.h"
+#include "NarrowphaseReference.h"
+#include <random>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const int VolumeCount = 5;
+	const char* VolumeNames[VolumeCount] = { "Sphere", "AABB", "OBB", "Capsule", "Hull" };
+
+	struct PairPose {
+		Transform a;
+		Transform b;
+	};
+
+	std::vector<PairPose> BuildPoses(const NarrowphaseSettings& settings) {
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> offset(-settings.spread, settings.spread);
+		std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+		std::vector<PairPose> poses(settings.pairs);
+		for (PairPose& p : poses) {
+			p.a.SetPosition(Vector3(offset(random), offset(random), offset(random)) * 0.1f);
+			p.a.SetOrientation(Quaternion::EulerAnglesToQuaternion(angle(random), angle(random), angle(random)));
+			p.b.SetPosition(Vector3(offset(random), offset(random), offset(random)));
+			p.b.SetOrientation(Quaternion::EulerAnglesToQuaternion(angle(random), angle(random), angle(random)));
+		}
+		return poses;
+	}
+
+	//A lumpy rock about the size of the other volumes, with some of its points inside it
+	std::vector<Vector3> BuildRock() {
+		std::mt19937 random(4321);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> bump(0.8f, 1.0f);
+
+		std::vector<Vector3> points;
+		while (points.size() < 96) {
+			Vector3 p(coord(random), coord(random), coord(random));
+			if (p.LengthSquared() < 0.01f) {
+				continue;
+			}
+			points.push_back(p.Normalised() * bump(random) * Vector3(1.0f, 0.75f, 0.6f));
+		}
+		return points;
+	}
+}
+
+void NCL::CSC8503::NarrowphaseBenchmark(const NarrowphaseSettings& settings) {
+	SphereVolume	sphere(1.0f);
+	AABBVolume		aabb(Vector3(1.0f, 0.75f, 0.5f));
+	OBBVolume		obb(Vector3(1.0f, 0.75f, 0.5f));
+	CapsuleVolume	capsule(1.5f, 0.5f);
+	ConvexHullVolume hull(BuildRock());
+	const CollisionVolume* volumes[VolumeCount] = { (CollisionVolume*)&sphere, (CollisionVolume*)&aabb, (CollisionVolume*)&obb, (CollisionVolume*)&capsule, &hull };
+
+	std::vector<PairPose> poses = BuildPoses(settings);
+
+	//Returns ns per pair, with hits set to how many of the pairs touched
+	auto timePairs = [&](auto test, int& hits) {
+		CollisionDetection::CollisionInfo info;
+		GameTimer timer;
+		for (int r = 0; r < settings.repeats; ++r) {
+			hits = 0;
+			for (const PairPose& p : poses) {
+				if (test(p, info)) {
+					hits++;
+				}
+			}
+		}
+		timer.Tick();
+		return timer.GetTimeDeltaMSec() * 1000000.0 / ((double)settings.pairs * settings.repeats);
+	};
+
+	std::cout << "Narrowphase benchmark: " << settings.pairs << " pairs, " << settings.repeats << " repeats\n";
+	for (int a = 0; a < VolumeCount; ++a) {
+		for (int b = 0; b < VolumeCount; ++b) {
+			const CollisionVolume& volumeA = *volumes[a];
+			const CollisionVolume& volumeB = *volumes[b];
+
+			int hits = 0;
+			double nsPerPair = timePairs([&](const PairPose& p, CollisionDetection::CollisionInfo& info) {
+				return CollisionDetection::VolumeIntersection(volumeA, p.a, volumeB, p.b, info);
+			}, hits);
+			std::cout << VolumeNames[a] << " / " << VolumeNames[b] << ": " << nsPerPair << "ns per pair, "
+				<< hits << " hits";
+
+			//The old versions of the tests that have been rewritten, for comparison
+			if (NarrowphaseReference::HasTest(volumeA.type, volumeB.type)) {
+				int oldHits = 0;
+				double oldNsPerPair = timePairs([&](const PairPose& p, CollisionDetection::CollisionInfo& info) {
+					return NarrowphaseReference::Intersection(volumeA, p.a, volumeB, p.b, info);
+				}, oldHits);
+				std::cout << " (old test: " << oldNsPerPair << "ns per pair, " << oldHits << " hits, "
+					<< oldNsPerPair / nsPerPair << "x slower)";
+			}
+			std::cout << "\n";
+		}
+	}
+
+	//Hulls again, each pair keeping a GJK cache as the physics system would - with the
+	//poses unchanged between repeats, this is the best case of objects resting on each other
+	{
+		std::vector<GJKCache> caches(poses.size());
+		CollisionDetection::CollisionInfo info;
+		int hits = 0;
+
+		GameTimer timer;
+		for (int r = 0; r < settings.repeats; ++r) {
+			hits = 0;
+			for (size_t i = 0; i < poses.size(); ++i) {
+				info.convexCache = &caches[i];
+				if (CollisionDetection::VolumeIntersection(hull, poses[i].a, hull, poses[i].b, info)) {
+					hits++;
+				}
+			}
+		}
+		timer.Tick();
+		double nsPerPair = timer.GetTimeDeltaMSec() * 1000000.0 / ((double)settings.pairs * settings.repeats);
+		std::cout << "Hull / Hull cached: " << nsPerPair << "ns per pair, " << hits << " hits\n";
+	}
+
+	//The same sphere and AABB pairs again, through the narrowphase's batches
+	SpherePairBatch spheres;
+	AABBPairBatch	boxes;
+	for (const PairPose& p : poses) {
+		spheres.Add(p.a.GetPosition(), sphere.GetRadius(), p.b.GetPosition(), sphere.GetRadius());
+		boxes.Add(p.a.GetPosition(), aabb.GetHalfDimensions(), p.b.GetPosition(), aabb.GetHalfDimensions());
+	}
+	auto timeBatch = [&](const char* name, auto& batch) {
+		int hits = 0;
+		GameTimer timer;
+		for (int r = 0; r < settings.repeats; ++r) {
+			hits = batch.Test();
+		}
+		timer.Tick();
+		double seconds = timer.GetTimeDeltaSeconds();
+		double pairs = (double)settings.pairs * settings.repeats;
+		std::cout << name << " batched: " << seconds * 1000000000.0 / pairs << "ns per pair ("
+			<< pairs / seconds / 1000000.0 << " million pairs/s), " << hits << " hits\n";
+	};
+	timeBatch("Sphere / Sphere", spheres);
+	timeBatch("AABB / AABB", boxes);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		struct NarrowphaseSettings {
+			int		pairs		= 4096;
+			int		repeats		= 200;
+			float	spread		= 2.5f;	//How far apart the pairs are placed, relative to their size
+		};
+
+		/*
+		Times CollisionDetection::VolumeIntersection on its own, for every
+		ordered pair of sphere, AABB, OBB, capsule and convex hull, against the same set
+		of randomly placed and rotated pairs - roughly half of which touch.
+		Pairs whose tests have been rewritten are timed through the old
+		versions too (see NarrowphaseReference), so the two can be compared.
+		*/
+		void NarrowphaseBenchmark(const NarrowphaseSettings& settings);
+	}
+}
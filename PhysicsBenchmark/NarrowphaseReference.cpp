@@ -0,0 +1,256 @@
+#include "NarrowphaseReference.h"
+#include <cfloat>
+#include <limits>
+
+using namespace NCL;
+using namespace CSC8503;
+
+typedef CollisionDetection::CollisionInfo CollisionInfo;
+
+namespace {
+	Vector3 SpherePosFromCapsule(const CapsuleVolume& capsule, const Transform& capTransform, const Vector3& otherObjPos) {
+		Vector3 extentPosition = capTransform.GetOrientation() * Vector3(0, 1, 0) * (capsule.GetHalfHeight() - capsule.GetRadius());
+		Vector3 capTop(capTransform.GetPosition() + extentPosition);
+		Vector3 capBottom(capTransform.GetPosition() - extentPosition);
+
+		Vector3 capsuleDir = capTop - capBottom;
+		float capLineLength = capsuleDir.Length();
+		capsuleDir.Normalise();
+
+		Vector3 pointCapDir = otherObjPos - capBottom;
+		float dot = Maths::Clamp(Vector3::Dot(pointCapDir, capsuleDir), 0.0f, capLineLength);
+
+		return capBottom + (capsuleDir * dot);
+	}
+
+	std::vector<Vector3> GetEdgeNormals(const Quaternion& orientationA, const Quaternion& orientationB) {
+		std::vector<Vector3> edges;
+
+		edges.push_back(orientationA * Vector3(1, 0, 0));
+		edges.push_back(orientationA * Vector3(0, 1, 0));
+		edges.push_back(orientationA * Vector3(0, 0, 1));
+
+		edges.push_back(orientationB * Vector3(1, 0, 0));
+		edges.push_back(orientationB * Vector3(0, 1, 0));
+		edges.push_back(orientationB * Vector3(0, 0, 1));
+
+		for (int j = 0; j < 3; ++j) {
+			for (int k = 3; k < 6; ++k) {
+				edges.push_back(Vector3::Cross(edges[j], edges[k]).Normalised());
+			}
+		}
+		return edges;
+	}
+
+	std::vector<Vector3> GetOBBVertices(const Vector3& halfDimensions, const Vector3& position, const Quaternion& orientation) {
+		std::vector<Vector3> vertices;
+
+		vertices.push_back(Vector3(-halfDimensions.x, -halfDimensions.y, -halfDimensions.z));
+		vertices.push_back(Vector3(halfDimensions.x, -halfDimensions.y, -halfDimensions.z));
+		vertices.push_back(Vector3(halfDimensions.x, halfDimensions.y, -halfDimensions.z));
+		vertices.push_back(Vector3(-halfDimensions.x, halfDimensions.y, -halfDimensions.z));
+		vertices.push_back(Vector3(-halfDimensions.x, -halfDimensions.y, halfDimensions.z));
+		vertices.push_back(Vector3(halfDimensions.x, -halfDimensions.y, halfDimensions.z));
+		vertices.push_back(Vector3(halfDimensions.x, halfDimensions.y, halfDimensions.z));
+		vertices.push_back(Vector3(-halfDimensions.x, halfDimensions.y, halfDimensions.z));
+
+		for (int i = 0; i < 8; i++) {
+			vertices[i] = orientation * vertices[i];
+		}
+		for (int i = 0; i < 8; i++) {
+			vertices[i] += position;
+		}
+		return vertices;
+	}
+
+	bool OBBIntersection(const Vector3& halfSizeA, const Transform& worldTransformA,
+		const Vector3& halfSizeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		std::vector<Vector3> volumeAVertices = GetOBBVertices(halfSizeA, worldTransformA.GetPosition(), worldTransformA.GetOrientation());
+		std::vector<Vector3> volumeBVertices = GetOBBVertices(halfSizeB, worldTransformB.GetPosition(), worldTransformB.GetOrientation());
+
+		std::vector<Vector3> edgeNormals = GetEdgeNormals(worldTransformA.GetOrientation(), worldTransformB.GetOrientation());
+
+		Vector3 overlapAxis;
+		float overlapMagnitude = FLT_MAX;
+
+		for (int i = 0; i < 15; i++) {
+			if (edgeNormals[i] == Vector3(0, 0, 0))
+				continue;
+			float minA = FLT_MAX;
+			float maxA = std::numeric_limits<float>::lowest();
+
+			float minB = FLT_MAX;
+			float maxB = std::numeric_limits<float>::lowest();
+
+			for (int j = 0; j < 8; j++) {
+				float projA = Vector3::Dot(edgeNormals[i], volumeAVertices[j]) / edgeNormals[i].Length();
+				float projB = Vector3::Dot(edgeNormals[i], volumeBVertices[j]) / edgeNormals[i].Length();
+
+				minA = std::min(projA, minA);
+				maxA = std::max(projA, maxA);
+
+				minB = std::min(projB, minB);
+				maxB = std::max(projB, maxB);
+			}
+
+			bool isOverlaping = (minA <= minB && minB <= maxA) || (minB <= minA && minA <= maxB);
+			if (!isOverlaping) {
+				return false;
+			}
+			if (std::min(maxB, maxA) - std::max(minB, minA) < overlapMagnitude) {
+				overlapMagnitude = std::min(maxB, maxA) - std::max(minB, minA);
+				overlapAxis = edgeNormals[i];
+			}
+		}
+
+		collisionInfo.AddContactPoint(Vector3(), Vector3(), overlapAxis, overlapMagnitude);
+		return true;
+	}
+
+	bool AABBToOBBIntersection(const OBBVolume& volumeA, const Transform& worldTransformA, const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		Transform tempTransform = worldTransformB;
+		tempTransform.SetPosition(worldTransformB.GetPosition());
+		tempTransform.SetOrientation(Quaternion(0.0f, 0.0f, 0.0f, 1.0f));
+		tempTransform.SetScale(worldTransformB.GetScale());
+
+		bool tempCollided = OBBIntersection(volumeA.GetHalfDimensions(), worldTransformA, volumeB.GetHalfDimensions(), tempTransform, collisionInfo);
+		if (tempCollided) {
+			collisionInfo.point.normal = -collisionInfo.point.normal;
+		}
+		return tempCollided;
+	}
+
+	bool SphereIntersection(const SphereVolume& volumeA, const Transform& worldTransformA,
+		const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		float radii = volumeA.GetRadius() + volumeB.GetRadius();
+		Vector3 delta = worldTransformB.GetPosition() - worldTransformA.GetPosition();
+
+		float deltaLength = delta.Length();
+		if (deltaLength < radii) {
+			float penetration = (radii - deltaLength);
+			Vector3 normal = delta.Normalised();
+			Vector3 localA = normal * volumeA.GetRadius();
+			Vector3 localB = -normal * volumeB.GetRadius();
+
+			collisionInfo.AddContactPoint(localA, localB, normal, penetration);
+			return true;
+		}
+		return false;
+	}
+
+	bool AABBSphereIntersection(const AABBVolume& volumeA, const Transform& worldTransformA,
+		const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		Vector3 boxSize = volumeA.GetHalfDimensions();
+		Vector3 delta = worldTransformB.GetPosition() - worldTransformA.GetPosition();
+
+		Vector3 closestPointOnBox = Maths::Vector3::Clamp(delta, -boxSize, boxSize);
+
+		Vector3 localPoint = delta - closestPointOnBox;
+		float distance = localPoint.Length();
+
+		if (distance < volumeB.GetRadius()) {
+			Vector3 collisionNormal = localPoint.Normalised();
+			float penetration = (volumeB.GetRadius() - distance);
+
+			Vector3 localA = Vector3();
+			Vector3 localB = -collisionNormal * volumeB.GetRadius();
+
+			collisionInfo.AddContactPoint(localA, localB, collisionNormal, penetration);
+			return true;
+		}
+		return false;
+	}
+
+	bool AABBCapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA,
+		const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		Vector3 point = Maths::Vector3::Clamp(worldTransformA.GetPosition(), worldTransformB.GetPosition() - volumeB.GetHalfDimensions(), worldTransformB.GetPosition() + volumeB.GetHalfDimensions());
+
+		SphereVolume sphere(volumeA.GetRadius());
+		Transform sphereTransform;
+		sphereTransform.SetPosition(SpherePosFromCapsule(volumeA, worldTransformA, point));
+		sphereTransform.SetScale(Vector3(1, 1, 1) * volumeA.GetRadius());
+
+		bool collision = AABBSphereIntersection(volumeB, worldTransformB, sphere, sphereTransform, collisionInfo);
+		collisionInfo.point.normal = -collisionInfo.point.normal;
+		collisionInfo.point.localA = collisionInfo.point.localA + (sphereTransform.GetPosition() - worldTransformA.GetPosition());
+		return collision;
+	}
+
+	bool SphereCapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA,
+		const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		SphereVolume sphere(volumeA.GetRadius());
+		Transform sphereTransform;
+		sphereTransform.SetPosition(SpherePosFromCapsule(volumeA, worldTransformA, worldTransformB.GetPosition()));
+		sphereTransform.SetScale(Vector3(1, 1, 1) * volumeA.GetRadius());
+
+		bool collision = SphereIntersection(sphere, sphereTransform, volumeB, worldTransformB, collisionInfo);
+		collisionInfo.point.localA = collisionInfo.point.localA + (sphereTransform.GetPosition() - worldTransformA.GetPosition());
+		return collision;
+	}
+
+	bool CapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA, const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+		Vector3 halfDimensionsB(volumeB.GetRadius(), volumeB.GetHalfHeight() + volumeB.GetRadius(), volumeB.GetRadius());
+		AABBVolume aabbB(halfDimensionsB);
+
+		if (!AABBCapsuleIntersection(volumeA, worldTransformA, aabbB, worldTransformB, collisionInfo)) {
+			return false;
+		}
+		SphereVolume sphereA(volumeA.GetRadius());
+		Transform sphereTransformA;
+		sphereTransformA.SetPosition(SpherePosFromCapsule(volumeA, worldTransformA, worldTransformB.GetPosition()));
+		sphereTransformA.SetScale(Vector3(1, 1, 1) * volumeA.GetRadius());
+
+		SphereVolume sphereB(volumeB.GetRadius());
+		Transform sphereTransformB;
+		sphereTransformB.SetPosition(SpherePosFromCapsule(volumeB, worldTransformB, worldTransformA.GetPosition()));
+		sphereTransformB.SetScale(Vector3(1, 1, 1) * volumeB.GetRadius());
+
+		bool sphereCollision = SphereIntersection(sphereA, sphereTransformA, sphereB, sphereTransformB, collisionInfo);
+		collisionInfo.point.localA = collisionInfo.point.localA + (sphereTransformA.GetPosition() - worldTransformA.GetPosition());
+		collisionInfo.point.localB = collisionInfo.point.localB + (sphereTransformB.GetPosition() - worldTransformB.GetPosition());
+		return sphereCollision;
+	}
+}
+
+bool NarrowphaseReference::HasTest(VolumeType a, VolumeType b) {
+	auto is = [&](VolumeType x, VolumeType y) {
+		return (a == x && b == y) || (a == y && b == x);
+	};
+	return is(VolumeType::OBB, VolumeType::OBB) || is(VolumeType::OBB, VolumeType::AABB)
+		|| is(VolumeType::Capsule, VolumeType::Capsule) || is(VolumeType::Capsule, VolumeType::Sphere)
+		|| is(VolumeType::Capsule, VolumeType::AABB);
+}
+
+//Pairs the other way round are swapped, as the old VolumeIntersection did
+bool NarrowphaseReference::Intersection(const CollisionVolume& volumeA, const Transform& transformA,
+	const CollisionVolume& volumeB, const Transform& transformB, CollisionInfo& collisionInfo) {
+	collisionInfo.pointCount = 0;
+	VolumeType a = volumeA.type;
+	VolumeType b = volumeB.type;
+
+	if (a == VolumeType::OBB && b == VolumeType::OBB) {
+		return OBBIntersection(((const OBBVolume&)volumeA).GetHalfDimensions(), transformA, ((const OBBVolume&)volumeB).GetHalfDimensions(), transformB, collisionInfo);
+	}
+	if (a == VolumeType::OBB && b == VolumeType::AABB) {
+		return AABBToOBBIntersection((const OBBVolume&)volumeA, transformA, (const AABBVolume&)volumeB, transformB, collisionInfo);
+	}
+	if (a == VolumeType::AABB && b == VolumeType::OBB) {
+		return AABBToOBBIntersection((const OBBVolume&)volumeB, transformB, (const AABBVolume&)volumeA, transformA, collisionInfo);
+	}
+	if (a == VolumeType::Capsule && b == VolumeType::Capsule) {
+		return CapsuleIntersection((const CapsuleVolume&)volumeA, transformA, (const CapsuleVolume&)volumeB, transformB, collisionInfo);
+	}
+	if (a == VolumeType::Capsule && b == VolumeType::Sphere) {
+		return SphereCapsuleIntersection((const CapsuleVolume&)volumeA, transformA, (const SphereVolume&)volumeB, transformB, collisionInfo);
+	}
+	if (a == VolumeType::Sphere && b == VolumeType::Capsule) {
+		return SphereCapsuleIntersection((const CapsuleVolume&)volumeB, transformB, (const SphereVolume&)volumeA, transformA, collisionInfo);
+	}
+	if (a == VolumeType::Capsule && b == VolumeType::AABB) {
+		return AABBCapsuleIntersection((const CapsuleVolume&)volumeA, transformA, (const AABBVolume&)volumeB, transformB, collisionInfo);
+	}
+	if (a == VolumeType::AABB && b == VolumeType::Capsule) {
+		return AABBCapsuleIntersection((const CapsuleVolume&)volumeB, transformB, (const AABBVolume&)volumeA, transformA, collisionInfo);
+	}
+	return false;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "CollisionDetection.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		The box and capsule pair tests as they were before they were made
+		allocation free - the SAT projects every corner of both boxes onto
+		axes kept in std::vectors, and the capsule tests build Transforms for
+		the spheres standing in for them. They're only kept so the
+		narrowphase benchmark can time the old and new tests side by side.
+
+		Capsule/capsule isn't the same test any more, so expect its hit
+		counts to differ - see CollisionDetection::CapsuleIntersection.
+		*/
+		namespace NarrowphaseReference {
+			//Whether there's an old version of the test for this ordered pair
+			bool HasTest(VolumeType a, VolumeType b);
+
+			bool Intersection(const CollisionVolume& volumeA, const Transform& transformA,
+				const CollisionVolume& volumeB, const Transform& transformB, CollisionDetection::CollisionInfo& collisionInfo);
+		}
+	}
+}
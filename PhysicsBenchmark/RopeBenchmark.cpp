@@ -0,0 +1,148 @@
+#include "RopeBenchmark.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "PositionConstraint.h"
+#include "ConstraintSolver.h"
+#include "ThreadPool.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	enum class RopeSolver {
+		Serial,
+		Coloured,
+		ColouredThreaded
+	};
+
+	const char* GetRopeSolverName(RopeSolver type) {
+		switch (type) {
+			case RopeSolver::Serial:			return "Serial constraint list";
+			case RopeSolver::Coloured:			return "Coloured, one thread";
+			case RopeSolver::ColouredThreaded:	return "Coloured, thread pool";
+		}
+		return "Unknown";
+	}
+
+	std::vector<GameObject*> BuildRopes(GameWorld& world, const RopeSettings& settings) {
+		std::vector<GameObject*> nodes;
+		for (int r = 0; r < settings.ropes; ++r) {
+			GameObject* previous = nullptr;
+			for (int i = 0; i <= settings.links; ++i) {
+				GameObject* node = new GameObject("RopeNode");
+				node->GetTransform().SetPosition(Vector3(i * settings.linkLength, 0.0f, r * 2.0f));
+				node->SetPhysicsObject(new PhysicsObject(&node->GetTransform(), nullptr));
+				node->GetPhysicsObject()->SetInverseMass(i == 0 ? 0.0f : 1.0f);
+				world.AddGameObject(node);
+				nodes.push_back(node);
+
+				if (previous) {
+					world.AddConstraint(new PositionConstraint(previous, node, settings.linkLength));
+				}
+				previous = node;
+			}
+		}
+		return nodes;
+	}
+
+	//Puts the ropes back where they started, so every solver gets the same run
+	void ResetRopes(const std::vector<GameObject*>& nodes, const RopeSettings& settings) {
+		int nodesPerRope = settings.links + 1;
+		for (int n = 0; n < (int)nodes.size(); ++n) {
+			int i = n % nodesPerRope;
+			int r = n / nodesPerRope;
+			nodes[n]->GetTransform().SetPosition(Vector3(i * settings.linkLength, 0.0f, r * 2.0f));
+			nodes[n]->GetPhysicsObject()->SetLinearVelocity(Vector3());
+		}
+	}
+
+	//How far the worst link has been stretched past its length
+	float GetMaxStretch(const GameWorld& world) {
+		std::vector<Constraint*>::const_iterator first;
+		std::vector<Constraint*>::const_iterator last;
+		world.GetConstraintIterators(first, last);
+
+		float maxStretch = 0.0f;
+		for (auto i = first; i != last; ++i) {
+			PositionConstraint* c = (PositionConstraint*)(*i);
+			GameObject* a;
+			GameObject* b;
+			c->GetConstrainedObjects(a, b);
+			float length = (a->GetTransform().GetPosition() - b->GetTransform().GetPosition()).Length();
+			maxStretch = std::max(maxStretch, length - c->GetDistance());
+		}
+		return maxStretch;
+	}
+
+	void RunRopes(GameWorld& world, const std::vector<GameObject*>& nodes, const RopeSettings& settings,
+		RopeSolver type, ConstraintSolver& solver, ThreadPool& pool) {
+		ResetRopes(nodes, settings);
+
+		std::vector<Constraint*>::const_iterator first;
+		std::vector<Constraint*>::const_iterator last;
+		world.GetConstraintIterators(first, last);
+
+		const Vector3 gravity(0.0f, -9.8f, 0.0f);
+		float constraintDt	= settings.dt / settings.iterations;
+		double solveTime	= 0.0;
+
+		for (int s = 0; s < settings.steps; ++s) {
+			for (GameObject* n : nodes) {
+				PhysicsObject* object = n->GetPhysicsObject();
+				if (object->GetInverseMass() > 0.0f) {
+					object->SetLinearVelocity(object->GetLinearVelocity() + gravity * settings.dt);
+				}
+			}
+
+			GameTimer timer;
+			if (type == RopeSolver::Serial) {
+				for (int i = 0; i < settings.iterations; ++i) {
+					for (auto c = first; c != last; ++c) {
+						(*c)->UpdateConstraint(constraintDt);
+					}
+				}
+			}
+			else {
+				solver.Gather();
+				for (int i = 0; i < settings.iterations; ++i) {
+					solver.SolveIteration(constraintDt, type == RopeSolver::ColouredThreaded ? &pool : nullptr);
+				}
+				solver.Scatter();
+			}
+			timer.Tick();
+			solveTime += timer.GetTimeDeltaMSec();
+
+			for (GameObject* n : nodes) {
+				Transform& transform = n->GetTransform();
+				transform.SetPosition(transform.GetPosition() + n->GetPhysicsObject()->GetLinearVelocity() * settings.dt);
+			}
+		}
+		std::cout << GetRopeSolverName(type) << ": " << solveTime / settings.steps << "ms per step, max stretch "
+			<< GetMaxStretch(world) << "\n";
+	}
+}
+
+void NCL::CSC8503::RopeBenchmark(const RopeSettings& settings) {
+	GameWorld world;
+	std::vector<GameObject*> nodes = BuildRopes(world, settings);
+
+	std::vector<Constraint*>::const_iterator first;
+	std::vector<Constraint*>::const_iterator last;
+	world.GetConstraintIterators(first, last);
+
+	ThreadPool			pool;
+	ConstraintSolver	solver;
+	solver.Build(first, last, world.GetConstraintStateID());
+
+	std::cout << "Rope benchmark: " << settings.ropes << " rope(s) of " << settings.links << " links, "
+		<< settings.steps << " steps of " << settings.iterations << " iterations\n";
+	std::cout << solver.GetLinkCount() << " links in " << solver.GetColourCount() << " colours, "
+		<< pool.GetThreadCount() << " threads\n";
+
+	RunRopes(world, nodes, settings, RopeSolver::Serial,			solver, pool);
+	RunRopes(world, nodes, settings, RopeSolver::Coloured,			solver, pool);
+	RunRopes(world, nodes, settings, RopeSolver::ColouredThreaded,	solver, pool);
+
+	world.ClearAndErase();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace NCL {
+	namespace CSC8503 {
+		struct RopeSettings {
+			int		links		= 10000;
+			int		ropes		= 1;
+			int		steps		= 60;
+			int		iterations	= 10;
+			float	linkLength	= 0.5f;
+			float	dt			= 1.0f / 120.0f;
+		};
+
+		/*
+		Hangs ropes of PositionConstraints from a fixed anchor and times
+		solving them through the serial Constraint list against the coloured
+		ConstraintSolver, on one thread and across the worker pool.
+		*/
+		void RopeBenchmark(const RopeSettings& settings);
+	}
+}
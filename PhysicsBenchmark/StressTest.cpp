@@ -0,0 +1,317 @@
+#include "StressTest.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "PositionConstraint.h"
+#include "NavigationGrid.h"
+#include "AABBVolume.h"
+#include "SphereVolume.h"
+#include "GridCollisionVolume.h"
+
+#include <iomanip>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const unsigned int	SceneSeed	= 8503;
+	const float			AgentForce	= 20.0f;
+
+	//The most memory the process has had resident at once, in megabytes
+	float GetPeakMemoryMB() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return counters.PeakWorkingSetSize / (1024.0f * 1024.0f);
+		}
+		return 0.0f;
+#else
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / 1024.0f; //Linux reports kilobytes
+#endif
+	}
+}
+
+StressTest::StressTest(BroadPhaseType broadPhase) : physics(world, broadPhase), random(SceneSeed) {
+	scene		= StressScene::Spheres;
+	sceneSize	= 0;
+	grid		= nullptr;
+	physics.UseGravity(true);
+}
+
+StressTest::~StressTest() {
+	physics.Clear();
+	world.ClearAndErase();
+	delete grid;
+}
+
+const char* StressTest::GetSceneName(StressScene scene) {
+	switch (scene) {
+		case StressScene::Spheres:		return "Spheres";
+		case StressScene::BrickWalls:	return "BrickWalls";
+		case StressScene::RopeBridges:	return "RopeBridges";
+		case StressScene::Maze:			return "Maze";
+		case StressScene::Count:		break;
+	}
+	return "Unknown";
+}
+
+void StressTest::BuildScene(StressScene s, int size) {
+	scene		= s;
+	sceneSize	= size;
+	switch (scene) {
+		case StressScene::Spheres:		BuildSpheres(size);		break;
+		case StressScene::BrickWalls:	BuildBrickWalls(size);	break;
+		case StressScene::RopeBridges:	BuildRopeBridges(size);	break;
+		case StressScene::Maze:			BuildMaze(size);		break;
+		case StressScene::Count:		break;
+	}
+}
+
+GameObject* StressTest::AddStaticCube(const Vector3& position, const Vector3& halfSize) {
+	GameObject* cube = AddCube(position, halfSize, 0.0f);
+	cube->SetStaticGeometry(true);
+	return cube;
+}
+
+GameObject* StressTest::AddSphere(const Vector3& position, float radius, float inverseMass) {
+	GameObject* sphere = new GameObject("Sphere");
+
+	SphereVolume* volume = new SphereVolume(radius);
+	sphere->SetBoundingVolume((CollisionVolume*)volume);
+
+	sphere->GetTransform()
+		.SetScale(Vector3(radius, radius, radius))
+		.SetPosition(position);
+
+	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
+	sphere->GetPhysicsObject()->InitSphereInertia();
+
+	world.AddGameObject(sphere);
+	return sphere;
+}
+
+GameObject* StressTest::AddCube(const Vector3& position, const Vector3& halfSize, float inverseMass) {
+	GameObject* cube = new GameObject("Cube");
+
+	AABBVolume* volume = new AABBVolume(halfSize);
+	cube->SetBoundingVolume((CollisionVolume*)volume);
+
+	cube->GetTransform()
+		.SetPosition(position)
+		.SetScale(halfSize * 2);
+
+	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
+	cube->GetPhysicsObject()->InitCubeInertia();
+
+	world.AddGameObject(cube);
+	return cube;
+}
+
+//A loose block of spheres, jittered a little so they don't just stack up
+void StressTest::BuildSpheres(int count) {
+	const float spacing = 3.0f;
+	int side = (int)std::ceil(std::cbrt((float)count));
+	std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+	for (int i = 0; i < count; ++i) {
+		int x = i % side;
+		int z = (i / side) % side;
+		int y = i / (side * side);
+		Vector3 position(x * spacing + jitter(random), 5.0f + y * spacing, z * spacing + jitter(random));
+		AddSphere(position, 1.0f, 1.0f);
+	}
+	float floorSize = side * spacing + 20.0f;
+	AddStaticCube(Vector3(side * spacing * 0.5f, -2, side * spacing * 0.5f), Vector3(floorSize, 2, floorSize));
+}
+
+//Running bond walls, each 10 bricks wide and 10 high
+void StressTest::BuildBrickWalls(int walls) {
+	const Vector3	brickSize(1.0f, 0.5f, 0.5f);
+	const int		width	= 10;
+	const int		height	= 10;
+	const float		gap		= 6.0f;
+
+	for (int w = 0; w < walls; ++w) {
+		for (int y = 0; y < height; ++y) {
+			float rowOffset = (y % 2) ? brickSize.x : 0.0f;
+			for (int x = 0; x < width; ++x) {
+				Vector3 position(x * brickSize.x * 2 + rowOffset, brickSize.y + y * brickSize.y * 2, w * gap);
+				AddCube(position, brickSize, 1.0f);
+			}
+		}
+	}
+	float floorSize = std::max(50.0f, walls * gap);
+	AddStaticCube(Vector3(width, -2, walls * gap * 0.5f), Vector3(floorSize, 2, floorSize));
+}
+
+//Planks held up by PositionConstraints between two fixed posts, like
+//TutorialGame::BridgeConstraintTest, with a few spheres dropped onto each
+void StressTest::BuildRopeBridges(int bridges) {
+	const Vector3	plankSize(2.0f, 0.5f, 2.0f);
+	const int		planks		= 20;
+	const float		spacing		= 5.0f;
+	const float		linkLength	= 5.5f;
+	const float		gap			= 15.0f;
+	const int		droppedBalls = 5;
+	std::uniform_real_distribution<float> along(spacing, planks * spacing);
+
+	for (int b = 0; b < bridges; ++b) {
+		Vector3 startPos(0, 20, b * gap);
+
+		GameObject* previous = AddCube(startPos, plankSize, 0.0f);
+		for (int i = 1; i <= planks; ++i) {
+			GameObject* plank = AddCube(startPos + Vector3(i * spacing, 0, 0), plankSize, 1.0f);
+			world.AddConstraint(new PositionConstraint(previous, plank, linkLength));
+			previous = plank;
+		}
+		GameObject* end = AddCube(startPos + Vector3((planks + 1) * spacing, 0, 0), plankSize, 0.0f);
+		world.AddConstraint(new PositionConstraint(previous, end, linkLength));
+
+		for (int i = 0; i < droppedBalls; ++i) {
+			AddSphere(startPos + Vector3(along(random), 10.0f + i * 3.0f, 0), 1.0f, 1.0f);
+		}
+	}
+	float floorSize = std::max(150.0f, bridges * gap);
+	AddStaticCube(Vector3(planks * spacing * 0.5f, -2, bridges * gap * 0.5f), Vector3(floorSize, 2, floorSize));
+}
+
+//The coursework maze, with agents wandering between random open cells
+void StressTest::BuildMaze(int agentCount) {
+	grid = new NavigationGrid("TestGrid1.txt");
+
+	GridNode*	nodes		= grid->GetAllNodes();
+	int			gridWidth	= grid->GetNavGridWidth();
+	int			gridHeight	= grid->GetNavGridHeight();
+	float		nodeSize	= (float)grid->GetNavGridSize();
+	float		halfNode	= nodeSize / 2;
+
+	//The whole maze is one grid collider, rather than a cube per wall
+	GameObject* walls = new GameObject("Walls");
+	GridCollisionVolume* volume = new GridCollisionVolume(*grid, 'x');
+	walls->SetBoundingVolume((CollisionVolume*)volume);
+	walls->GetTransform().SetPosition(volume->GetGridCentre());
+	walls->SetPhysicsObject(new PhysicsObject(&walls->GetTransform(), walls->GetBoundingVolume()));
+	walls->GetPhysicsObject()->SetInverseMass(0.0f);
+	walls->SetStaticGeometry(true);
+	world.AddGameObject(walls);
+
+	for (int y = 0; y < gridHeight; ++y) {
+		for (int x = 0; x < gridWidth; ++x) {
+			GridNode& n = nodes[(gridWidth * y) + x];
+			if ((char)n.type != 'x') {
+				floorPositions.push_back(n.position);
+			}
+		}
+	}
+	//The grid puts its nodes at a fixed height, so the floor goes just under the walls
+	float floorHeight = nodes[0].position.y - halfNode - 2;
+	AddStaticCube(Vector3(gridWidth * halfNode, floorHeight, gridHeight * halfNode), Vector3(gridWidth * nodeSize, 2, gridHeight * nodeSize));
+
+	if (floorPositions.empty()) {
+		return;
+	}
+	std::uniform_real_distribution<float> offset(-halfNode + 1.5f, halfNode - 1.5f);
+	for (int i = 0; i < agentCount; ++i) {
+		int		layer		= i / (int)floorPositions.size();
+		Vector3 position	= floorPositions[i % floorPositions.size()];
+		position += Vector3(offset(random), layer * 2.5f, offset(random));
+
+		MazeAgent agent;
+		agent.object		= AddSphere(position, 1.0f, 1.0f);
+		agent.hasWaypoint	= false;
+		agents.push_back(agent);
+	}
+}
+
+Vector3 StressTest::RandomFloorPosition() {
+	std::uniform_int_distribution<int> pick(0, (int)floorPositions.size() - 1);
+	return floorPositions[pick(random)];
+}
+
+//Agents push themselves towards their next waypoint, and pick somewhere
+//new to go once they run out of path
+void StressTest::UpdateAgents() {
+	for (MazeAgent& agent : agents) {
+		Vector3 position = agent.object->GetTransform().GetPosition();
+		if (!agent.hasWaypoint) {
+			agent.hasWaypoint = agent.path.PopWaypoint(agent.waypoint);
+			if (!agent.hasWaypoint) {
+				agent.path.Clear();
+				grid->FindPath(position, RandomFloorPosition(), agent.path);
+				continue;
+			}
+		}
+		Vector3 direction = agent.waypoint - position;
+		direction.y = 0.0f;
+		if (direction.Length() < 2.0f) {
+			agent.hasWaypoint = false;
+			continue;
+		}
+		agent.object->GetPhysicsObject()->AddForce(direction.Normalised() * AgentForce);
+	}
+}
+
+void StressTest::Run(int steps) {
+	const float	tickTime	= 1.0f / physics.GetTickRate();
+	PhysicsProfiler& profiler = physics.GetProfiler();
+	profiler.Clear();
+
+	double phaseTotals[(int)PhysicsPhase::Count]		= {};
+	double counterTotals[(int)PhysicsCounter::Count]	= {};
+	double physicsTotal = 0.0;
+
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+	int objectCount = (int)(last - first);
+
+	std::vector<Constraint*>::const_iterator firstConstraint;
+	std::vector<Constraint*>::const_iterator lastConstraint;
+	world.GetConstraintIterators(firstConstraint, lastConstraint);
+	int constraintCount = (int)(lastConstraint - firstConstraint);
+
+	GameTimer timer;
+	timer.Tick();
+	for (int s = 0; s < steps; ++s) {
+		UpdateAgents();
+		physics.Update(tickTime); //Exactly one tick's worth of time, so exactly one tick
+
+		const PhysicsFrameProfile& frame = profiler.GetFrame(0);
+		for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+			phaseTotals[p] += frame.phaseTimes[p];
+		}
+		for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+			counterTotals[c] += frame.counters[c];
+		}
+		physicsTotal += frame.totalTime;
+	}
+	timer.Tick();
+	float seconds = timer.GetTimeDeltaSeconds();
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Scene " << GetSceneName(scene) << " (size " << sceneSize << "), "
+		<< PhysicsSystem::GetBroadPhaseName(physics.GetBroadPhaseType()) << " broadphase, "
+		<< steps << " steps at " << physics.GetTickRate() << "Hz\n";
+	std::cout << "  " << objectCount << " objects, " << constraintCount << " constraints\n";
+	std::cout << "  " << seconds << "s, " << (seconds > 0.0f ? steps / seconds : 0.0f) << " steps/sec, "
+		<< physicsTotal / steps << "ms of physics per step\n";
+	for (int p = 0; p < (int)PhysicsPhase::Count; ++p) {
+		std::cout << "    " << std::left << std::setw(24) << PhysicsProfiler::GetPhaseName((PhysicsPhase)p)
+			<< std::right << phaseTotals[p] / steps << "ms\n";
+	}
+	for (int c = 0; c < (int)PhysicsCounter::Count; ++c) {
+		std::cout << "    " << std::left << std::setw(24) << PhysicsProfiler::GetCounterName((PhysicsCounter)c)
+			<< std::right << counterTotals[c] / steps << " per step\n";
+	}
+	std::cout << "  Peak memory " << GetPeakMemoryMB() << "MB\n";
+}
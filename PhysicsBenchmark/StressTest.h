@@ -0,0 +1,70 @@
+#pragma once
+#include <random>
+
+#include "GameWorld.h"
+#include "PhysicsSystem.h"
+#include "NavigationPath.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		class NavigationGrid;
+
+		enum class StressScene {
+			Spheres,		//size spheres dropped into a heap
+			BrickWalls,		//size walls of 100 bricks each
+			RopeBridges,	//size bridges of 20 planks, with spheres dropped on them
+			Maze,			//size agents pathfinding around TestGrid1
+			Count
+		};
+
+		/*
+		Builds one of the stress scenes into its own GameWorld and
+		PhysicsSystem, steps it a fixed number of times, and reports how
+		fast that was and where the time went. Every scene is built from a
+		fixed seed, so two runs of the same scene do the same work.
+		*/
+		class StressTest	{
+		public:
+			StressTest(BroadPhaseType broadPhase);
+			~StressTest();
+
+			void BuildScene(StressScene scene, int size);
+
+			//Steps physics steps times at its own tick rate, and prints a report
+			void Run(int steps);
+
+			static const char* GetSceneName(StressScene scene);
+
+		protected:
+			struct MazeAgent {
+				GameObject*		object;
+				NavigationPath	path;
+				Vector3			waypoint;
+				bool			hasWaypoint;
+			};
+
+			GameObject* AddStaticCube(const Vector3& position, const Vector3& halfSize);
+			GameObject* AddSphere(const Vector3& position, float radius, float inverseMass);
+			GameObject* AddCube(const Vector3& position, const Vector3& halfSize, float inverseMass);
+
+			void BuildSpheres(int count);
+			void BuildBrickWalls(int walls);
+			void BuildRopeBridges(int bridges);
+			void BuildMaze(int agentCount);
+
+			void UpdateAgents();
+			Vector3 RandomFloorPosition();
+
+			StressScene		scene;
+			int				sceneSize;
+
+			GameWorld		world;
+			PhysicsSystem	physics;
+			std::mt19937	random;
+
+			NavigationGrid*			grid;
+			std::vector<Vector3>	floorPositions;
+			std::vector<MazeAgent>	agents;
+		};
+	}
+}
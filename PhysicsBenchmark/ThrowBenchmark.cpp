@@ -0,0 +1,89 @@
+#include "ThrowBenchmark.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include "AABBVolume.h"
+#include "SphereVolume.h"
+#include <random>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const float WallSize	= 20.0f;
+	const float StartX		= -10.0f;
+
+	void BuildWall(GameWorld& world, const ThrowSettings& settings) {
+		GameObject* wall = new GameObject("Wall");
+		Vector3 halfSize(settings.wallThickness, WallSize, WallSize);
+		wall->SetBoundingVolume((CollisionVolume*)new AABBVolume(halfSize));
+		wall->GetTransform().SetScale(halfSize * 2.0f);
+		wall->SetPhysicsObject(new PhysicsObject(&wall->GetTransform(), wall->GetBoundingVolume()));
+		wall->GetPhysicsObject()->SetInverseMass(0.0f);
+		wall->SetStaticGeometry(true);
+		world.AddGameObject(wall);
+	}
+
+	std::vector<GameObject*> BuildThrowables(GameWorld& world, const ThrowSettings& settings, bool continuous) {
+		std::mt19937 random(2024);
+		std::uniform_real_distribution<float> offset(-WallSize * 0.8f, WallSize * 0.8f);
+		std::uniform_real_distribution<float> distance(0.0f, 1.0f);
+
+		std::vector<GameObject*> throwables;
+		for (int i = 0; i < settings.throwables; ++i) {
+			GameObject* sphere = new GameObject("Throwable");
+			sphere->SetBoundingVolume((CollisionVolume*)new SphereVolume(settings.radius));
+			sphere->GetTransform()
+				.SetScale(Vector3(settings.radius, settings.radius, settings.radius))
+				.SetPosition(Vector3(StartX - distance(random) * settings.speed / settings.tickRate, offset(random), offset(random)));
+
+			PhysicsObject* phys = new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume());
+			phys->SetInverseMass(1.0f);
+			phys->InitSphereInertia();
+			phys->SetLinearVelocity(Vector3(settings.speed, 0, 0));
+			phys->SetContinuousCollision(continuous);
+			sphere->SetPhysicsObject(phys);
+
+			world.AddGameObject(sphere);
+			throwables.push_back(sphere);
+		}
+		return throwables;
+	}
+
+	void RunThrows(const ThrowSettings& settings, BroadPhaseType broadPhase, bool continuous) {
+		GameWorld		world;
+		PhysicsSystem	physics(world, broadPhase);
+		physics.SetTickRate(settings.tickRate);
+
+		BuildWall(world, settings);
+		std::vector<GameObject*> throwables = BuildThrowables(world, settings, continuous);
+
+		float tickTime = 1.0f / settings.tickRate;
+		GameTimer timer;
+		for (int s = 0; s < settings.steps; ++s) {
+			physics.Update(tickTime);
+		}
+		timer.Tick();
+
+		int through = 0;
+		for (GameObject* o : throwables) {
+			if (o->GetTransform().GetPosition().x > 0.0f) {
+				through++;
+			}
+		}
+		std::cout << (continuous ? "Continuous collision: " : "Discrete collision:   ")
+			<< through << " of " << settings.throwables << " went through the wall, "
+			<< timer.GetTimeDeltaMSec() / settings.steps << "ms per step\n";
+
+		physics.Clear();
+		world.ClearAndErase();
+	}
+}
+
+void NCL::CSC8503::ThrowBenchmark(const ThrowSettings& settings, BroadPhaseType broadPhase) {
+	std::cout << "Throw benchmark: " << settings.throwables << " spheres of radius " << settings.radius
+		<< " at " << settings.speed << " units/s, " << settings.tickRate << "Hz, wall "
+		<< settings.wallThickness * 2.0f << " thick\n";
+	RunThrows(settings, broadPhase, false);
+	RunThrows(settings, broadPhase, true);
+}
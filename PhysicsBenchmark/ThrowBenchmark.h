@@ -0,0 +1,23 @@
+#pragma once
+#include "PhysicsSystem.h"
+
+namespace NCL {
+	namespace CSC8503 {
+		struct ThrowSettings {
+			int		throwables		= 200;
+			int		steps			= 60;
+			float	tickRate		= 30.0f;
+			float	speed			= 60.0f;
+			float	radius			= 0.25f;
+			float	wallThickness	= 0.1f;	//half of it, like every other half size
+		};
+
+		/*
+		Fires small spheres at a thin static wall, at a tick rate low enough
+		that they'd move several times the wall's thickness in one step, and
+		counts how many end up on the far side - with and without continuous
+		collision for the spheres.
+		*/
+		void ThrowBenchmark(const ThrowSettings& settings, BroadPhaseType broadPhase);
+	}
+}